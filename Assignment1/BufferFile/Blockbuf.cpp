@@ -0,0 +1,147 @@
+/**
+ * @file BufferFile/Blockbuf.cpp
+ * @brief Implementation of the BlockStreamBuf class.
+ * @details Reads and writes a file through one large block in memory; see
+ *          Blockbuf.h.
+ */
+
+#include "Blockbuf.h"
+
+using namespace std;
+
+/**
+ * @brief Constructor.
+ * @param device Unbuffered stream buffer of the open file.
+ * @param blockSize Bytes moved per device read or write.
+ * @post The block is empty and the position is the start of the file.
+ */
+BlockStreamBuf::BlockStreamBuf(streambuf *device, int blockSize)
+    : Device(device), Block(blockSize > 0 ? blockSize : 1), BlockAddr(0)
+{
+}
+
+/**
+ * @brief Destructor.
+ * @post Pending writes are written to the device.
+ */
+BlockStreamBuf::~BlockStreamBuf()
+{
+    FlushWrites();
+}
+
+/**
+ * @brief Returns the current offset in the file.
+ */
+long long BlockStreamBuf::Position() const
+{
+    if (pbase()) return BlockAddr + (pptr() - pbase());
+    if (eback()) return BlockAddr + (gptr() - eback());
+    return BlockAddr;
+}
+
+/**
+ * @brief Writes the pending bytes at their file offset.
+ * @return true if there was nothing to write or the write succeeded.
+ * @post The block is empty and BlockAddr is the current position.
+ */
+bool BlockStreamBuf::FlushWrites()
+{
+    long long pos = Position();
+    bool ok = true;
+    if (pbase() && pptr() > pbase()) {
+        streamsize n = pptr() - pbase();
+        ok = Device->pubseekpos(BlockAddr) != pos_type(off_type(-1)) &&
+             Device->sputn(pbase(), n) == n;
+    }
+    setp(nullptr, nullptr);
+    setg(nullptr, nullptr, nullptr);
+    BlockAddr = pos;
+    return ok;
+}
+
+/**
+ * @brief Refills the block with the aligned block holding the current position.
+ * @return The next character, or eof at the end of the file.
+ */
+BlockStreamBuf::int_type BlockStreamBuf::underflow()
+{
+    if (gptr() && gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if (!FlushWrites()) return traits_type::eof();
+
+    long long pos = BlockAddr;
+    long long size = static_cast<long long>(Block.size());
+    long long aligned = pos - pos % size;
+    if (Device->pubseekpos(aligned) == pos_type(off_type(-1))) return traits_type::eof();
+    streamsize n = Device->sgetn(Block.data(), size);
+    if (n <= pos - aligned) return traits_type::eof();
+
+    BlockAddr = aligned;
+    setg(Block.data(), Block.data() + (pos - aligned), Block.data() + n);
+    return traits_type::to_int_type(*gptr());
+}
+
+/**
+ * @brief Makes room for writes, flushing the block when it is full.
+ * @param c Character to write, or eof to only make room.
+ * @return @p c (not eof), or eof if a write failed.
+ */
+BlockStreamBuf::int_type BlockStreamBuf::overflow(int_type c)
+{
+    if (!pbase() || pptr() == epptr()) {
+        if (!FlushWrites()) return traits_type::eof();
+        // Fill up to the next block boundary, so later flushes are aligned
+        long long size = static_cast<long long>(Block.size());
+        setp(Block.data(), Block.data() + (size - BlockAddr % size));
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+/**
+ * @brief Writes pending bytes to the device.
+ * @return 0 on success, -1 if a write failed.
+ */
+int BlockStreamBuf::sync()
+{
+    if (!FlushWrites()) return -1;
+    return Device->pubsync();
+}
+
+/**
+ * @brief Moves the position; seeking to the current position is free.
+ */
+BlockStreamBuf::pos_type BlockStreamBuf::seekoff(off_type off, ios_base::seekdir way, ios_base::openmode which)
+{
+    if (way == ios_base::cur) {
+        if (off == 0) return pos_type(Position());
+        return seekpos(pos_type(Position() + off), which);
+    }
+    if (way == ios_base::end) {
+        if (!FlushWrites()) return pos_type(off_type(-1));
+        pos_type end = Device->pubseekoff(0, ios_base::end);
+        if (end == pos_type(off_type(-1))) return end;
+        return seekpos(end + off, which);
+    }
+    return seekpos(pos_type(off), which);
+}
+
+/**
+ * @brief Moves the position; a target inside the block in memory needs no
+ *        device access.
+ */
+BlockStreamBuf::pos_type BlockStreamBuf::seekpos(pos_type pos, ios_base::openmode)
+{
+    long long target = static_cast<long long>(pos);
+    if (target < 0) return pos_type(off_type(-1));
+    if (target == Position()) return pos;
+    if (eback() && target >= BlockAddr && target <= BlockAddr + (egptr() - eback())) {
+        setg(eback(), eback() + (target - BlockAddr), egptr());
+        return pos;
+    }
+    if (!FlushWrites()) return pos_type(off_type(-1));
+    BlockAddr = target;
+    return pos;
+}
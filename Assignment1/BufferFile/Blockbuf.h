@@ -0,0 +1,63 @@
+/**
+ * @file Blockbuf.h
+ * @brief Header file for the BlockStreamBuf class.
+ * @details This file declares BlockStreamBuf, the stream buffer BufferFile
+ *          uses in block mode: it reads and writes a file in large chunks so
+ *          that records cost memory copies instead of system calls.
+ */
+
+#ifndef BLOCKBUF_H
+#define BLOCKBUF_H
+
+#include <streambuf>
+#include <vector>
+
+/**
+ * @class BlockStreamBuf
+ * @brief Stream buffer that moves data to and from a device in large blocks.
+ * @details Reads fetch a whole block starting at a block-aligned file offset,
+ *          so the records after the one asked for are already in memory
+ *          (readahead). Writes collect in the block and go out together when
+ *          it fills, when the stream seeks away, or on flush (write combining);
+ *          after the first one they start on block boundaries. The current
+ *          position is kept here, so tellg()/tellp() never reach the device,
+ *          and a seek inside the block in memory costs nothing.
+ *
+ *          The block holds either read data or pending writes, never both:
+ *          reading after writing flushes the writes first.
+ */
+class BlockStreamBuf : public std::streambuf
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param device Unbuffered stream buffer of the open file.
+     * @param blockSize Bytes moved per device read or write.
+     */
+    BlockStreamBuf(std::streambuf *device, int blockSize);
+
+    /**
+     * @brief Destructor.
+     * @post Pending writes are written to the device.
+     */
+    virtual ~BlockStreamBuf();
+
+protected:
+    int_type underflow() override;
+    int_type overflow(int_type c = traits_type::eof()) override;
+    int sync() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir way,
+                     std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override;
+    pos_type seekpos(pos_type pos,
+                     std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) override;
+
+private:
+    std::streambuf *Device;  // file the blocks are read from and written to
+    std::vector<char> Block; // read data or pending writes
+    long long BlockAddr;     // file offset of Block[0]
+
+    long long Position() const; // current offset in the file
+    bool FlushWrites();         // writes pending bytes; leaves the block empty
+};
+
+#endif // BLOCKBUF_H
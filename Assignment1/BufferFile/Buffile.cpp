@@ -11,7 +11,7 @@
 
 #include <iostream>
 #include <fstream>
-#include "..\IOBuffer\Iobuffer.h"
+#include "../IOBuffer/Iobuffer.h"
 #include "Buffile.h"
 
 using namespace std;
@@ -19,14 +19,40 @@ using namespace std;
 /**
  * @brief Constructor
  * @param from Reference to an IOBuffer object to associate with this BufferFile.
+ * @param blockSize Bytes per device read/write, or 0 to read and write
+ *        record by record through the fstream.
  * @post BufferFile is initialized with the provided IOBuffer.
  */
-BufferFile::BufferFile(IOBuffer & from) : Buffer(from) {}
+BufferFile::BufferFile(IOBuffer & from, int blockSize) : Buffer(from), BlockSize(blockSize > 0 ? blockSize : 0) {}
 
 BufferFile::~BufferFile() 
 { 
-    if(File.is_open()) 
-        File.close(); 
+    Close(); 
+}
+
+/**
+ * @brief Returns the stream records are read from and written to.
+ * @return The block stream in block mode, the file otherwise.
+ */
+iostream & BufferFile::Stream()
+{
+    if(BlockStream) 
+        return *BlockStream; 
+    return File; 
+}
+
+/**
+ * @brief Puts a freshly opened file in block mode, if one was asked for.
+ * @pre File was opened unbuffered (see Open() and Create()).
+ * @post Record I/O goes through a BlockStreamBuf over the file.
+ */
+void BufferFile::OpenStream()
+{
+    AtEnd = false; 
+    if(BlockSize == 0) 
+        return; 
+    Block.reset(new BlockStreamBuf(File.rdbuf(), BlockSize)); 
+    BlockStream.reset(new iostream(Block.get())); 
 }
 
 /**
@@ -35,20 +61,23 @@ BufferFile::~BufferFile()
  */
 int BufferFile::Open(const char * filename, std::ios::openmode mode)
 {
-    // Open the file with given mode (add binary)
+    // Open the file with given mode (add binary); in block mode the
+    // BlockStreamBuf does the buffering, so the file itself is unbuffered
+    if (BlockSize > 0) File.rdbuf()->pubsetbuf(nullptr, 0);
     File.open(filename, mode | std::ios::binary);
     if (!File.good()) return 0;
+    OpenStream();
 
     // Ensure both get/put are at start before reading header
-    File.seekg(0, std::ios::beg);
-    File.seekp(0, std::ios::beg);
+    Stream().seekg(0, std::ios::beg);
+    Stream().seekp(0, std::ios::beg);
 
     HeaderSize = ReadHeader();
     if (HeaderSize <= 0) return 0;
 
-    File.seekp(HeaderSize, std::ios::beg);
-    File.seekg(HeaderSize, std::ios::beg);
-    return File.good() ? 1 : 0;
+    Stream().seekp(HeaderSize, std::ios::beg);
+    Stream().seekg(HeaderSize, std::ios::beg);
+    return Stream().good() ? 1 : 0;
 }
 
 /**
@@ -63,8 +92,10 @@ int BufferFile::Create(const char* filename, std::ios::openmode mode)
 {
     if (!(mode & std::ios::out)) return 0;
     // open for output; do not use nonstandard flags like ios::noreplace
+    if (BlockSize > 0) File.rdbuf()->pubsetbuf(nullptr, 0);
     File.open(filename, mode | std::ios::out | std::ios::binary);
     if (!File.good()) { File.close(); return 0; }
+    OpenStream();
     HeaderSize = WriteHeader();
     return HeaderSize != 0;
 }
@@ -72,12 +103,68 @@ int BufferFile::Create(const char* filename, std::ios::openmode mode)
 /**
  * @brief Closes the file if open.
  * @return TRUE if file was successfully closed or was not open, FALSE otherwise.
- * @post File is closed.
+ * @post Records held in the block are written and the file is closed.
  */
 int BufferFile::Close()
 {
-    File.close();
-    return 1;
+    int result = Flush();
+    BlockStream.reset();
+    Block.reset();
+    if (File.is_open()) File.close();
+    return result;
+}
+
+/**
+ * @brief Returns the file address of a record in a fixed-length record file.
+ * @param rrn Relative record number (0 for the first record).
+ * @return HeaderSize + rrn * record size, or -1 if the buffer's records vary
+ *         in length or rrn is negative.
+ */
+int BufferFile::RecordAddress(int rrn) const
+{
+    int recordSize = Buffer.GetRecordSize();
+    if (recordSize <= 0 || rrn < 0) return -1;
+    return HeaderSize + rrn * recordSize;
+}
+
+/**
+ * @brief Reads a record by relative record number.
+ * @param rrn Relative record number.
+ * @return Address of the record read, or -1 if read failed.
+ * @pre The buffer is a fixed-length buffer (see RecordAddress()).
+ * @post Buffer contains the record. In record mode this is one seek and one
+ *       read of the slot; block mode reads the whole block around it.
+ */
+int BufferFile::ReadRRN(int rrn)
+{
+    int recaddr = RecordAddress(rrn);
+    if (recaddr == -1) return -1;
+    return Read(recaddr);
+}
+
+/**
+ * @brief Writes the buffer as record rrn.
+ * @param rrn Relative record number; one past the last record appends.
+ * @return Address of the record written, or -1 if write failed.
+ * @pre The buffer is a fixed-length buffer (see RecordAddress()).
+ */
+int BufferFile::WriteRRN(int rrn)
+{
+    int recaddr = RecordAddress(rrn);
+    if (recaddr == -1) return -1;
+    return Write(recaddr);
+}
+
+/**
+ * @brief Writes out the records held in the block.
+ * @return TRUE if successful (or nothing was held), FALSE otherwise.
+ * @post Every record written or appended so far is in the file.
+ */
+int BufferFile::Flush()
+{
+    if (!BlockStream) return 1;
+    BlockStream->flush();
+    return BlockStream->good() ? 1 : 0;
 }
 
 /**
@@ -88,8 +175,9 @@ int BufferFile::Close()
  */
 int BufferFile::Rewind() 
 { 
-    File.seekg(HeaderSize, ios::beg); 
-    File.seekp(HeaderSize, ios::beg); 
+    AtEnd = false; 
+    Stream().seekg(HeaderSize, ios::beg); 
+    Stream().seekp(HeaderSize, ios::beg); 
     return 1; 
 }
 
@@ -102,10 +190,11 @@ int BufferFile::Rewind()
  */
 int BufferFile::Read(int recaddr) 
 { 
+    AtEnd = false; 
     if(recaddr ==-1) 
-        return Buffer.Read(File); 
+        return Buffer.Read(Stream()); 
     else 
-        return Buffer.DRead(File, recaddr);
+        return Buffer.DRead(Stream(), recaddr);
 }
 
 /**
@@ -117,22 +206,28 @@ int BufferFile::Read(int recaddr)
  */
 int BufferFile::Write(int recaddr) 
 { 
+    AtEnd = false; 
     if(recaddr ==-1) 
-        return Buffer.Write(File); 
+        return Buffer.Write(Stream()); 
     else 
-        return Buffer.DWrite(File, recaddr);
+        return Buffer.DWrite(Stream(), recaddr);
 }
 
 /**
  * @brief Appends the buffer contents to the end of the file.
  * @return Address of the record appended, or -1 if append failed.
  * @pre File is open and buffer is initialized with data.
- * @post Buffer contents are appended to the end of the file.
+ * @post Buffer contents are appended to the end of the file. Back-to-back
+ *       appends stay at the end without seeking, so in block mode they
+ *       collect in the block.
  */
 int BufferFile::Append() 
 { 
-    File.seekp(0, ios::end); 
-    return Buffer.Write(File); 
+    if(!AtEnd) 
+        Stream().seekp(0, ios::end); 
+    int recaddr = Buffer.Write(Stream()); 
+    AtEnd = recaddr != -1; 
+    return recaddr; 
 }
 
 /**
@@ -152,7 +247,7 @@ IOBuffer & BufferFile::GetBuffer()
  */
 int BufferFile::ReadHeader() 
 { 
-    return Buffer.ReadHeader(File); 
+    return Buffer.ReadHeader(Stream()); 
 }
 
 /**
@@ -163,5 +258,5 @@ int BufferFile::ReadHeader()
  */
 int BufferFile::WriteHeader()
 { 
-    return Buffer.WriteHeader(File);
+    return Buffer.WriteHeader(Stream());
 }
\ No newline at end of file
@@ -12,15 +12,25 @@
 
 #include <fstream> 
 #include <iostream> 
+#include <memory>
 using namespace std; 
 
-#include "..\IOBuffer\Iobuffer.h"
+#include "../IOBuffer/Iobuffer.h"
+#include "Blockbuf.h"
 
 /**
  * @class BufferFile
  * @brief Class to handle buffered file operations using an associated IOBuffer.
  * @details This class provides methods to open, create, read, write, append, and manage headers
  *          for files using a specified IOBuffer for buffering data.
+ *
+ *          Given a block size, the file is read and written through a
+ *          BlockStreamBuf: each device read fetches a whole aligned block
+ *          (readahead of blockSize / record size records) and appended records
+ *          collect in memory until the block fills. Sequential Read() and
+ *          Append() then cost a memory copy per record rather than system
+ *          calls. Call Flush() (or Close()) to make appended records visible
+ *          to other readers of the file.
  */
 class BufferFile
 { 
@@ -30,7 +40,7 @@ class BufferFile
     //Each buffered file object has a buffer object which can be used for file I/O
     
     public: 
-        explicit BufferFile(IOBuffer &); //Constructor 
+        explicit BufferFile(IOBuffer &, int blockSize = 0); //Constructor; blockSize > 0 selects block mode
         virtual ~BufferFile(); //Destructure
 
         int Open(const char *filename, std::ios::openmode Mode);
@@ -46,13 +56,25 @@ class BufferFile
             // if recaddr != -1, read the record at that address
         int Write (int recaddr =-1); 
         int Append(); 
+        //Direct access by relative record number (fixed-length buffers only)
+        int RecordAddress(int rrn) const; 
+            //return HeaderSize + rrn * record size, or -1 if records vary in length
+        int ReadRRN(int rrn); //read record rrn with one positioned read
+        int WriteRRN(int rrn); //overwrite (or add, at the end) record rrn
+        int Flush(); //write out records held in the block (block mode)
         IOBuffer &GetBuffer(); 
 
     protected: 
         IOBuffer & Buffer; 
         fstream File; 
         int HeaderSize = 0; //size of header 
+        int BlockSize = 0; //bytes per device read/write in block mode, 0 if off
+        bool AtEnd = false; //position is at end of file after Append()
+        unique_ptr<BlockStreamBuf> Block; //block buffer over File (block mode)
+        unique_ptr<iostream> BlockStream; //stream over Block
         
+        iostream &Stream(); //stream records are read from and written to
+        void OpenStream(); //sets up block mode on a freshly opened File
         int ReadHeader(); 
         int WriteHeader(); 
 
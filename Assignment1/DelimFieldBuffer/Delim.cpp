@@ -11,6 +11,7 @@
 #include "Delim.h"
 #include "../IOBuffer/Iobuffer.h"
 #include<iostream> 
+#include<limits>
 using namespace std;
 
 #define TRUE 1 
@@ -47,15 +48,15 @@ void DelimFieldBuffer::Clear()
  */
 int DelimFieldBuffer:: Pack(const void *field, int size) 
 { 
-    short len; 
+    int len; 
     if(size >= 0) len = size; 
     else len = strlen((char*)field); 
-    if(len>(short)strlen((char*)field)) 
+    if(len>(int)strlen((char*)field)) 
         return -1; 
     int start = NextByte; 
-    NextByte += len +1; 
-    if(NextByte > MaxBytes) 
+    if(start + len + 1 > MaxBytes && !Grow(start + len + 1)) 
         return -1;
+    NextByte = start + len + 1; 
     memcpy(&Buffer[start], field, len);
     Buffer[start+len] = Delim;
     BufferSize = NextByte; 
@@ -162,4 +163,52 @@ int DelimFieldBuffer::Unpack(void *field, int maxBytes)
 
     NextByte =i+1; 
     return len;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Finds the next field in the buffer without copying it.
+ * @param field Set to the first byte of the field inside the buffer.
+ * @return Length of the field (without the delimiter), or -1 if error.
+ * @post NextByte is past the field's delimiter. The field is not
+ *       null-terminated and stays valid until the buffer is read again.
+ */
+int DelimFieldBuffer::UnpackView(const char *&field)
+{
+    if(NextByte >= BufferSize)
+        return -1;
+    const char *start = &Buffer[NextByte];
+    const void *end = memchr(start, Delim, BufferSize - NextByte);
+    if(!end)
+        return -1;
+    int len = (const char*)end - start;
+    field = start;
+    NextByte += len + 1;
+    return len;
+}
+
+/**
+ * @brief Reads one text line from a stream straight into the buffer.
+ * @param stream Input stream positioned at the start of a line.
+ * @return Number of bytes in the line, or -1 at end of file.
+ * @post The line (without its line break) is in the buffer, ended by the
+ *       delimiter, so its last field unpacks like the others. A line longer
+ *       than the buffer is cut short and the rest of it skipped.
+ */
+int DelimFieldBuffer::ReadLine(istream & stream)
+{
+    Clear();
+    if(!stream.getline(Buffer, MaxBytes - 1))
+    {
+        if(stream.gcount() == 0 || stream.bad())
+            return -1;
+        stream.clear(); //line too long: drop the rest of it
+        stream.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+    int len = strlen(Buffer);
+    if(len > 0 && Buffer[len-1] == '\r')
+        len--;
+    Buffer[len] = Delim;
+    BufferSize = len + 1;
+    Packing = FALSE;
+    return len;
+}
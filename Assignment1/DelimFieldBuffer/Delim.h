@@ -34,6 +34,8 @@ class DelimFieldBuffer : public VariableLengthBuffer
         virtual void Clear(); //clear the buffer.
         virtual int Pack(const void *field, int size = -1); //set the value of the next field of the buffer.
         virtual int Unpack(void * field, int maxBytes = -1); //get the value of the next field of the buffer.
+        virtual int UnpackView(const char *&field); //find the next field in place, without copying it.
+        int ReadLine(istream & stream); //read one text line (e.g. a CSV row) as a record.
         virtual void Print(ostream &) const; //print the contents of the buffer.
         virtual int Init(char delim = ','); //initialize the buffer with a specific delimiter.
 
@@ -0,0 +1,152 @@
+/**
+ * @file Fixlen.cpp
+ * @brief Implementation of the FixedLengthBuffer class.
+ * @details This file defines member functions for the FixedLengthBuffer class,
+ *          which stores each record in a slot of the same size so that records
+ *          can be found by number.
+ */
+// FIXLEN.CPP
+// Member function definitions for class FixedLengthBuffer
+//
+// Slot layout (RecordSize bytes):
+//   [packed fields][zero padding][unsigned short bytes used]
+// The length sits at the end so a slot can be read straight into the
+// buffer with the fields already at the start.
+#include <iostream>
+#include <cstring>
+#include "Fixlen.h"
+
+static const int LENGTH_BYTES = sizeof(unsigned short);
+
+/**
+ * @brief Constructor.
+ * @param recordSize Bytes per record slot in the file.
+ * @pre recordSize > 2
+ * @post Buffer holds a whole slot; Pack accepts RecordSize - 2 bytes.
+ */
+FixedLengthBuffer::FixedLengthBuffer(int recordSize)
+    : IOBuffer(recordSize > LENGTH_BYTES ? recordSize : LENGTH_BYTES + 1)
+{
+    if (MaxBytes > 0xFFFF + LENGTH_BYTES) Init(0xFFFF + LENGTH_BYTES); // length must fit in 2 bytes
+    RecordSize = MaxBytes;
+    MaxBytes = RecordSize - LENGTH_BYTES; // leave room for the length
+}
+
+/**
+ * @brief Clears the buffer contents.
+ * @post Buffer is empty
+ */
+void FixedLengthBuffer::Clear()
+{
+    IOBuffer::Clear();
+}
+
+/**
+ * @brief Reads one record slot from an input stream.
+ * @param stream Input stream to read from.
+ * @return Position in stream of the record, or -1 if error.
+ * @details One read of RecordSize bytes; the length is then taken from the
+ *          slot's last two bytes.
+ * @post Buffer contains the record's bytes if successful
+ */
+int FixedLengthBuffer::Read(istream &stream)
+{
+    if (stream.eof()) return -1;
+    int recaddr = stream.tellg();
+    Clear();
+    stream.read(Buffer, RecordSize);
+    if (!stream.good())
+    {
+        stream.clear();
+        return -1;
+    }
+    unsigned short used;
+    memcpy(&used, Buffer + RecordSize - LENGTH_BYTES, LENGTH_BYTES);
+    if (used > MaxBytes) return -1;
+    BufferSize = used;
+    Packing = 0;
+    return recaddr;
+}
+
+/**
+ * @brief Writes the buffer as one record slot.
+ * @param stream Output stream to write to.
+ * @return Position in stream of the record, or -1 if error.
+ * @details Pads the unused bytes with zeros, stores the length in the last two
+ *          bytes, and writes the slot with one call.
+ * @post Buffer is written to stream
+ */
+int FixedLengthBuffer::Write(ostream &stream) const
+{
+    int recaddr = stream.tellp();
+    unsigned short used = GetUsed();
+    memset(Buffer + used, 0, MaxBytes - used);
+    memcpy(Buffer + RecordSize - LENGTH_BYTES, &used, LENGTH_BYTES);
+    stream.write(Buffer, RecordSize);
+    if (!stream.good()) return -1;
+    return recaddr;
+}
+
+// header string and size
+static const char* fixedHeaderStr = "Fixed";
+static const int fixedHeaderSize = strlen(fixedHeaderStr);
+
+/**
+ * @brief Reads the buffer header from a stream.
+ * @param stream Input stream to read from.
+ * @return Stream position after header, or 0 if error.
+ * @pre stream contains a FixedLengthBuffer header
+ * @post Header and record size are verified
+ */
+int FixedLengthBuffer::ReadHeader(istream &stream)
+{
+    char str[16];
+    int result = IOBuffer::ReadHeader(stream);
+    if (result <= 0) return 0;
+    stream.read(str, fixedHeaderSize);
+    if (!stream.good()) return 0;
+    if (strncmp(str, fixedHeaderStr, fixedHeaderSize) != 0) return 0;
+    int recordSize;
+    stream.read((char*)&recordSize, sizeof(recordSize));
+    if (!stream.good() || recordSize != RecordSize) return 0;
+    return stream.tellg();
+}
+
+/**
+ * @brief Writes the buffer header to a stream.
+ * @param stream Output stream to write to.
+ * @return Stream position after writing header, or 0 if error.
+ * @post Stream contains IOBuffer header, "Fixed" and the record size
+ */
+int FixedLengthBuffer::WriteHeader(ostream &stream) const
+{
+    int result = IOBuffer::WriteHeader(stream);
+    if (result <= 0) return 0;
+    stream.write(fixedHeaderStr, fixedHeaderSize);
+    stream.write((const char*)&RecordSize, sizeof(RecordSize));
+    if (!stream.good()) return 0;
+    return stream.tellp();
+}
+
+/**
+ * @brief Prints the buffer contents to an output stream.
+ * @param stream Output stream to print to.
+ */
+void FixedLengthBuffer::Print(ostream &stream) const
+{
+    IOBuffer::Print(stream);
+    stream << " RecordSize=" << RecordSize;
+}
+
+/**
+ * @brief Returns the slot size for records of up to maxRecordBytes packed bytes.
+ * @param maxRecordBytes Longest packed record the file must hold.
+ * @return The smallest power of two (at least 16) that holds the record and its length.
+ */
+int FixedLengthBuffer::LengthClass(int maxRecordBytes)
+{
+    int size = 16;
+    while (size < maxRecordBytes + LENGTH_BYTES && size < (1 << 30))
+        size *= 2;
+    return size;
+}
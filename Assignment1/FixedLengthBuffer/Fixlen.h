@@ -0,0 +1,108 @@
+/**
+ * @file Fixlen.h
+ * @brief Declaration of the FixedLengthBuffer class.
+ * @details This file declares the FixedLengthBuffer class, which extends IOBuffer
+ *          so that every record takes the same number of bytes in a file. Record
+ *          N of such a file starts at HeaderSize + N * record size, so a
+ *          BufferFile can read any record by its relative record number (RRN)
+ *          without an index.
+ */
+//
+// FIXLEN.H
+// Declaration of class FixedLengthBuffer
+//
+// FixedLengthBuffer class:
+//   - Every record is stored in a slot of RecordSize bytes
+//   - A slot holds the packed fields, zero padding, and the number of bytes
+//     used (unsigned short) in its last two bytes
+//   - A slot is read or written with one stream call
+//   - LengthClass() picks slot sizes: records are grouped by the smallest
+//     power of two they fit in, so a file of short records is not sized for
+//     the longest record of some other kind
+//
+// Assumptions:
+//   - Header string "Fixed" followed by the record size (int) identifies the file
+
+#ifndef FIXLEN_H
+#define FIXLEN_H
+
+#include <iostream>
+#include <cstring>
+#include "../IOBuffer/Iobuffer.h"
+
+using namespace std;
+
+/**
+ * @class FixedLengthBuffer
+ * @brief Extends IOBuffer for records stored in fixed-size slots.
+ * @details Pack/Unpack work as in IOBuffer; at most RecordSize - 2 bytes can be
+ *          packed per record.
+ */
+class FixedLengthBuffer : public IOBuffer
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param recordSize Bytes per record slot in the file (3 to 65537).
+     * @post Buffer is initialized and cleared.
+     */
+    FixedLengthBuffer(int recordSize = 128);
+
+    /**
+     * @brief Clears the buffer.
+     * @post Buffer is empty.
+     */
+    void Clear();
+
+    /**
+     * @brief Reads one record slot from an input stream.
+     * @param stream Input stream positioned at a slot.
+     * @return Position in stream of the record, or -1 if error.
+     */
+    int Read(istream &);
+
+    /**
+     * @brief Writes the buffer as one record slot.
+     * @param stream Output stream positioned at a slot.
+     * @return Position in stream of the record, or -1 if error.
+     */
+    int Write(ostream &) const;
+
+    /**
+     * @brief Reads the buffer header and checks its record size.
+     * @param stream Input stream containing the header.
+     * @return Stream position after reading header, or 0 if error
+     *         (including a file with a different record size).
+     */
+    int ReadHeader(istream &);
+
+    /**
+     * @brief Writes the buffer header, including the record size.
+     * @param stream Output stream to write the header.
+     * @return Stream position after writing header, or 0 if error.
+     */
+    int WriteHeader(ostream &) const;
+
+    /**
+     * @brief Returns the bytes every record takes in a file.
+     */
+    int GetRecordSize() const { return RecordSize; }
+
+    /**
+     * @brief Prints the buffer contents to a stream.
+     * @param stream Output stream.
+     */
+    void Print(ostream &) const;
+
+    /**
+     * @brief Returns the slot size for records of up to @p maxRecordBytes packed bytes.
+     * @param maxRecordBytes Longest packed record the file must hold.
+     * @return The smallest power of two (at least 16) holding the record and its length.
+     */
+    static int LengthClass(int maxRecordBytes);
+
+protected:
+    int RecordSize; // bytes per slot, including the 2-byte length
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <climits>
+#include <utility>
 
 #include "Iobuffer.h"
 
@@ -20,9 +22,32 @@
  * @param maxBytes Maximum number of bytes for this buffer (default 10000).
  * @post Buffer is initialized and cleared.
  */
-IOBuffer::IOBuffer(int maxBytes) : Initialized(0), Buffer(nullptr), MaxBytes(0), NextByte(0), BufferSize(0), Packing(1) {
+IOBuffer::IOBuffer(int maxBytes) : Initialized(0), Buffer(nullptr), MaxBytes(0), NextByte(0), BufferSize(0), Packing(1), Growable(0) {
     Init(maxBytes);
 }
+
+/**
+ * @brief Copy constructor.
+ * @param buffer Another IOBuffer to copy from.
+ * @post This buffer has its own memory holding a copy of the used bytes.
+ */
+IOBuffer::IOBuffer(const IOBuffer &buffer)
+    : Initialized(buffer.Initialized), Buffer(new char[buffer.MaxBytes]), MaxBytes(buffer.MaxBytes),
+      NextByte(buffer.NextByte), BufferSize(buffer.BufferSize), Packing(buffer.Packing), Growable(buffer.Growable) {
+    if (BufferSize > 0) memcpy(Buffer, buffer.Buffer, BufferSize);
+}
+
+/**
+ * @brief Move constructor.
+ * @param buffer Buffer whose memory is taken.
+ * @post buffer is left empty with a one-byte buffer.
+ */
+IOBuffer::IOBuffer(IOBuffer &&buffer) noexcept
+    : Initialized(buffer.Initialized), Buffer(buffer.Buffer), MaxBytes(buffer.MaxBytes),
+      NextByte(buffer.NextByte), BufferSize(buffer.BufferSize), Packing(buffer.Packing), Growable(buffer.Growable) {
+    buffer.Buffer = nullptr;
+    buffer.Init(1);
+}
 /**
  * @brief Destructor.
  * @post Buffer is deallocated.
@@ -52,6 +77,47 @@ IOBuffer &IOBuffer::operator=(const IOBuffer &buffer) {
     return *this;
 }
 
+/**
+ * @brief Move assignment: swaps memory with another buffer instead of copying.
+ * @param buffer Buffer whose memory and contents are taken.
+ * @return Reference to this IOBuffer.
+ * @post buffer holds this buffer's old memory, cleared.
+ */
+IOBuffer &IOBuffer::operator=(IOBuffer &&buffer) noexcept {
+    if (this == &buffer) return *this;
+    std::swap(Buffer, buffer.Buffer);
+    std::swap(MaxBytes, buffer.MaxBytes);
+    Initialized = buffer.Initialized;
+    BufferSize = buffer.BufferSize;
+    NextByte = buffer.NextByte;
+    Packing = buffer.Packing;
+    Growable = buffer.Growable;
+    buffer.NextByte = 0;
+    buffer.BufferSize = 0;
+    buffer.Packing = 1;
+    return *this;
+}
+
+/**
+ * @brief Makes room for a number of bytes, if the buffer may grow.
+ * @param needed Bytes the buffer must hold.
+ * @return 1 if the buffer holds needed bytes, 0 if it is full and may not grow.
+ * @post Capacity at least doubles when it grows, so a buffer reused for many
+ *       records reallocates only a few times; the used bytes are kept.
+ */
+int IOBuffer::Grow(int needed) {
+    if (needed <= MaxBytes) return 1;
+    if (!Growable || needed < 0) return 0;
+    int capacity = MaxBytes > 0 ? MaxBytes : 1;
+    while (capacity < needed) capacity = capacity > INT_MAX / 2 ? needed : capacity * 2;
+    char *bigger = new char[capacity];
+    if (BufferSize > 0) memcpy(bigger, Buffer, BufferSize);
+    delete[] Buffer;
+    Buffer = bigger;
+    MaxBytes = capacity;
+    return 1;
+}
+
 /**
  * @brief Clears the buffer.
  * @post Buffer is empty.
@@ -74,7 +140,7 @@ int IOBuffer::Pack(const void *field, int size) {
     const char *f = static_cast<const char *>(field);
     int n = size;
     if (size == -1) n = static_cast<int>(strlen(f)) + 1;
-    if (NextByte + n > MaxBytes) return -1;
+    if (NextByte + n > MaxBytes && !Grow(NextByte + n)) return -1;
     memcpy(Buffer + NextByte, f, n);
     NextByte += n;
     BufferSize = NextByte;
@@ -113,6 +179,24 @@ int IOBuffer::Unpack(void *field, int maxBytes) {
     }
 }
 
+/**
+ * @brief Finds the next field without copying it.
+ * @param field Set to the first byte of the field inside the buffer.
+ * @return Length of the field (without its terminator), or -1 if error.
+ * @post NextByte is past the field. The field stays valid until the buffer
+ *       is read into or packed again.
+ */
+int IOBuffer::UnpackView(const char *&field) {
+    if (NextByte >= BufferSize) return -1;
+    const char *start = Buffer + NextByte;
+    const void *end = memchr(start, '\0', BufferSize - NextByte);
+    if (!end) return -1;
+    int len = static_cast<int>(static_cast<const char *>(end) - start);
+    field = start;
+    NextByte += len + 1;
+    return len;
+}
+
 /**
  * @brief Prints buffer metadata.
  * @param stream Output stream to print to.
@@ -17,12 +17,16 @@
 class IOBuffer {
 public:
     IOBuffer(int maxBytes = 10000);
+    IOBuffer(const IOBuffer &);
+    IOBuffer(IOBuffer &&) noexcept;
     virtual ~IOBuffer();
     IOBuffer &operator=(const IOBuffer &);
+    IOBuffer &operator=(IOBuffer &&) noexcept; // takes the other buffer's memory
 
     virtual void Clear();
     virtual int Pack(const void *field, int size = -1);
     virtual int Unpack(void *field, int maxBytes = -1);
+    virtual int UnpackView(const char *&field); // next field in place, no copy
     virtual void Print(std::ostream &) const;
     virtual int Init(int maxBytes = 10000);
 
@@ -38,6 +42,7 @@ public:
     virtual int WriteHeader(std::ostream &) const;
 
     int GetUsed() const { return BufferSize; }
+    virtual int GetRecordSize() const { return 0; } // bytes per record in a file, 0 if records vary
 
 protected:
     int Initialized;   // non-zero if initialized
@@ -46,4 +51,7 @@ protected:
     int NextByte;      // index of next byte
     int BufferSize;    // used bytes
     int Packing;       // non-zero when packing
+    int Growable;      // non-zero if the buffer may grow past MaxBytes
+
+    int Grow(int needed); // makes room for needed bytes, keeping the contents
 };
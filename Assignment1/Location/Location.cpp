@@ -1,5 +1,7 @@
 #include <iostream>
-#include "location.h"
+#include <cstdlib>
+#include <cstring>
+#include "Location.h"
 #include "../DelimFieldBuffer/Delim.h"   // include the real declaration
 #include "../VariableLengthBuffer/Varlen.h" // include the real declaration
 #include "../IOBuffer/Iobuffer.h"
@@ -52,4 +54,84 @@ void Location::Print(ostream &stream, const char* label) const
            << "\n\tLatitude: " << Latitude
            << "\n\tLongitude: " << Longitude
            << endl;
-}
\ No newline at end of file
+}
+
+LocationView::LocationView() { Clear(); }
+
+void LocationView::Clear()
+{
+    for (int f = 0; f < FIELD_COUNT; f++) { Start[f] = ""; Length[f] = 0; }
+    Lat = Lon = 0;
+    LatDecoded = LonDecoded = false;
+}
+
+int LocationView::Unpack(IOBuffer &Buffer)
+{
+    static const int order[FIELD_COUNT] = { ZIP, PLACE, COUNTY, STATE, LAT, LON };
+    return UnpackFields(Buffer, order);
+}
+
+int LocationView::UnpackCSV(IOBuffer &Buffer)
+{
+    static const int order[FIELD_COUNT] = { ZIP, PLACE, STATE, COUNTY, LAT, LON };
+    return UnpackFields(Buffer, order);
+}
+
+int LocationView::UnpackFields(IOBuffer &Buffer, const int order[FIELD_COUNT])
+{
+    Clear();
+    for (int i = 0; i < FIELD_COUNT; i++)
+        if ((Length[order[i]] = Buffer.UnpackView(Start[order[i]])) == -1) { Clear(); return 0; }
+    return 1;
+}
+
+double LocationView::LatitudeValue() const
+{
+    if (!LatDecoded) { Lat = Decode(Latitude()); LatDecoded = true; }
+    return Lat;
+}
+
+double LocationView::LongitudeValue() const
+{
+    if (!LonDecoded) { Lon = Decode(Longitude()); LonDecoded = true; }
+    return Lon;
+}
+
+// The field is not null-terminated, so atof() gets a short copy
+double LocationView::Decode(string_view text)
+{
+    char number[32];
+    size_t n = text.size() < sizeof(number) - 1 ? text.size() : sizeof(number) - 1;
+    memcpy(number, text.data(), n);
+    number[n] = 0;
+    return atof(number);
+}
+
+// Copies each field like strcpy would, cut to the size of Location's array
+void LocationView::ToLocation(Location &loc) const
+{
+    auto copy = [](char *dst, size_t size, string_view src) {
+        size_t n = src.size() < size - 1 ? src.size() : size - 1;
+        memcpy(dst, src.data(), n);
+        dst[n] = 0;
+    };
+    copy(loc.ZipCode, sizeof(loc.ZipCode), ZipCode());
+    copy(loc.PlaceName, sizeof(loc.PlaceName), PlaceName());
+    copy(loc.County, sizeof(loc.County), County());
+    copy(loc.State, sizeof(loc.State), State());
+    copy(loc.Latitude, sizeof(loc.Latitude), Latitude());
+    copy(loc.Longitude, sizeof(loc.Longitude), Longitude());
+}
+
+void LocationView::Print(ostream &stream, const char* label) const
+{
+    if (!label) stream << "Zip Code Record:";
+    else stream << label;
+    stream << "\n\tZipCode: " << ZipCode()
+           << "\n\tPlace: " << PlaceName()
+           << "\n\tCounty: " << County()
+           << "\n\tState: " << State()
+           << "\n\tLatitude: " << Latitude()
+           << "\n\tLongitude: " << Longitude()
+           << endl;
+}
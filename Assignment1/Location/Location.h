@@ -2,11 +2,8 @@
 #define LOCATION_H
 
 #include <iostream>
-<<<<<<< Updated upstream
-#include "../IOBuffer/IOBuffer.h"
-=======
+#include <string_view>
 #include "../IOBuffer/Iobuffer.h"
->>>>>>> Stashed changes
 #include "../DelimFieldBuffer/Delim.h"   // include the real declaration
 #include "../VariableLengthBuffer/Varlen.h" // include the real declaration
 using namespace std;
@@ -32,4 +29,43 @@ public:
     void Print(ostream &, const char* label = 0) const;
 };
 
+// Read-only view of a Location record that is still in an IOBuffer.
+// Unpack only finds where each field lies in the buffer's bytes; nothing is
+// copied, and the latitude and longitude are converted to numbers the first
+// time they are asked for. The view is valid until the buffer is read into
+// or packed again; ToLocation() copies the fields out when a record must
+// outlive its buffer.
+class LocationView
+{
+public:
+    LocationView();
+    void Clear();
+    int Unpack(IOBuffer &);    // fields in the order Location::Pack writes them
+    int UnpackCSV(IOBuffer &); // fields in CSV column order: zip, place, state, county, lat, lon
+
+    string_view ZipCode() const { return Field(ZIP); }
+    string_view PlaceName() const { return Field(PLACE); }
+    string_view County() const { return Field(COUNTY); }
+    string_view State() const { return Field(STATE); }
+    string_view Latitude() const { return Field(LAT); }
+    string_view Longitude() const { return Field(LON); }
+    double LatitudeValue() const;  // decoded on first use
+    double LongitudeValue() const; // decoded on first use
+
+    void ToLocation(Location &) const;
+    void Print(ostream &, const char* label = 0) const;
+
+private:
+    enum { ZIP, PLACE, COUNTY, STATE, LAT, LON, FIELD_COUNT };
+
+    const char *Start[FIELD_COUNT]; // first byte of each field in the buffer
+    int Length[FIELD_COUNT];        // length of each field
+    mutable double Lat, Lon;        // decoded coordinates
+    mutable bool LatDecoded, LonDecoded;
+
+    string_view Field(int f) const { return string_view(Start[f], Length[f]); }
+    int UnpackFields(IOBuffer &, const int order[FIELD_COUNT]);
+    static double Decode(string_view text);
+};
+
 #endif
\ No newline at end of file
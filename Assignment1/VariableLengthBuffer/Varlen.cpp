@@ -21,10 +21,11 @@
 //
 // Assumptions:
 //   - The underlying IOBuffer handles raw memory allocation
-//   - Buffer length is represented as unsigned short in files
-//   - The header string "Variable" is used for buffer identification
+//   - Record length is a varint in files with header string "VarintLn", and
+//     unsigned short in older files with header string "Variable"
 #include <iostream>
 #include <cstring>
+#include <climits>
 #include "Varlen.h"
 
 /**
@@ -35,8 +36,9 @@
  * @post Buffer is empty and ready for use.
  */
 VariableLengthBuffer::VariableLengthBuffer(int maxBytes)
-    : IOBuffer(maxBytes)
+    : IOBuffer(maxBytes), LegacyLength(0), PartRemaining(0)
 {
+    Growable = 1;
     Init();
 }
 
@@ -51,11 +53,75 @@ void VariableLengthBuffer::Clear()
     IOBuffer::Clear();
 }
 
+/**
+ * @brief Reads a record's length prefix.
+ * @param stream Input stream positioned at a record.
+ * @param length Set to the record length.
+ * @return 1 if successful, 0 otherwise.
+ * @details A varint is read a byte at a time: each byte holds 7 bits of the
+ *          length, low bits first, and its high bit is set when more follow.
+ */
+int VariableLengthBuffer::ReadLength(istream &stream, long long &length)
+{
+    if (LegacyLength)
+    {
+        unsigned short size;
+        stream.read((char*)&size, sizeof(size));
+        length = size;
+        return stream.good() ? 1 : 0;
+    }
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 63; shift += 7)
+    {
+        int byte = stream.get();
+        if (byte == EOF) return 0;
+        value |= (unsigned long long)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            length = (long long)value;
+            return length >= 0 ? 1 : 0;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes a record's length prefix.
+ * @param stream Output stream positioned where the record goes.
+ * @param length Record length.
+ * @return 1 if successful, 0 otherwise (including a length the file's
+ *         format cannot hold).
+ */
+int VariableLengthBuffer::WriteLength(ostream &stream, long long length) const
+{
+    if (length < 0) return 0;
+    if (LegacyLength)
+    {
+        if (length > 0xFFFF) return 0;
+        unsigned short size = (unsigned short)length;
+        stream.write((char*)&size, sizeof(size));
+        return stream.good() ? 1 : 0;
+    }
+    char prefix[10];
+    int n = 0;
+    unsigned long long value = (unsigned long long)length;
+    do
+    {
+        prefix[n] = (char)(value & 0x7F);
+        value >>= 7;
+        if (value) prefix[n] |= (char)0x80;
+        n++;
+    } while (value);
+    stream.write(prefix, n);
+    return stream.good() ? 1 : 0;
+}
+
 /**
  * @brief Reads a record from an input stream.
  * @param stream Input stream to read from.
  * @return Position in stream of the record, or -1 if error.
- * @details Reads the record length (unsigned short) followed by the buffer contents.
+ * @details Reads the record length followed by the buffer contents. The
+ *          buffer grows if the record is larger than any read before.
  * @pre stream is open and positioned at a record
  * @post Buffer contains the record's bytes if successful
  */
@@ -64,19 +130,22 @@ int VariableLengthBuffer::Read(istream &stream)
     if (stream.eof()) return -1;
     int recaddr = stream.tellg();
     Clear();
-    unsigned short bufferSize;
-    stream.read((char*)&bufferSize, sizeof(bufferSize));
-    if (!stream.good())
+    long long length;
+    if (!ReadLength(stream, length))
     {
         stream.clear();
         return -1;
     }
+    if (length > INT_MAX || !Grow((int)length)) return -1;
+    int bufferSize = (int)length;
     stream.read(Buffer, bufferSize);
     if (!stream.good())
     {
         stream.clear();
         return -1;
     }
+    BufferSize = bufferSize;
+    Packing = 0;
     return recaddr;
 }
 
@@ -84,23 +153,97 @@ int VariableLengthBuffer::Read(istream &stream)
  * @brief Writes the buffer to an output stream.
  * @param stream Output stream to write to.
  * @return Position in stream of the record, or -1 if error.
- * @details Writes the buffer length (unsigned short) followed by buffer contents.
+ * @details Writes the buffer length followed by buffer contents.
  * @pre Buffer has been initialized and contains data
  * @post Buffer is written to stream
  */
 int VariableLengthBuffer::Write(ostream &stream) const
 {
     int recaddr = stream.tellp();
-    unsigned short bufferSize = GetUsed(); // use actual size of data
-    stream.write((char*)&bufferSize, sizeof(bufferSize));
-    if (!stream.good()) return -1;
+    int bufferSize = GetUsed(); // use actual size of data
+    if (!WriteLength(stream, bufferSize)) return -1;
     stream.write(Buffer, bufferSize);
     if (!stream.good()) return -1;
     return recaddr;
 }
 
-// header string and size
-const char* headerStr = "Variable";
+/**
+ * @brief Starts writing a record of a known length in parts.
+ * @param stream Output stream to write to.
+ * @param length Total bytes the record's parts will add up to.
+ * @return Position in stream of the record, or -1 if error.
+ * @post The length prefix is written; WritePart() writes the body.
+ */
+int VariableLengthBuffer::WriteBegin(ostream &stream, long long length)
+{
+    int recaddr = stream.tellp();
+    PartRemaining = 0;
+    if (!WriteLength(stream, length)) return -1;
+    PartRemaining = length;
+    return recaddr;
+}
+
+/**
+ * @brief Writes the next part of a record started with WriteBegin().
+ * @param stream Output stream to write to.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ * @return Number of bytes written, or -1 if error or more than the record length.
+ */
+int VariableLengthBuffer::WritePart(ostream &stream, const void *data, int size)
+{
+    if (size < 0 || size > PartRemaining) return -1;
+    stream.write((const char*)data, size);
+    if (!stream.good()) return -1;
+    PartRemaining -= size;
+    return size;
+}
+
+/**
+ * @brief Starts reading a record in parts, without loading it into the buffer.
+ * @param stream Input stream positioned at a record.
+ * @param length Set to the record's total length.
+ * @return Position in stream of the record, or -1 if error.
+ */
+int VariableLengthBuffer::ReadBegin(istream &stream, long long &length)
+{
+    if (stream.eof()) return -1;
+    int recaddr = stream.tellg();
+    PartRemaining = 0;
+    if (!ReadLength(stream, length))
+    {
+        stream.clear();
+        return -1;
+    }
+    PartRemaining = length;
+    return recaddr;
+}
+
+/**
+ * @brief Reads the next part of a record started with ReadBegin().
+ * @param stream Input stream to read from.
+ * @param data Where to store the bytes.
+ * @param maxBytes Most bytes to read.
+ * @return Number of bytes read, 0 once the whole record was read, or -1 if error.
+ */
+int VariableLengthBuffer::ReadPart(istream &stream, void *data, int maxBytes)
+{
+    if (maxBytes < 0) return -1;
+    int n = PartRemaining < maxBytes ? (int)PartRemaining : maxBytes;
+    if (n == 0) return 0;
+    stream.read((char*)data, n);
+    if (!stream.good())
+    {
+        stream.clear();
+        return -1;
+    }
+    PartRemaining -= n;
+    return n;
+}
+
+// header strings and size (both the same size, so headers line up)
+const char* headerStr = "VarintLn";
+const char* legacyHeaderStr = "Variable";
 const int headerSize = strlen(headerStr);
 
 /**
@@ -118,7 +261,9 @@ int VariableLengthBuffer::ReadHeader(istream &stream)
     stream.read(str, headerSize);
     if (!stream.good()) return 0;
     str[headerSize] = '\0';
-    if (strncmp(str, headerStr, headerSize) != 0) return 0;
+    if (strncmp(str, headerStr, headerSize) == 0) LegacyLength = 0;
+    else if (strncmp(str, legacyHeaderStr, headerSize) == 0) LegacyLength = 1;
+    else return 0;
     return stream.tellg();
 }
 
@@ -127,13 +272,14 @@ int VariableLengthBuffer::ReadHeader(istream &stream)
  * @param stream Output stream to write to.
  * @return Stream position after writing header, or 0 if error.
  * @pre None
- * @post Stream contains IOBuffer header followed by "Variable" string
+ * @post Stream contains IOBuffer header followed by "VarintLn" (or
+ *       "Variable" if the buffer was last used on an older file)
  */
 int VariableLengthBuffer::WriteHeader(ostream &stream) const
 {
     int result = IOBuffer::WriteHeader(stream);
     if (!result) return 0;
-    stream.write(headerStr, headerSize);
+    stream.write(LegacyLength ? legacyHeaderStr : headerStr, headerSize);
     if (!stream.good()) return 0;
     return stream.tellp();
 }
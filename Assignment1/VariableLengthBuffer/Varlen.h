@@ -19,11 +19,17 @@
 //   - Supports packing of fixed-length, delimited, and length-prefixed data
 //   - Maintains header string for stream consistency
 //   - Can read/write to/from streams and print buffer contents
+//   - The buffer grows to fit the record and keeps its capacity, so reading
+//     or packing many records reallocates only a few times
+//   - Records too large to hold in memory can be written and read in parts
+//     (WriteBegin/WritePart, ReadBegin/ReadPart)
 //
 // Assumptions:
 //   - IOBuffer base class is implemented and provides basic buffer management
-//   - Buffer length is stored as unsigned short in stream files
-//   - Header string "Variable" is used to identify buffer type
+//   - Record length is stored as a varint (7 bits per byte, low bits first)
+//     in files with header string "VarintLn"
+//   - Files with header string "Variable" store it as unsigned short (at
+//     most 65535 bytes per record); they are still read and written
 
 #ifndef VARLEN_H
 #define VARLEN_H
@@ -57,7 +63,7 @@ public:
      * @post Buffer contents are copied from the source.
      */
     VariableLengthBuffer(const VariableLengthBuffer &buffer)
-        : IOBuffer(buffer) {}
+        : IOBuffer(buffer), LegacyLength(buffer.LegacyLength), PartRemaining(0) {}
 
     /**
      * @brief Clears the buffer.
@@ -79,10 +85,46 @@ public:
      */
     int Write(ostream &) const; 
 
+    /**
+     * @brief Starts writing a record of a known length in parts.
+     * @param stream Output stream to write to.
+     * @param length Total bytes the record's parts will add up to.
+     * @return Position in stream of the record, or -1 if error.
+     * @post The length prefix is written; WritePart() writes the body.
+     */
+    int WriteBegin(ostream &, long long length);
+
+    /**
+     * @brief Writes the next part of a record started with WriteBegin().
+     * @param stream Output stream to write to.
+     * @param data Bytes to write.
+     * @param size Number of bytes; the parts may not exceed the record length.
+     * @return Number of bytes written, or -1 if error.
+     */
+    int WritePart(ostream &, const void *, int);
+
+    /**
+     * @brief Starts reading a record in parts, without loading it into the buffer.
+     * @param stream Input stream positioned at a record.
+     * @param length Set to the record's total length.
+     * @return Position in stream of the record, or -1 if error.
+     */
+    int ReadBegin(istream &, long long &length);
+
+    /**
+     * @brief Reads the next part of a record started with ReadBegin().
+     * @param stream Input stream to read from.
+     * @param data Where to store the bytes.
+     * @param maxBytes Most bytes to read.
+     * @return Number of bytes read, 0 once the whole record was read, or -1 if error.
+     */
+    int ReadPart(istream &, void *, int);
+
     /**
      * @brief Reads the buffer header from a stream.
      * @param stream Input stream containing the header.
      * @return Stream position after reading header, or 0 if error.
+     * @post Lengths are read and written in the file's format.
      */
     int ReadHeader(istream &);
 
@@ -138,6 +180,13 @@ public:
      * @post Buffer is cleared and ready for use.
      */
     int Init();
+
+protected:
+    int LegacyLength;        // non-zero for files with unsigned short lengths
+    long long PartRemaining; // bytes left in the record being read or written in parts
+
+    int ReadLength(istream &, long long &length); // reads a record's length prefix
+    int WriteLength(ostream &, long long length) const; // writes a record's length prefix
 };
 
 #endif
@@ -5,6 +5,7 @@
 #include <iomanip>
 #include <string>
 #include <cstdlib>
+#include <vector>
 #include "Location/Location.h"
 #include "DelimFieldBuffer/Delim.h"
 
@@ -13,22 +14,26 @@ using namespace std;
 /**
  * @struct StateExtremes
  * @brief Holds the easternmost, westernmost, northernmost, and southernmost
- *        Location records for a particular state.
+ *        records for a particular state, as record numbers (indices into the
+ *        table of ZIP codes) with the coordinate that put them there.
  */
 struct StateExtremes {
-    Location eastMost;   ///< Location with the smallest longitude
-    Location westMost;   ///< Location with the largest longitude
-    Location northMost;  ///< Location with the largest latitude
-    Location southMost;  ///< Location with the smallest latitude
+    int eastMost = -1;   ///< Record with the smallest longitude
+    int westMost = -1;   ///< Record with the largest longitude
+    int northMost = -1;  ///< Record with the largest latitude
+    int southMost = -1;  ///< Record with the smallest latitude
+    double eastLon = 0, westLon = 0, northLat = 0, southLat = 0; ///< Their coordinates
     bool initialized = false; ///< Indicates whether any record has been stored
 };
 
 /**
  * @brief Reads the US postal code CSV file and prints a table of extremes per state.
  *
- * Reads the CSV file line by line, populates Location objects, determines the 
- * easternmost, westernmost, northernmost, and southernmost Zip Codes per state,
- * and prints the results in a formatted table with alphabetical state IDs.
+ * Reads the CSV file line by line straight into a DelimFieldBuffer and looks
+ * at each row through a LocationView, so fields are not copied out of the
+ * buffer. Determines the easternmost, westernmost, northernmost, and
+ * southernmost Zip Codes per state, and prints the results in a formatted
+ * table with alphabetical state IDs.
  *
  * @return int Returns 0 on success, 1 if the CSV file cannot be opened.
  */
@@ -41,52 +46,39 @@ int main() {
     }
 
     DelimFieldBuffer buffer(','); // CSV is comma-delimited
-    Location loc;
+    LocationView loc;
 
     // Skip CSV header line
-    string headerLine;
-    getline(in, headerLine);
+    buffer.ReadLine(in);
 
-    map<string, StateExtremes> stateMap;
-    string line;
+    map<string, StateExtremes, less<>> stateMap;
+    vector<string> zipCodes; // ZIP code of each record, by record number
 
-    while (getline(in, line)) {
-        if (line.empty()) continue;
+    while (buffer.ReadLine(in) != -1) {
+        if (!loc.UnpackCSV(buffer)) continue;  // empty or short row
+        if (loc.State().size() != 2) continue; // Skip invalid rows
 
-        stringstream ss(line);
-        string zip, place, state, county, lat, lon;
+        double dlat = loc.LatitudeValue();
+        double dlon = loc.LongitudeValue();
 
-        // Parse CSV fields
-        getline(ss, zip, ',');
-        getline(ss, place, ',');
-        getline(ss, state, ',');
-        getline(ss, county, ',');
-        getline(ss, lat, ',');
-        getline(ss, lon, ',');
+        auto it = stateMap.find(loc.State());
+        if (it == stateMap.end())
+            it = stateMap.emplace(string(loc.State()), StateExtremes()).first;
+        StateExtremes& s = it->second;
 
-        // Populate Location object
-        strcpy(loc.ZipCode, zip.c_str());
-        strcpy(loc.PlaceName, place.c_str());
-        strcpy(loc.State, state.c_str());
-        strcpy(loc.County, county.c_str());
-        strcpy(loc.Latitude, lat.c_str());
-        strcpy(loc.Longitude, lon.c_str());
-
-        if (strlen(loc.State) != 2) continue; // Skip invalid rows
-
-        double dlat = atof(loc.Latitude);
-        double dlon = atof(loc.Longitude);
-
-        StateExtremes& s = stateMap[state];
+        int record = static_cast<int>(zipCodes.size());
+        zipCodes.emplace_back(loc.ZipCode());
 
         if (!s.initialized) {
-            s.eastMost = s.westMost = s.northMost = s.southMost = loc;
+            s.eastMost = s.westMost = s.northMost = s.southMost = record;
+            s.eastLon = s.westLon = dlon;
+            s.northLat = s.southLat = dlat;
             s.initialized = true;
         } else {
-            if (dlon < atof(s.eastMost.Longitude)) s.eastMost = loc;
-            if (dlon > atof(s.westMost.Longitude)) s.westMost = loc;
-            if (dlat > atof(s.northMost.Latitude)) s.northMost = loc;
-            if (dlat < atof(s.southMost.Latitude)) s.southMost = loc;
+            if (dlon < s.eastLon) { s.eastMost = record; s.eastLon = dlon; }
+            if (dlon > s.westLon) { s.westMost = record; s.westLon = dlon; }
+            if (dlat > s.northLat) { s.northMost = record; s.northLat = dlat; }
+            if (dlat < s.southLat) { s.southMost = record; s.southLat = dlat; }
         }
     }
     in.close();
@@ -103,10 +95,10 @@ int main() {
     for (auto& pair : stateMap) {
         StateExtremes& s = pair.second;
         cout << left << setw(6) << pair.first
-             << setw(14) << s.eastMost.ZipCode
-             << setw(14) << s.westMost.ZipCode
-             << setw(14) << s.northMost.ZipCode
-             << setw(14) << s.southMost.ZipCode
+             << setw(14) << zipCodes[s.eastMost]
+             << setw(14) << zipCodes[s.westMost]
+             << setw(14) << zipCodes[s.northMost]
+             << setw(14) << zipCodes[s.southMost]
              << endl;
     }
 
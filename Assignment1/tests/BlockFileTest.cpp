@@ -0,0 +1,120 @@
+/**
+ * @file BlockFileTest.cpp
+ * @brief Checks that a BufferFile in block mode reads and writes the same
+ *        records, and the same file bytes, as one in record mode.
+ *
+ * Build and run from the top of Assignment1:
+ * @code
+ * g++ -std=c++17 -o BlockFileTest tests/BlockFileTest.cpp IOBuffer/Iobuffer.cpp \
+ *     VariableLengthBuffer/Varlen.cpp BufferFile/Buffile.cpp BufferFile/Blockbuf.cpp
+ * ./BlockFileTest
+ * @endcode
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "TestCheck.h"
+#include "../BufferFile/Buffile.h"
+#include "../VariableLengthBuffer/Varlen.h"
+
+using namespace std;
+
+/// Record @p i: lengths vary so that records straddle block boundaries.
+static string recordText(int i, char fill = 'r')
+{
+    return to_string(i) + ":" + string(1 + (i * 37) % 150, fill);
+}
+
+/// Packs @p text as the buffer's only field.
+static void setRecord(IOBuffer& buffer, const string& text)
+{
+    buffer.Clear();
+    buffer.Pack(text.c_str());
+}
+
+/// Returns the field of the record last read into @p buffer.
+static string getRecord(IOBuffer& buffer)
+{
+    const char* field;
+    int length = buffer.UnpackView(field);
+    return length < 0 ? string("<none>") : string(field, length);
+}
+
+/// Returns the bytes of @p path.
+static string fileBytes(const char* path)
+{
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+/**
+ * @brief Writes, rewrites and reads one file with @p blockSize (0 = record
+ *        mode) and returns its final bytes.
+ */
+static string exercise(const char* path, int blockSize)
+{
+    const int records = 300;
+    VariableLengthBuffer buffer;
+    vector<int> addr(records);
+    {
+        BufferFile file(buffer, blockSize);
+        CHECK(file.Create(path, ios::in | ios::out | ios::trunc));
+
+        // Each record can be read back right after it is appended, before
+        // any Flush(), and the next Append still lands at the end
+        for (int i = 0; i < records; ++i) {
+            setRecord(buffer, recordText(i));
+            addr[i] = file.Append();
+            CHECK(addr[i] > 0);
+            if (i % 7 == 0) {
+                CHECK(file.Read(addr[i]) == addr[i]);
+                CHECK(getRecord(buffer) == recordText(i));
+            }
+        }
+        CHECK(file.Read(addr[records / 2]) == addr[records / 2]);
+        CHECK(getRecord(buffer) == recordText(records / 2));
+
+        // Rewriting records in place (same length) leaves their neighbours alone
+        for (int i = 1; i < records; i += 10) {
+            setRecord(buffer, recordText(i, 'w'));
+            CHECK(file.Write(addr[i]) == addr[i]);
+        }
+
+        // Direct reads in a scattered order
+        for (int step = 0; step < records; ++step) {
+            int i = (step * 131) % records;
+            CHECK(file.Read(addr[i]) == addr[i]);
+            CHECK(getRecord(buffer) == recordText(i, i % 10 == 1 ? 'w' : 'r'));
+        }
+        CHECK(file.Close());
+    }
+
+    // Reopened, a sequential read sees every record, then the end
+    BufferFile file(buffer, blockSize);
+    CHECK(file.Open(path, ios::in | ios::out));
+    for (int i = 0; i < records; ++i) {
+        CHECK(file.Read() == addr[i]);
+        CHECK(getRecord(buffer) == recordText(i, i % 10 == 1 ? 'w' : 'r'));
+    }
+    CHECK(file.Read() == -1);
+    file.Close();
+    return fileBytes(path);
+}
+
+int main()
+{
+    const char* path = "block_file_test.dat";
+    string plain = exercise(path, 0);
+    CHECK(!plain.empty());
+    for (int blockSize : {64, 512, 4096}) {
+        if (exercise(path, blockSize) != plain) {
+            cerr << "Block size " << blockSize << " wrote different bytes than record mode\n";
+            ++checkFailures;
+        }
+    }
+    remove(path);
+    return CheckResult("BlockFileTest");
+}
@@ -0,0 +1,88 @@
+/**
+ * @file LocationViewTest.cpp
+ * @brief Checks that a LocationView sees the same fields as Location::Unpack
+ *        and as the CSV columns, without copying them.
+ *
+ * Build and run from the top of Assignment1:
+ * @code
+ * g++ -std=c++17 -o LocationViewTest tests/LocationViewTest.cpp IOBuffer/Iobuffer.cpp \
+ *     VariableLengthBuffer/Varlen.cpp DelimFieldBuffer/Delim.cpp Location/Location.cpp
+ * ./LocationViewTest
+ * @endcode
+ */
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include "TestCheck.h"
+#include "../Location/Location.h"
+#include "../DelimFieldBuffer/Delim.h"
+
+using namespace std;
+
+int main()
+{
+    // A Location written as a record reads back the same through a view
+    Location loc;
+    strcpy(loc.ZipCode, "56301");
+    strcpy(loc.PlaceName, "Saint Cloud");
+    strcpy(loc.County, "Stearns");
+    strcpy(loc.State, "MN");
+    strcpy(loc.Latitude, "45.5339");
+    strcpy(loc.Longitude, "-94.1718");
+    DelimFieldBuffer buffer('|');
+    CHECK(loc.Pack(buffer));
+    stringstream file;
+    CHECK(buffer.Write(file) != -1);
+    CHECK(buffer.Read(file) != -1);
+
+    LocationView view;
+    CHECK(view.Unpack(buffer));
+    CHECK(view.ZipCode() == "56301");
+    CHECK(view.PlaceName() == "Saint Cloud");
+    CHECK(view.County() == "Stearns");
+    CHECK(view.State() == "MN");
+    CHECK(view.LatitudeValue() == 45.5339);
+    CHECK(view.LongitudeValue() == -94.1718);
+
+    Location copy;
+    view.ToLocation(copy);
+    CHECK(strcmp(copy.ZipCode, loc.ZipCode) == 0 && strcmp(copy.PlaceName, loc.PlaceName) == 0 &&
+          strcmp(copy.County, loc.County) == 0 && strcmp(copy.State, loc.State) == 0 &&
+          strcmp(copy.Latitude, loc.Latitude) == 0 && strcmp(copy.Longitude, loc.Longitude) == 0);
+
+    // CSV rows, read straight into the buffer: the last column (with or
+    // without a carriage return) and empty columns unpack like the rest
+    istringstream csv("501,Holtsville,NY,Suffolk,40.8154,-73.0451\r\n"
+                      "99950,Ketchikan,AK,,55.5423,-131.4387\n"
+                      "56301,Saint Cloud,MN,Stearns,45.5339,-94.1718");
+    DelimFieldBuffer row(',');
+    CHECK(row.ReadLine(csv) > 0);
+    CHECK(view.UnpackCSV(row));
+    CHECK(view.ZipCode() == "501" && view.State() == "NY" && view.County() == "Suffolk");
+    CHECK(view.Longitude() == "-73.0451");
+    CHECK(row.ReadLine(csv) > 0);
+    CHECK(view.UnpackCSV(row));
+    CHECK(view.County().empty());
+    CHECK(view.LatitudeValue() == 55.5423);
+    CHECK(row.ReadLine(csv) > 0);
+    CHECK(view.UnpackCSV(row));
+    CHECK(view.PlaceName() == "Saint Cloud" && view.Longitude() == "-94.1718");
+    CHECK(row.ReadLine(csv) == -1);
+
+    // The fields point into the buffer's bytes rather than at copies
+    istringstream line("12345,Town,MN,Cty,1.5,2.5\n");
+    CHECK(row.ReadLine(line) > 0);
+    CHECK(view.UnpackCSV(row));
+    const char* zip = view.ZipCode().data();
+    CHECK(view.PlaceName().data() == zip + 6 && view.Longitude().data() == zip + 22);
+    CHECK(view.LongitudeValue() == 2.5);
+
+    // A record with too few fields is refused and leaves the view empty
+    istringstream shortRow("1,Town,MN\n");
+    CHECK(row.ReadLine(shortRow) > 0);
+    CHECK(!view.UnpackCSV(row));
+    CHECK(view.ZipCode().empty());
+
+    return CheckResult("LocationViewTest");
+}
@@ -0,0 +1,129 @@
+/**
+ * @file RecordNumberTest.cpp
+ * @brief Checks FixedLengthBuffer slots and BufferFile access by relative
+ *        record number (RRN), in record mode and in block mode.
+ *
+ * Build and run from the top of Assignment1:
+ * @code
+ * g++ -std=c++17 -o RecordNumberTest tests/RecordNumberTest.cpp IOBuffer/Iobuffer.cpp \
+ *     VariableLengthBuffer/Varlen.cpp FixedLengthBuffer/Fixlen.cpp BufferFile/Buffile.cpp \
+ *     BufferFile/Blockbuf.cpp
+ * ./RecordNumberTest
+ * @endcode
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "TestCheck.h"
+#include "../BufferFile/Buffile.h"
+#include "../FixedLengthBuffer/Fixlen.h"
+#include "../VariableLengthBuffer/Varlen.h"
+
+using namespace std;
+
+static const char* PATH = "record_number_test.dat";
+static const int RECORDS = 500;
+
+/// Record @p rrn, between 1 and 100 bytes long.
+static string recordText(int rrn, char fill = 'r')
+{
+    return to_string(rrn) + ":" + string(rrn % 90, fill);
+}
+
+/// Packs @p text as the buffer's only field.
+static int setRecord(IOBuffer& buffer, const string& text)
+{
+    buffer.Clear();
+    return buffer.Pack(text.c_str());
+}
+
+/// Returns the field of the record last read into @p buffer.
+static string getRecord(IOBuffer& buffer)
+{
+    const char* field;
+    int length = buffer.UnpackView(field);
+    return length < 0 ? string("<none>") : string(field, length);
+}
+
+/// Writes RECORDS records by number, rewrites some and reads them at random.
+static void exercise(int blockSize)
+{
+    FixedLengthBuffer buffer(FixedLengthBuffer::LengthClass(100));
+    CHECK(buffer.GetRecordSize() == 128);
+    {
+        BufferFile file(buffer, blockSize);
+        CHECK(file.Create(PATH, ios::in | ios::out | ios::trunc));
+        int header = file.RecordAddress(0);
+        CHECK(header == 8 + 5 + 4);  // "IOBuffer", "Fixed", record size
+        CHECK(file.RecordAddress(7) == header + 7 * 128);
+        CHECK(file.RecordAddress(-1) == -1);
+
+        // Writing one past the last record appends
+        for (int rrn = 0; rrn < RECORDS; ++rrn) {
+            setRecord(buffer, recordText(rrn));
+            CHECK(file.WriteRRN(rrn) == file.RecordAddress(rrn));
+        }
+
+        // Overwriting a record touches only its own slot, whatever the new length
+        for (int rrn = 3; rrn < RECORDS; rrn += 50) {
+            setRecord(buffer, rrn % 100 == 3 ? string("x") : recordText(rrn, 'w') + "!");
+            CHECK(file.WriteRRN(rrn) != -1);
+        }
+        for (int step = 0; step < RECORDS; ++step) {
+            int rrn = (step * 211) % RECORDS;
+            CHECK(file.ReadRRN(rrn) == file.RecordAddress(rrn));
+            string expected = rrn % 50 != 3 ? recordText(rrn) : rrn % 100 == 3 ? string("x") : recordText(rrn, 'w') + "!";
+            CHECK(getRecord(buffer) == expected);
+        }
+
+        // Past the end and negative numbers fail
+        CHECK(file.ReadRRN(RECORDS) == -1);
+        CHECK(file.ReadRRN(-1) == -1);
+        CHECK(file.WriteRRN(-1) == -1);
+        CHECK(file.Close());
+    }
+
+    ifstream raw(PATH, ios::binary | ios::ate);
+    CHECK(static_cast<long long>(raw.tellg()) == 17 + 128LL * RECORDS);
+
+    // A buffer with another record size, or a variable-length one, cannot open the file
+    FixedLengthBuffer smaller(64);
+    BufferFile wrongSize(smaller, blockSize);
+    CHECK(!wrongSize.Open(PATH, ios::in));
+    VariableLengthBuffer variable;
+    BufferFile wrongKind(variable, blockSize);
+    CHECK(!wrongKind.Open(PATH, ios::in));
+    CHECK(wrongKind.RecordAddress(0) == -1);
+    CHECK(wrongKind.ReadRRN(0) == -1);
+    CHECK(wrongKind.WriteRRN(0) == -1);
+
+    // Reopened with the right size, the records are where they were
+    BufferFile again(buffer, blockSize);
+    CHECK(again.Open(PATH, ios::in));
+    CHECK(again.ReadRRN(RECORDS - 1) != -1);
+    CHECK(getRecord(buffer) == recordText(RECORDS - 1));
+    CHECK(again.ReadRRN(0) != -1);
+    CHECK(getRecord(buffer) == recordText(0));
+}
+
+int main()
+{
+    // Slot sizes are powers of two from 16 up, with room for the 2-byte length
+    CHECK(FixedLengthBuffer::LengthClass(0) == 16);
+    CHECK(FixedLengthBuffer::LengthClass(14) == 16);
+    CHECK(FixedLengthBuffer::LengthClass(15) == 32);
+    CHECK(FixedLengthBuffer::LengthClass(109) == 128);
+
+    // A record longer than its slot is refused, not cut short
+    FixedLengthBuffer slot(32);
+    CHECK(setRecord(slot, string(29, 'a')) == 30);
+    CHECK(setRecord(slot, string(30, 'a')) == -1);
+
+    exercise(0);
+    exercise(100);   // blocks that do not line up with slots
+    exercise(4096);
+
+    remove(PATH);
+    return CheckResult("RecordNumberTest");
+}
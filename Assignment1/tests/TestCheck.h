@@ -0,0 +1,39 @@
+/**
+ * @file TestCheck.h
+ * @brief The CHECK macro and result line shared by the driver programs in
+ *        tests/.
+ *
+ * Each driver is a small program built from the top of Assignment1 with the
+ * command in its file comment. It prints one line per failed check and exits
+ * non-zero if any check failed.
+ */
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <iostream>
+
+static int checkFailures = 0;  ///< Failed checks so far in this driver
+
+/// Records a failed condition with its source line and carries on.
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n";  \
+            ++checkFailures;                                                            \
+        }                                                                               \
+    } while (0)
+
+/**
+ * @brief Prints the driver's result and returns its exit status.
+ *
+ * @param name Name of the driver
+ * @return 0 if every check passed, 1 otherwise
+ */
+static int CheckResult(const char* name)
+{
+    std::cout << name << ": " << (checkFailures == 0 ? "passed" : "FAILED") << "\n";
+    return checkFailures == 0 ? 0 : 1;
+}
+
+#endif // TESTCHECK_H
@@ -0,0 +1,180 @@
+/**
+ * @file VarintLengthTest.cpp
+ * @brief Checks varint record lengths, large and streamed records, and
+ *        reading and appending to files with the older "Variable" header.
+ *
+ * Build and run from the top of Assignment1:
+ * @code
+ * g++ -std=c++17 -o VarintLengthTest tests/VarintLengthTest.cpp IOBuffer/Iobuffer.cpp \
+ *     VariableLengthBuffer/Varlen.cpp BufferFile/Buffile.cpp BufferFile/Blockbuf.cpp
+ * ./VarintLengthTest
+ * @endcode
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "TestCheck.h"
+#include "../BufferFile/Buffile.h"
+#include "../VariableLengthBuffer/Varlen.h"
+
+using namespace std;
+
+static const char* PATH = "varint_length_test.dat";
+
+/// Packs @p text (without a terminator) as the buffer's record.
+static void setRecord(IOBuffer& buffer, const string& text)
+{
+    buffer.Clear();
+    buffer.Pack(text.data(), static_cast<int>(text.size()));
+}
+
+/// A record of @p length bytes whose contents depend on @p seed.
+static string makeBody(size_t length, int seed)
+{
+    string body(length, '\0');
+    for (size_t i = 0; i < length; ++i) body[i] = static_cast<char>('a' + (i * 7 + seed) % 26);
+    return body;
+}
+
+/// Returns the bytes of @p path.
+static string fileBytes(const char* path)
+{
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+/// Writes a file with the "Variable" header and unsigned short lengths.
+static void writeLegacyFile(const vector<string>& records)
+{
+    ofstream out(PATH, ios::binary | ios::trunc);
+    out.write("IOBufferVariable", 16);
+    for (const string& rec : records) {
+        unsigned short length = static_cast<unsigned short>(rec.size());
+        out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        out.write(rec.data(), static_cast<streamsize>(rec.size()));
+    }
+}
+
+/// Reads every record of PATH, in order.
+static vector<string> readRecords(VariableLengthBuffer& buffer, int blockSize)
+{
+    vector<string> records;
+    BufferFile file(buffer, blockSize);
+    if (!file.Open(PATH, ios::in)) return records;
+    while (file.Read() != -1) {
+        vector<char> bytes(buffer.GetUsed() + 1);
+        if (buffer.GetUsed() > 0) buffer.Unpack(bytes.data(), static_cast<int>(bytes.size()));
+        records.emplace_back(bytes.data(), buffer.GetUsed());
+    }
+    return records;
+}
+
+int main()
+{
+    // Lengths at every 7-bit boundary read back, with the expected prefix size
+    const long long lengths[] = {0, 1, 127, 128, 16383, 16384, (1LL << 21) - 1, 1LL << 21,
+                                 (1LL << 28) - 1, 1LL << 28, 1LL << 35, (1LL << 40) - 1, 1LL << 40};
+    VariableLengthBuffer buffer;
+    for (long long length : lengths) {
+        stringstream stream;
+        CHECK(buffer.WriteBegin(stream, length) == 0);
+        size_t prefix = stream.str().size();
+        size_t expected = 1;
+        for (long long rest = length >> 7; rest; rest >>= 7) ++expected;
+        CHECK(prefix == expected);
+
+        long long back = -1;
+        CHECK(buffer.ReadBegin(stream, back) == 0);
+        CHECK(back == length);
+    }
+
+    // A truncated prefix, or one with too many continuation bytes, is refused
+    {
+        stringstream cut(string("\x80\x80", 2));
+        long long back;
+        CHECK(buffer.ReadBegin(cut, back) == -1);
+        stringstream endless(string(10, '\xFF') + '\x01');
+        CHECK(buffer.ReadBegin(endless, back) == -1);
+    }
+
+    // Records far beyond 64 KB round trip through buffers that start small,
+    // in record mode and in block mode
+    vector<string> big;
+    for (int i = 0; i < 12; ++i) big.push_back(makeBody(static_cast<size_t>(i) * 27000 + i, i));
+    for (int blockSize : {0, 4096}) {
+        {
+            VariableLengthBuffer out(16);
+            BufferFile file(out, blockSize);
+            CHECK(file.Create(PATH, ios::in | ios::out | ios::trunc));
+            for (const string& rec : big) {
+                setRecord(out, rec);
+                CHECK(file.Append() != -1);
+            }
+        }
+        CHECK(fileBytes(PATH).compare(0, 16, "IOBufferVarintLn") == 0);
+        VariableLengthBuffer in(16);
+        CHECK(readRecords(in, blockSize) == big);
+    }
+
+    // A 3 MB record is written and read in parts, never whole in a buffer
+    {
+        const long long total = 3LL << 20;
+        {
+            ofstream out(PATH, ios::binary | ios::trunc);
+            CHECK(buffer.WriteHeader(out) > 0);
+            CHECK(buffer.WriteBegin(out, total) > 0);
+            string part = makeBody(65536, 5);
+            for (long long done = 0; done < total; done += static_cast<long long>(part.size())) {
+                CHECK(buffer.WritePart(out, part.data(), static_cast<int>(part.size())) == 65536);
+            }
+            CHECK(buffer.WritePart(out, "x", 1) == -1);  // more than the length given
+        }
+        ifstream in(PATH, ios::binary);
+        CHECK(buffer.ReadHeader(in) > 0);
+        long long length = 0;
+        CHECK(buffer.ReadBegin(in, length) > 0);
+        CHECK(length == total);
+        string expected = makeBody(65536, 5), chunk(50000, '\0');
+        long long seen = 0;
+        bool same = true;
+        for (int n; (n = buffer.ReadPart(in, &chunk[0], 50000)) > 0; seen += n) {
+            for (int i = 0; i < n; ++i) same = same && chunk[i] == expected[(seen + i) % 65536];
+        }
+        CHECK(seen == total);
+        CHECK(same);
+    }
+
+    // A file with the older header reads, takes appends with 2-byte lengths,
+    // keeps its header, and refuses a record its lengths cannot hold
+    vector<string> legacy = {"56301,Saint Cloud", "", makeBody(300, 1), makeBody(65535, 2)};
+    for (int blockSize : {0, 4096}) {
+        writeLegacyFile(legacy);
+        size_t before = fileBytes(PATH).size();
+        VariableLengthBuffer old;
+        CHECK(readRecords(old, blockSize) == legacy);
+        {
+            BufferFile file(old, blockSize);
+            CHECK(file.Open(PATH, ios::in | ios::out));
+            setRecord(old, "99950,Ketchikan");
+            CHECK(file.Append() != -1);
+            setRecord(old, makeBody(65536, 3));
+            CHECK(file.Append() == -1);
+        }
+        string bytes = fileBytes(PATH);
+        CHECK(bytes.compare(0, 16, "IOBufferVariable") == 0);
+        CHECK(bytes.size() == before + 2 + 15);
+
+        vector<string> expected = legacy;
+        expected.push_back("99950,Ketchikan");
+        VariableLengthBuffer again;
+        CHECK(readRecords(again, blockSize) == expected);
+    }
+
+    remove(PATH);
+    return CheckResult("VarintLengthTest");
+}
@@ -0,0 +1,316 @@
+/**
+ * @file AsyncPageReader.cpp
+ * @brief Implementation of the AsyncPageReader io_uring / thread-pool reader.
+ *
+ * io_uring is driven through its system calls directly (no liburing): the
+ * submission ring, completion ring and submission entries are mapped from
+ * the ring descriptor, and every read is a one-buffer IORING_OP_READV.
+ */
+
+#include "AsyncPageReader.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNCPAGEREADER_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+static int openForRead(const string& path) { return _open(path.c_str(), _O_RDONLY | _O_BINARY); }
+static void closeFd(int fd) { _close(fd); }
+/// Seek and read are two calls on Windows, so pool reads take turns
+static mutex seekLock;
+static bool readAt(int fd, char* data, size_t size, long long offset, size_t& got)
+{
+    lock_guard<mutex> guard(seekLock);
+    got = 0;
+    if (_lseeki64(fd, offset, SEEK_SET) != offset) return false;
+    while (got < size) {
+        int n = _read(fd, data + got, static_cast<unsigned>(size - got));
+        if (n < 0) return false;
+        if (n == 0) break;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+#else
+static int openForRead(const string& path) { return open(path.c_str(), O_RDONLY); }
+static void closeFd(int fd) { close(fd); }
+static bool readAt(int fd, char* data, size_t size, long long offset, size_t& got)
+{
+    got = 0;
+    while (got < size) {
+        ssize_t n = pread(fd, data + got, size - got, static_cast<off_t>(offset + got));
+        if (n < 0) return false;
+        if (n == 0) break;
+        got += static_cast<size_t>(n);
+    }
+    return true;
+}
+#endif
+
+#ifdef ASYNCPAGEREADER_URING
+
+struct AsyncPageReader::Ring {
+    /// Buffer and request of one submitted read
+    struct Slot {
+        uint64_t tag = 0;
+        long long offset = 0;
+        string buffer;
+        iovec vector = {nullptr, 0};
+    };
+
+    int ringFd = -1;
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    vector<Slot> slots;
+    vector<unsigned> freeSlots;
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (ringFd >= 0) close(ringFd);
+    }
+
+    /**
+     * @brief Creates a ring for @p entries reads; null if io_uring is unavailable.
+     */
+    static unique_ptr<Ring> Create(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        unique_ptr<Ring> ring(new Ring());
+        ring->ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ring->ringFd < 0) return nullptr;
+
+        ring->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) ring->sqMapSize = ring->cqMapSize = max(ring->sqMapSize, ring->cqMapSize);
+
+        ring->sqMap = mmap(nullptr, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ring->ringFd, IORING_OFF_SQ_RING);
+        if (ring->sqMap == MAP_FAILED) return nullptr;
+        ring->cqMap = single ? ring->sqMap
+                             : mmap(nullptr, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                    ring->ringFd, IORING_OFF_CQ_RING);
+        if (ring->cqMap == MAP_FAILED) return nullptr;
+        ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                                                     MAP_SHARED | MAP_POPULATE, ring->ringFd, IORING_OFF_SQES));
+        if (ring->sqes == MAP_FAILED) return nullptr;
+
+        char* sq = static_cast<char*>(ring->sqMap);
+        char* cq = static_cast<char*>(ring->cqMap);
+        ring->sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        ring->sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        ring->sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        ring->cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        ring->cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        ring->cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // Never more reads in flight than submission entries, so the
+        // completion ring (at least as large) cannot overflow
+        unsigned usable = min(entries, params.sq_entries);
+        ring->slots.resize(usable);
+        for (unsigned i = usable; i > 0; --i) ring->freeSlots.push_back(i - 1);
+        return ring;
+    }
+
+    size_t InFlight() const { return slots.size() - freeSlots.size(); }
+
+    bool Submit(int fd, uint64_t tag, long long offset, size_t length)
+    {
+        if (freeSlots.empty()) return false;
+        unsigned index = freeSlots.back();
+        Slot& slot = slots[index];
+        slot.tag = tag;
+        slot.offset = offset;
+        slot.buffer.assign(length, '\0');
+        slot.vector.iov_base = &slot.buffer[0];
+        slot.vector.iov_len = length;
+
+        // Only this thread writes the tail; the kernel reads it
+        unsigned tail = *sqTail;
+        unsigned position = tail & *sqMask;
+        io_uring_sqe& entry = sqes[position];
+        memset(&entry, 0, sizeof(entry));
+        entry.opcode = IORING_OP_READV;
+        entry.fd = fd;
+        entry.addr = reinterpret_cast<uint64_t>(&slot.vector);
+        entry.len = 1;
+        entry.off = static_cast<uint64_t>(offset);
+        entry.user_data = index;
+        sqArray[position] = position;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        if (syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0) != 1) {
+            // Not taken: step the tail back so the entry is not submitted later
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+        freeSlots.pop_back();
+        return true;
+    }
+
+    bool Reap(CompletedRead& out, bool wait)
+    {
+        if (InFlight() == 0) return false;
+        unsigned head = *cqHead;
+        while (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            if (!wait) return false;
+            syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        }
+        const io_uring_cqe& done = cqes[head & *cqMask];
+        unsigned index = static_cast<unsigned>(done.user_data);
+        int result = done.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+
+        Slot& slot = slots[index];
+        out.tag = slot.tag;
+        out.offset = slot.offset;
+        out.ok = result >= 0;
+        slot.buffer.resize(result > 0 ? static_cast<size_t>(result) : 0);
+        out.bytes = move(slot.buffer);
+        freeSlots.push_back(index);
+        return true;
+    }
+};
+
+#else
+
+struct AsyncPageReader::Ring {
+    static unique_ptr<Ring> Create(unsigned) { return nullptr; }
+    size_t InFlight() const { return 0; }
+    bool Submit(int, uint64_t, long long, size_t) { return false; }
+    bool Reap(CompletedRead&, bool) { return false; }
+};
+
+#endif // ASYNCPAGEREADER_URING
+
+AsyncPageReader::AsyncPageReader(unsigned queueDepth, bool useIoUring)
+    : fd(-1), depth(max(queueDepth, 1u)), preferRing(useIoUring) {}
+
+AsyncPageReader::~AsyncPageReader()
+{
+    Close();
+}
+
+/**
+ * @brief Sets up a ring per open file; falls back to pool reads if that fails.
+ */
+bool AsyncPageReader::Open(const std::string& filename)
+{
+    Close();
+    fd = openForRead(filename);
+    if (fd < 0) return false;
+    if (preferRing) ring = Ring::Create(depth);
+    return true;
+}
+
+/**
+ * @brief The buffers of reads in flight must stay alive until the reads end.
+ */
+void AsyncPageReader::Close()
+{
+    CompletedRead discard;
+    while (WaitNext(discard)) {}
+    ring.reset();
+    if (fd >= 0) closeFd(fd);
+    fd = -1;
+}
+
+size_t AsyncPageReader::InFlight() const
+{
+    return ring ? ring->InFlight() : pending.size();
+}
+
+void AsyncPageReader::WillNeed(long long offset, size_t length) const
+{
+#ifdef POSIX_FADV_WILLNEED
+    if (fd >= 0) posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#else
+    (void)offset;
+    (void)length;
+#endif
+}
+
+bool AsyncPageReader::Submit(uint64_t tag, long long offset, size_t length)
+{
+    if (fd < 0 || InFlight() >= depth) return false;
+    if (ring) return ring->Submit(fd, tag, offset, length);
+
+    int file = fd;
+    pending.push_back(Pending{tag, offset, ThreadPool::Shared().Submit([file, offset, length] {
+        string bytes(length, '\0');
+        size_t got = 0;
+        bool ok = readAt(file, &bytes[0], length, offset, got);
+        bytes.resize(got);
+        return make_pair(ok, move(bytes));
+    })});
+    return true;
+}
+
+bool AsyncPageReader::WaitNext(CompletedRead& out)
+{
+    if (ring) return ring->Reap(out, true);
+    if (pending.empty()) return false;
+
+    Pending next = move(pending.front());
+    pending.pop_front();
+    auto result = ThreadPool::Shared().Wait(next.result);
+    out.tag = next.tag;
+    out.offset = next.offset;
+    out.ok = result.first;
+    out.bytes = move(result.second);
+    return true;
+}
+
+bool AsyncPageReader::PollNext(CompletedRead& out)
+{
+    if (ring) return ring->Reap(out, false);
+    for (auto it = pending.begin(); it != pending.end(); ++it) {
+        if (it->result.wait_for(chrono::seconds(0)) != future_status::ready) continue;
+        auto result = it->result.get();
+        out.tag = it->tag;
+        out.offset = it->offset;
+        out.ok = result.first;
+        out.bytes = move(result.second);
+        pending.erase(it);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file AsyncPageReader.h
+ * @brief Declares the AsyncPageReader class, which keeps many page reads of
+ *        one file in flight at once.
+ *
+ * Reads are submitted with a caller-chosen tag and come back, in whatever
+ * order the device finishes them, through WaitNext() or PollNext(). A
+ * caller that knows which pages it needs next (the following leaves of a
+ * scan, the leaves of a batch of lookups) submits them all before waiting,
+ * so the device works on a queue of requests instead of one at a time.
+ *
+ * On Linux the reads go through io_uring: one system call submits a batch,
+ * and completions are picked up from a ring shared with the kernel. Where
+ * io_uring is missing or not permitted, each read is a positioned read
+ * (pread) run on the shared ThreadPool, so reads still overlap.
+ *
+ * A reader is used by one thread at a time.
+ */
+
+#ifndef ASYNCPAGEREADER_H
+#define ASYNCPAGEREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @struct CompletedRead
+ * @brief One finished read.
+ */
+struct CompletedRead {
+    uint64_t tag = 0;        ///< Tag given to Submit()
+    long long offset = 0;    ///< File offset read
+    std::string bytes;       ///< Bytes read (shorter than asked at the end of the file)
+    bool ok = false;         ///< False if the read failed
+};
+
+/**
+ * @class AsyncPageReader
+ * @brief Queue of outstanding positioned reads on one file.
+ *
+ * Example usage:
+ * @code
+ * AsyncPageReader reader(32);
+ * reader.Open("zip.dat");
+ * for (int rbn = 0; rbn < 8; ++rbn) reader.Submit(rbn, (rbn + 1LL) * blockSize, blockSize);
+ * CompletedRead page;
+ * while (reader.WaitNext(page)) Parse(page.tag, page.bytes);
+ * @endcode
+ */
+class AsyncPageReader {
+private:
+    struct Ring;      ///< io_uring state (Linux only)
+    struct Pending {  ///< A read running on the thread pool
+        uint64_t tag;
+        long long offset;
+        std::future<std::pair<bool, std::string>> result;
+    };
+
+    int fd;                      ///< Read descriptor (-1 = closed)
+    unsigned depth;              ///< Most reads in flight at once
+    bool preferRing;             ///< Try io_uring on Open()
+    std::unique_ptr<Ring> ring;  ///< Set while io_uring is in use
+    std::deque<Pending> pending; ///< Thread-pool reads, oldest first
+
+    /**
+     * @brief Takes one io_uring completion, waiting for it if @p wait.
+     */
+    bool ReapRing(CompletedRead& out, bool wait);
+
+public:
+    /**
+     * @brief Constructs a closed reader.
+     *
+     * @param queueDepth Most reads in flight at once (at least 1)
+     * @param useIoUring false to always use the thread-pool reads
+     */
+    explicit AsyncPageReader(unsigned queueDepth = 32, bool useIoUring = true);
+
+    /**
+     * @brief Waits for the reads in flight, then closes the file.
+     */
+    ~AsyncPageReader();
+
+    AsyncPageReader(const AsyncPageReader&) = delete;
+    AsyncPageReader& operator=(const AsyncPageReader&) = delete;
+
+    /**
+     * @brief Opens @p filename for reading.
+     *
+     * @return true if the file was opened
+     */
+    bool Open(const std::string& filename);
+
+    /**
+     * @brief Waits for the reads in flight and closes the file.
+     */
+    void Close();
+
+    /**
+     * @brief Returns true while a file is open.
+     */
+    bool IsOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Returns true if reads go through io_uring.
+     */
+    bool UsesIoUring() const { return ring != nullptr; }
+
+    /**
+     * @brief Returns the most reads that may be in flight at once.
+     */
+    unsigned GetQueueDepth() const { return depth; }
+
+    /**
+     * @brief Returns the number of reads submitted and not yet returned.
+     */
+    size_t InFlight() const;
+
+    /**
+     * @brief Hints that a range of the file will be read soon (readahead).
+     *
+     * Returns at once. The OS may start loading the range into its page
+     * cache, so that a later read of it completes from memory; on systems
+     * without posix_fadvise() this does nothing.
+     *
+     * @param offset Byte offset of the range
+     * @param length Bytes in the range
+     */
+    void WillNeed(long long offset, size_t length) const;
+
+    /**
+     * @brief Starts reading @p length bytes at @p offset.
+     *
+     * @param tag Returned with the completion
+     * @param offset File offset
+     * @param length Bytes to read
+     * @return false if the file is closed, the queue is full
+     *         (InFlight() == GetQueueDepth()) or the read could not be started
+     */
+    bool Submit(uint64_t tag, long long offset, size_t length);
+
+    /**
+     * @brief Waits for the next finished read.
+     *
+     * @param out Receives the read
+     * @return false if no read is in flight
+     */
+    bool WaitNext(CompletedRead& out);
+
+    /**
+     * @brief Takes a finished read if there is one, without waiting.
+     *
+     * @param out Receives the read
+     * @return false if no read has finished yet
+     */
+    bool PollNext(CompletedRead& out);
+};
+
+#endif // ASYNCPAGEREADER_H
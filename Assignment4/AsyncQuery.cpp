@@ -0,0 +1,273 @@
+/**
+ * @file AsyncQuery.cpp
+ * @brief Implementation of the coroutine query API (C++20).
+ */
+
+#include "AsyncQuery.h"
+
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+/**
+ * @brief The awaiter lives in the suspended coroutine's frame, so its
+ *        address is the read's tag. A read refused with nothing in flight
+ *        would never be retried, so it fails at once.
+ */
+bool IoScheduler::ReadAwaiter::await_suspend(std::coroutine_handle<> waiting)
+{
+    waiter = waiting;
+    if (file < 0 || file >= static_cast<int>(io.files.size())) {
+        result.ok = false;
+        return false;  // resume at once
+    }
+    File& target = io.files[file];
+    if (target.backlog.empty()) {
+        if (target.reader->Submit(reinterpret_cast<uint64_t>(this), offset, length)) return true;
+        if (target.reader->InFlight() == 0) {
+            Fail(*this);
+            return false;  // resume at once
+        }
+    }
+    // Queue full, or behind earlier backlogged reads: Refill() submits it in turn
+    target.backlog.push_back(this);
+    return true;
+}
+
+IoScheduler::IoScheduler(unsigned queueDepth) : depth(max(queueDepth, 1u)) {}
+
+int IoScheduler::OpenFile(const std::string& path)
+{
+    File file;
+    file.path = path;
+    file.reader.reset(new AsyncPageReader(depth));
+    if (!file.reader->Open(path)) {
+        cerr << "Cannot open file: " << path << "\n";
+        return -1;
+    }
+    files.push_back(move(file));
+    return static_cast<int>(files.size()) - 1;
+}
+
+void IoScheduler::WillNeed(int file, long long offset, size_t length) const
+{
+    if (file >= 0 && file < static_cast<int>(files.size())) files[file].reader->WillNeed(offset, length);
+}
+
+void IoScheduler::Complete(CompletedRead& done)
+{
+    ReadAwaiter* read = reinterpret_cast<ReadAwaiter*>(done.tag);
+    read->result = move(done);
+    read->waiter.resume();
+}
+
+void IoScheduler::Fail(ReadAwaiter& read)
+{
+    read.result = CompletedRead();
+    read.result.offset = read.offset;
+    read.result.ok = false;
+}
+
+void IoScheduler::Refill(File& file)
+{
+    while (!file.backlog.empty()) {
+        ReadAwaiter* read = file.backlog.front();
+        if (file.reader->Submit(reinterpret_cast<uint64_t>(read), read->offset, read->length)) {
+            file.backlog.pop_front();
+            continue;
+        }
+        if (file.reader->InFlight() > 0) return;  // queue full; retry when a read ends
+        file.backlog.pop_front();
+        Fail(*read);
+        read->waiter.resume();
+    }
+}
+
+/**
+ * @brief Starts the body right away; it runs until its first read.
+ */
+void IoScheduler::Spawn(Task<void> task)
+{
+    spawned.push_back(move(task));
+    spawned.back().Handle().resume();
+}
+
+/**
+ * @brief Reaps every finished read without blocking; blocks on a busy file
+ *        only when nothing finished. With no read in flight anywhere, the
+ *        reads still in a backlog are failed so their tasks can finish.
+ */
+void IoScheduler::Run()
+{
+    for (;;) {
+        for (size_t i = 0; i < spawned.size();) {
+            if (!spawned[i].IsDone()) {
+                ++i;
+                continue;
+            }
+            exception_ptr error = spawned[i].Handle().promise().error;
+            spawned.erase(spawned.begin() + i);
+            if (error) rethrow_exception(error);
+        }
+        if (spawned.empty()) return;
+
+        bool progressed = false;
+        for (File& file : files) {
+            CompletedRead done;
+            while (file.reader->PollNext(done)) {
+                Complete(done);
+                Refill(file);
+                progressed = true;
+            }
+        }
+        if (progressed) continue;
+
+        auto busy = find_if(files.begin(), files.end(),
+                            [](const File& file) { return file.reader->InFlight() > 0; });
+        if (busy == files.end()) {
+            for (File& file : files) {
+                while (!file.backlog.empty()) {
+                    ReadAwaiter* read = file.backlog.front();
+                    file.backlog.pop_front();
+                    Fail(*read);
+                    read->waiter.resume();
+                    progressed = true;
+                }
+            }
+            if (progressed) continue;
+            cerr << "IoScheduler: tasks are waiting but no read is in flight\n";
+            return;
+        }
+        CompletedRead done;
+        if (busy->reader->WaitNext(done)) {
+            Complete(done);
+            Refill(*busy);
+        }
+    }
+}
+
+AsyncTreeFile::AsyncTreeFile(IoScheduler& scheduler) : io(scheduler), file(-1), meta(1) {}
+
+bool AsyncTreeFile::Open(const std::string& path)
+{
+    file = -1;
+    if (!meta.Open(path)) return false;
+    file = io.OpenFile(path);
+    return file != -1;
+}
+
+Task<std::optional<Block>> AsyncTreeFile::ReadPage(int rbn)
+{
+    const int blockSize = meta.GetBlockSize();
+    CompletedRead done = co_await io.Read(file, (rbn + 1LL) * blockSize, static_cast<size_t>(blockSize));
+    Block page;
+    if (!done.ok || !meta.ParsePage(done.bytes, page) || page.GetRBN() != rbn) {
+        cerr << "Bad block " << rbn << " in file: " << io.GetPath(file) << "\n";
+        co_return nullopt;
+    }
+    co_return page;
+}
+
+/**
+ * @brief Descends from the root one awaited read per level; a file without
+ *        index pages is searched leaf by leaf.
+ */
+Task<std::optional<std::string>> AsyncTreeFile::Search(uint32_t key)
+{
+    if (file == -1) co_return nullopt;
+    string record;
+    if (!meta.HasIndex()) {
+        for (int rbn = 0; rbn < meta.GetPageCount(); ++rbn) {
+            optional<Block> page = co_await ReadPage(rbn);
+            if (!page || page->GetType() == INDEX_BLOCK) break;
+            if (page->FindRecord(key, record)) co_return record;
+        }
+        co_return nullopt;
+    }
+
+    int rbn = meta.GetRootRBN();
+    while (rbn != -1) {
+        optional<Block> page = co_await ReadPage(rbn);
+        if (!page) break;
+        if (page->GetType() == INDEX_BLOCK) {
+            rbn = TreeFileReader::ChildFor(*page, key);
+        } else {
+            if (page->FindRecord(key, record)) co_return record;
+            break;
+        }
+    }
+    co_return nullopt;
+}
+
+/**
+ * @brief Stops at the first leaf that starts beyond @p high; the result is
+ *        sorted in case the leaf chain is not in key order.
+ */
+Task<std::vector<std::string>> AsyncTreeFile::RangeScan(uint32_t low, uint32_t high)
+{
+    vector<pair<uint32_t, string>> hits;
+    auto collect = [&](const Block& leaf) {
+        const auto& keys = leaf.GetKeys();
+        for (size_t slot = 0; slot < keys.size(); ++slot) {
+            if (keys[slot] >= low && keys[slot] <= high) hits.emplace_back(keys[slot], leaf.getRecords()[slot]);
+        }
+    };
+
+    if (file != -1 && !meta.HasIndex()) {
+        for (int rbn = 0; rbn < meta.GetPageCount(); ++rbn) {
+            optional<Block> page = co_await ReadPage(rbn);
+            if (!page || page->GetType() == INDEX_BLOCK) break;
+            collect(*page);
+        }
+    } else if (file != -1 && low <= high) {
+        int rbn = meta.GetRootRBN();
+        while (rbn != -1) {
+            optional<Block> page = co_await ReadPage(rbn);
+            if (!page) break;
+            if (page->GetType() == INDEX_BLOCK) {
+                rbn = TreeFileReader::ChildFor(*page, low);
+                continue;
+            }
+            const auto& keys = page->GetKeys();
+            if (!keys.empty() && keys.front() > high) break;
+            rbn = (!keys.empty() && keys.back() >= high) ? -1 : page->GetNextRBN();
+            if (rbn != -1) io.WillNeed(file, (rbn + 1LL) * meta.GetBlockSize(), static_cast<size_t>(meta.GetBlockSize()));
+            collect(*page);
+        }
+    }
+
+    stable_sort(hits.begin(), hits.end(),
+                [](const pair<uint32_t, string>& a, const pair<uint32_t, string>& b) { return a.first < b.first; });
+    vector<string> records;
+    records.reserve(hits.size());
+    for (auto& hit : hits) records.push_back(move(hit.second));
+    co_return records;
+}
+
+/**
+ * @brief Reads a fixed window like readRecordsAtOffsets(); a record longer
+ *        than the window is read again with readRecordAtOffset().
+ */
+Task<std::optional<buffer>> readRecordAtOffsetAsync(IoScheduler& io, int file, std::streampos offset)
+{
+    const size_t window = 512;
+    CompletedRead done = co_await io.Read(file, static_cast<long long>(offset), window);
+    if (!done.ok) co_return nullopt;
+
+    buffer record;
+    bool found;
+    size_t end = done.bytes.find('\n');
+    if (end != string::npos)
+        found = unpackRecord(done.bytes.substr(0, end), record);
+    else if (done.bytes.size() < window)
+        found = unpackRecord(done.bytes, record);  // last line without a newline
+    else
+        found = readRecordAtOffset(io.GetPath(file), offset, record);
+    if (!found) co_return nullopt;
+    co_return record;
+}
+
+#endif // __cpp_impl_coroutine
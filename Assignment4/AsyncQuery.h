@@ -0,0 +1,358 @@
+/**
+ * @file AsyncQuery.h
+ * @brief Declares the coroutine query API: Task, IoScheduler and
+ *        AsyncTreeFile (C++20).
+ *
+ * A lookup written as a coroutine reads like the blocking version, but each
+ * page read is a co_await: the coroutine is suspended while the read is in
+ * flight and the thread runs other lookups meanwhile. One IoScheduler on one
+ * thread can so keep thousands of lookups going with its AsyncPageReader
+ * queues full, without a thread per request and without callbacks. A
+ * service that wants more threads runs one scheduler on each.
+ *
+ * @code
+ * IoScheduler io;
+ * AsyncTreeFile tree(io);
+ * tree.Open("zip_bptree.dat");
+ * for (uint32_t zip : requests) {
+ *     io.Spawn([](AsyncTreeFile& t, uint32_t key) -> Task<void> {
+ *         std::optional<std::string> row = co_await t.Search(key);
+ *         Reply(key, row);
+ *     }(tree, zip));
+ * }
+ * io.Run();   // returns when every lookup has finished
+ * @endcode
+ *
+ * Everything here needs C++20 coroutines (g++ -std=c++20); compiled as
+ * C++17 the header and AsyncQuery.cpp are empty, so the rest of the
+ * program builds as before.
+ */
+
+#ifndef ASYNCQUERY_H
+#define ASYNCQUERY_H
+
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AsyncPageReader.h"
+#include "TreeFileReader.h"
+#include "buffer.h"
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+/**
+ * @brief Promise parts shared by Task<T> and Task<void>.
+ */
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation;  ///< Coroutine awaiting this task (none when spawned)
+    std::exception_ptr error;              ///< Exception that ended the task
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    /**
+     * @brief Resumes the awaiting coroutine directly (symmetric transfer).
+     */
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> done) noexcept
+        {
+            std::coroutine_handle<> next = done.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    std::optional<T> value;  ///< co_return value
+
+    Task<T> get_return_object();
+    void return_value(T result) { value = std::move(result); }
+    T Take()
+    {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void Take()
+    {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @class Task
+ * @brief Lazily started coroutine producing a @p T; co_await it for the result.
+ *
+ * The body starts when the task is first awaited (or spawned on an
+ * IoScheduler). A Task owns its coroutine frame and is move-only.
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle;  ///< Coroutine frame (null once moved from)
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (handle) handle.destroy();
+    }
+
+    /**
+     * @brief Returns true once the body has run to its end.
+     */
+    bool IsDone() const { return !handle || handle.done(); }
+
+    /**
+     * @brief Returns the coroutine frame (used by IoScheduler).
+     */
+    std::coroutine_handle<promise_type> Handle() const { return handle; }
+
+    bool await_ready() const noexcept { return false; }
+
+    /**
+     * @brief Starts the body; it resumes the awaiting coroutine when done.
+     */
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    /**
+     * @brief Returns the co_return value (rethrows the body's exception).
+     */
+    T await_resume() { return handle.promise().Take(); }
+};
+
+namespace detail {
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+} // namespace detail
+
+/**
+ * @class IoScheduler
+ * @brief Single-threaded event loop that resumes coroutines as their page
+ *        reads finish.
+ *
+ * Reads beyond a file's queue depth wait in a backlog and are submitted as
+ * earlier reads finish.
+ */
+class IoScheduler {
+public:
+    /**
+     * @brief Awaitable page read (see Read()); yields a CompletedRead.
+     */
+    class ReadAwaiter {
+    private:
+        IoScheduler& io;                 ///< Scheduler that submits the read
+        int file;                        ///< File id
+        long long offset;                ///< Byte offset to read at
+        size_t length;                   ///< Bytes to read
+        std::coroutine_handle<> waiter;  ///< Coroutine suspended on the read
+        CompletedRead result;            ///< Filled in when the read ends
+
+        friend class IoScheduler;
+
+    public:
+        ReadAwaiter(IoScheduler& scheduler, int fileId, long long at, size_t bytes)
+            : io(scheduler), file(fileId), offset(at), length(bytes) {}
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> waiting);
+        CompletedRead await_resume() { return std::move(result); }
+    };
+
+private:
+    /// One open file: its reader and the reads waiting for queue space
+    struct File {
+        std::string path;
+        std::unique_ptr<AsyncPageReader> reader;
+        std::deque<ReadAwaiter*> backlog;
+    };
+
+    unsigned depth;                   ///< Queue depth of each file's reader
+    std::vector<File> files;          ///< Open files, indexed by file id
+    std::vector<Task<void>> spawned;  ///< Tasks started by Spawn()
+
+    /**
+     * @brief Submits backlogged reads of @p file while its queue has room.
+     *
+     * A read the reader refuses with nothing in flight is failed (ok =
+     * false) rather than left waiting forever.
+     */
+    void Refill(File& file);
+
+    /**
+     * @brief Marks @p read as failed (ok = false) without resuming it.
+     */
+    static void Fail(ReadAwaiter& read);
+
+    /**
+     * @brief Resumes the coroutine waiting for @p done.
+     */
+    static void Complete(CompletedRead& done);
+
+public:
+    /**
+     * @brief Constructs a scheduler with no files.
+     *
+     * @param queueDepth Reads kept in flight per file
+     */
+    explicit IoScheduler(unsigned queueDepth = 64);
+
+    /**
+     * @brief Opens a file for co_await Read().
+     *
+     * @return File id, or -1 if the file cannot be opened
+     */
+    int OpenFile(const std::string& path);
+
+    /**
+     * @brief Returns the path of file @p file.
+     */
+    const std::string& GetPath(int file) const { return files[file].path; }
+
+    /**
+     * @brief Returns an awaitable that reads @p length bytes at @p offset.
+     */
+    ReadAwaiter Read(int file, long long offset, size_t length) { return ReadAwaiter(*this, file, offset, length); }
+
+    /**
+     * @brief Hints that file @p file will be read at @p offset soon (see AsyncPageReader::WillNeed()).
+     */
+    void WillNeed(int file, long long offset, size_t length) const;
+
+    /**
+     * @brief Starts @p task; Run() drives it to completion.
+     */
+    void Spawn(Task<void> task);
+
+    /**
+     * @brief Runs until every spawned task has finished.
+     *
+     * Rethrows the exception of a spawned task that failed; the other tasks
+     * stay spawned, and calling Run() again continues them.
+     */
+    void Run();
+
+    /**
+     * @brief Runs @p task (and any spawned tasks) to completion and returns its result.
+     */
+    template <typename T>
+    T RunUntilComplete(Task<T> task)
+    {
+        std::optional<T> result;
+        Spawn([](Task<T> inner, std::optional<T>& out) -> Task<void> {
+            out = co_await std::move(inner);
+        }(std::move(task), result));
+        Run();
+        return std::move(*result);
+    }
+};
+
+/**
+ * @class AsyncTreeFile
+ * @brief Coroutine lookups and range scans on a BPlusTree file on disk.
+ *
+ * Reads pages on demand like TreeFileReader, so it sees the file as of its
+ * last checkpoint.
+ */
+class AsyncTreeFile {
+private:
+    IoScheduler& io;      ///< Scheduler the reads go through
+    int file;             ///< File id in io
+    TreeFileReader meta;  ///< Header, root and page parsing
+
+    /**
+     * @brief Reads and parses page @p rbn; empty if it cannot be read.
+     */
+    Task<std::optional<Block>> ReadPage(int rbn);
+
+public:
+    /**
+     * @brief Constructs a closed tree file on @p scheduler.
+     */
+    explicit AsyncTreeFile(IoScheduler& scheduler);
+
+    /**
+     * @brief Opens a tree file (reads its header page and finds the root).
+     *
+     * @return true if the file was opened
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * @brief Looks up one ZIP code.
+     *
+     * @return The record, or empty if not found or a page could not be read
+     */
+    Task<std::optional<std::string>> Search(uint32_t key);
+
+    /**
+     * @brief Collects the records with keys in [@p low, @p high], in key order.
+     *
+     * Descends to the first leaf that may hold @p low, then follows the
+     * leaf chain; the next leaf is hinted for readahead while the current
+     * one is filtered.
+     */
+    Task<std::vector<std::string>> RangeScan(uint32_t low, uint32_t high);
+};
+
+/**
+ * @brief Coroutine form of readRecordAtOffset().
+ *
+ * @param io Scheduler the read goes through
+ * @param file Id of a length-indicated file opened with io.OpenFile()
+ * @param offset Byte position where the record begins
+ * @return The record, or empty if it could not be read
+ */
+Task<std::optional<buffer>> readRecordAtOffsetAsync(IoScheduler& io, int file, std::streampos offset);
+
+#endif // __cpp_impl_coroutine
+
+#endif // ASYNCQUERY_H
@@ -4,9 +4,14 @@
  */
 
 #include "BPlusTree.h"
+#include "Prefetch.h"
+#include "ThreadPool.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace std;
 
@@ -15,33 +20,331 @@ using namespace std;
  *
  * @param fname Path to the file where blocks will be written
  * @param blkSize Size of each block in bytes (e.g., 512)
+ * @param codec Page codec for the leaf level
  */
-BPlusTree::BPlusTree(const std::string& fname, int blkSize)
-    : rootRBN(-1), blockSize(blkSize), filename(fname), seqSet(fname)
+BPlusTree::BPlusTree(const std::string& fname, int blkSize, PageCodecType codec)
+    : rootRBN(-1), blockSize(blkSize), treeHeight(0), indexStale(false),
+      filename(fname), seqSet(fname, blkSize, codec), firstIndexRBN(0),
+      useLearnedIndex(false), replaying(false), checkpointInterval(1000), changesSinceCheckpoint(0)
 {
     // Initialize the blocked sequence set for the B+ tree
 }
 
+/**
+ * @brief Extracts the child RBN from an index entry "key,childRBN".
+ *
+ * @param entry Index entry string
+ * @return Child RBN
+ */
+static int childRBN(const std::string& entry)
+{
+    return atoi(entry.c_str() + entry.find(',') + 1);
+}
+
+/**
+ * @brief Parses the ZIP field of a record with Block::ParseKey().
+ *
+ * @param record Record whose first field is the ZIP
+ * @param zip Set to the ZIP when it is valid
+ * @return true if the first field is only digits and fits in 32 bits
+ */
+static bool recordKey(const std::string& record, uint32_t& zip)
+{
+    return Block::ParseKey(record.substr(0, record.find(',')), zip);
+}
+
+/**
+ * @brief Picks the separator with the most trailing zeros in [low, high).
+ *
+ * @param low Highest key of the left child
+ * @param high Lowest key of the right child (> low)
+ * @return Shortest separator s with low <= s < high
+ */
+static uint32_t shortestSeparator(uint32_t low, uint32_t high)
+{
+    for (uint64_t unit = 1000000000; unit > 1; unit /= 10) {
+        uint64_t rounded = (low + unit - 1) / unit * unit;
+        if (rounded < high) return static_cast<uint32_t>(rounded);
+    }
+    return low;
+}
+
 /**
  * @brief Builds the complete static B+ tree index.
  *
  * After all records have been inserted into the sequence set,
- * this method creates the index structure on top of it.
+ * this method sorts it and creates the index structure on top of it.
  */
 void BPlusTree::BuildStaticIndex()
 {
-    // Write the sequence set to file first
-    seqSet.WriteToFile();
-    
-    // For now, the sequence set itself serves as the leaf level (RBN = 0)
-    rootRBN = 0;
-    
-    // In a full B+ tree implementation, you would:
-    // 1. Build intermediate index blocks from the leaf blocks
-    // 2. Recursively build higher levels until a single root is reached
-    // 3. Update metadata about tree height and structure
-    
-    std::cout << "[BPlusTree::BuildStaticIndex] Tree built with root RBN = " << rootRBN << std::endl;
+    std::lock_guard<std::mutex> writer(writerMutex);
+    {
+        std::unique_lock<SharedLatch> tree(treeLatch);
+
+        // Leaves must be in key order before separators can be taken from them
+        seqSet.SortByKey();
+        BuildIndexLevels();
+    }
+    FinishBuild();
+}
+
+/**
+ * @brief Appends to the tail leaf; checks the order as the records go by.
+ */
+bool BPlusTree::BulkLoad(const std::function<bool(std::string&)>& next)
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    bool allStored = true;
+    {
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        seqSet.Clear();
+        keyFilter = BloomFilter();  // the old filter would reject new keys until FinishBuild()
+        std::remove((filename + ".bloom").c_str());
+        std::string record;
+        uint32_t prevKey = 0;
+        bool sorted = true;
+        while (next(record)) {
+            uint32_t key;
+            if (!recordKey(record, key)) {
+                std::cerr << "Record without a valid ZIP skipped: " << record.substr(0, record.find(',')) << "\n";
+                allStored = false;
+                continue;
+            }
+            if (key < prevKey) sorted = false;
+            prevKey = key;
+            seqSet.AddRecord(record);
+        }
+        if (!sorted) seqSet.SortByKey();
+        BuildIndexLevels();
+    }
+    FinishBuild();
+    return allStored;
+}
+
+void BPlusTree::FinishBuild()
+{
+    // Build the negative-lookup filter over every stored key first: records
+    // added through the sequence set are not in the old one, and Checkpoint()
+    // writes the filter before the pages, so a crash never leaves pages
+    // beside a filter that lacks their keys
+    {
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        BuildKeyFilter();
+    }
+
+    // Write the filter, header, leaves and index pages
+    Checkpoint();
+
+    std::cout << "[BPlusTree::BuildStaticIndex] Tree built with root RBN = " << rootRBN
+              << ", height = " << treeHeight << std::endl;
+}
+
+/**
+ * @brief Sizes the key filter for the current records and adds every key.
+ */
+void BPlusTree::BuildKeyFilter()
+{
+    keyFilter = BloomFilter(seqSet.GetTotalRecords());
+    // add() sets bits atomically, so leaves can be added from several threads
+    ThreadPool::Shared().ParallelFor(0, seqSet.GetTotalBlocks(), 64, [this](size_t lo, size_t hi) {
+        for (size_t rbn = lo; rbn < hi; ++rbn) {
+            for (uint32_t zip : seqSet.GetBlock(static_cast<int>(rbn)).GetKeys()) keyFilter.add(zip);
+        }
+    });
+}
+
+/**
+ * @brief Packs the index levels bottom-up over the leaf chain.
+ */
+void BPlusTree::BuildIndexLevels()
+{
+    indexBlocks.clear();
+    firstIndexRBN = seqSet.GetTotalBlocks();
+    indexStale = false;
+
+    // Level 0: (separator, RBN) of every non-empty leaf in chain order
+    std::vector<std::pair<uint32_t, int>> level;
+    for (int rbn = seqSet.GetHeadRBN(); rbn != -1; rbn = seqSet.GetBlock(rbn).GetNextRBN()) {
+        const Block& leaf = seqSet.GetBlock(rbn);
+        if (leaf.GetRecordCount() == 0) continue;
+        if (!level.empty()) {
+            // Truncate the previous separator now that the next lowest key is known
+            level.back().first = shortestSeparator(level.back().first, leaf.GetKeys().front());
+        }
+        level.emplace_back(leaf.GetHighestKeyValue(), rbn);
+    }
+
+    leafSeparators.clear();
+    leafRBNs.clear();
+    for (const auto& entry : level) {
+        leafSeparators.push_back(entry.first);
+        leafRBNs.push_back(entry.second);
+    }
+    TrainLeafModel();
+
+    treeHeight = level.empty() ? 0 : 1;
+    rootRBN = level.empty() ? -1 : level.front().second;
+
+    while (level.size() > 1) {
+        std::vector<std::pair<uint32_t, int>> parents;
+        int prevRBN = -1;
+
+        for (const auto& entry : level) {
+            std::string rec = to_string(entry.first) + "," + to_string(entry.second);
+            if (prevRBN == -1 || !indexBlocks.back().HasSpace(rec)) {
+                int rbn = firstIndexRBN + static_cast<int>(indexBlocks.size());
+                Block node(rbn, blockSize);
+                node.SetType(INDEX_BLOCK);
+                node.SetPrevRBN(prevRBN);
+                if (prevRBN != -1) indexBlocks.back().SetNextRBN(rbn);
+                indexBlocks.push_back(node);
+                parents.emplace_back(0, rbn);
+                prevRBN = rbn;
+            }
+            indexBlocks.back().AddRecord(rec);
+            parents.back().first = entry.first;
+        }
+
+        level.swap(parents);
+        ++treeHeight;
+    }
+
+    if (!level.empty()) rootRBN = level.front().second;
+}
+
+void BPlusTree::TrainLeafModel()
+{
+    if (useLearnedIndex) leafModel.buildIndex(leafSeparators);
+}
+
+void BPlusTree::LoadLeafModel()
+{
+    if (!useLearnedIndex) return;
+    std::string modelFile = filename + ".pgm";
+    if (!std::ifstream(modelFile).is_open() || !leafModel.readFromFile(modelFile) ||
+        !leafModel.fits(leafSeparators)) {
+        TrainLeafModel();
+    }
+}
+
+void BPlusTree::SetLearnedIndex(bool enabled)
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    std::unique_lock<SharedLatch> tree(treeLatch);
+    if (enabled == useLearnedIndex) return;
+    useLearnedIndex = enabled;
+    TrainLeafModel();
+}
+
+/**
+ * @brief Checks the stored levels top-down, then swaps them in.
+ */
+bool BPlusTree::AdoptIndexPages(std::vector<Block>& pages)
+{
+    const int height = seqSet.GetIndexHeight();
+    const int root = seqSet.GetIndexRootRBN();
+    const int first = seqSet.GetTotalBlocks();
+    const int end = first + static_cast<int>(pages.size());
+    if (height < 1 || height > static_cast<int>(pages.size()) + 1) return false;
+
+    std::vector<int> level(1, root);
+    std::vector<uint32_t> separators;  // of the level being collected
+    for (int depth = height; depth > 1; --depth) {
+        std::vector<int> children;
+        separators.clear();
+        for (int rbn : level) {
+            if (rbn < first || rbn >= end) return false;
+            const Block& node = pages[rbn - first];
+            for (const std::string& entry : node.getRecords()) children.push_back(childRBN(entry));
+            separators.insert(separators.end(), node.GetKeys().begin(), node.GetKeys().end());
+            if (static_cast<int>(children.size()) > end) return false;  // more children than pages
+        }
+        level.swap(children);
+    }
+    for (int rbn : level) {
+        if (rbn < 0 || rbn >= first || seqSet.GetBlock(rbn).GetType() != LEAF_BLOCK) return false;
+    }
+    if (height == 1) separators.push_back(seqSet.GetBlock(root).GetHighestKeyValue());
+
+    // The bottom level's entries are the leaves' separators in chain order
+    leafSeparators.swap(separators);
+    leafRBNs.swap(level);
+    LoadLeafModel();
+    indexBlocks.swap(pages);
+    firstIndexRBN = first;
+    rootRBN = root;
+    treeHeight = height;
+    indexStale = false;
+    return true;
+}
+
+/**
+ * @brief Group prefetching down the index pages, or the learned model when enabled.
+ *
+ * In every index block the first entry whose key is >= the key names the
+ * child to follow; the model finds the same entry of the bottom level.
+ */
+void BPlusTree::FindLeaves(const uint32_t* key, size_t n, int* at) const
+{
+    if (useLearnedIndex && treeHeight > 1) {
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] == -1) continue;
+            int pos = leafModel.findPosition(key[i], leafSeparators);
+            at[i] = pos == -1 ? -1 : leafRBNs[pos];
+        }
+        return;
+    }
+
+    int slot[SEARCH_GROUP];  // entry found on each lookup's page
+    for (size_t i = 0; i < n; ++i) {
+        if (at[i] != -1) at[i] = rootRBN;
+    }
+    for (int level = treeHeight; level > 1; --level) {
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] != -1) indexBlocks[at[i] - firstIndexRBN].PrefetchKeys();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] == -1) continue;
+            const Block& node = indexBlocks[at[i] - firstIndexRBN];
+            const auto& nodeKeys = node.GetKeys();
+            auto it = lower_bound(nodeKeys.begin(), nodeKeys.end(), key[i]);
+            if (it == nodeKeys.end()) {
+                at[i] = -1;
+                continue;
+            }
+            slot[i] = static_cast<int>(it - nodeKeys.begin());
+            PrefetchLine(&node.getRecords()[slot[i]]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] == -1) continue;
+            at[i] = childRBN(indexBlocks[at[i] - firstIndexRBN].getRecords()[slot[i]]);
+            if (level > 2) PrefetchLine(&indexBlocks[at[i] - firstIndexRBN]);
+        }
+    }
+}
+
+int BPlusTree::FindLeaf(uint32_t key) const
+{
+    int leaf = 0;
+    FindLeaves(&key, 1, &leaf);
+    return leaf;
+}
+
+/**
+ * @brief Shared tree latch; the index is rebuilt under an exclusive one if stale.
+ */
+std::shared_lock<SharedLatch> BPlusTree::LatchIndex()
+{
+    std::shared_lock<SharedLatch> tree(treeLatch);
+    while (indexStale) {
+        tree.unlock();
+        {
+            std::unique_lock<SharedLatch> rebuild(treeLatch);
+            if (indexStale) BuildIndexLevels();
+        }
+        tree.lock();
+    }
+    return tree;
 }
 
 /**
@@ -49,13 +352,78 @@ void BPlusTree::BuildStaticIndex()
  *
  * @param record String record to insert (comma-separated fields)
  */
-void BPlusTree::Insert(const std::string& record)
+bool BPlusTree::Insert(const std::string& record)
 {
-    // Add record to the sequence set
-    seqSet.AddRecord(record);
-    
-    // Note: In a dynamic B+ tree, we would check for block overflow and rebalance
-    // For this static implementation, we just add to the sequence set
+    std::lock_guard<std::mutex> writer(writerMutex);
+    return ApplyInsert(record);
+}
+
+/**
+ * @brief Inserts under a leaf latch if the record fits, else under the tree latch.
+ *
+ * @param record String record to insert (comma-separated fields)
+ * @return false, with nothing stored, if the record's key is not a ZIP, it is
+ *         too large for a block or it could not be logged
+ */
+bool BPlusTree::ApplyInsert(const std::string& record)
+{
+    // A key that is not a 32-bit ZIP would be stored under some other ZIP
+    uint32_t zip;
+    if (!recordKey(record, zip)) return false;
+    if (!seqSet.FitsBlock(record)) {
+        std::cerr << "Record too large for " << blockSize << "-byte blocks: " << zip << "\n";
+        return false;
+    }
+
+    // Logged before the tree changes, so a record that is not logged is not stored;
+    // pages reach the file only at a checkpoint, which commits the log first
+    bool logged = wal.IsOpen() && !replaying;
+    if (logged && wal.Append('I', record) == 0) return false;
+
+    bool inserted = false;
+    {
+        std::shared_lock<SharedLatch> tree = LatchIndex();
+        int leaf = (treeHeight == 0) ? -1 : FindLeaf(zip);
+        if (leaf != -1 && seqSet.GetBlock(leaf).HasSpace(record)) {
+            // Fits its leaf: no separator changes, so only that page is latched
+            if (keyFilter.IsBuilt()) keyFilter.add(zip);
+            std::unique_lock<SharedLatch> page(LeafLatch(leaf));
+            seqSet.InsertIntoBlock(leaf, record);
+            inserted = true;
+        }
+    }
+
+    if (!inserted) {
+        // Split, new highest key or no index yet: the structure changes with readers held off
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        if (treeHeight == 0) {
+            // Not built yet: any leaf with room will do, the build sorts them
+            seqSet.InsertWhereFits(record);
+        } else {
+            if (indexStale) BuildIndexLevels();
+
+            int leaf = FindLeaf(zip);
+            if (leaf == -1) {
+                // Key beyond the last separator: goes to the tail leaf, separators change
+                leaf = seqSet.GetTailRBN();
+                indexStale = true;
+            }
+
+            // A split takes the head of the avail list or a new page at the end
+            int blocksBefore = seqSet.GetTotalBlocks();
+            int availBefore = seqSet.GetAvailHead();
+            seqSet.InsertIntoBlock(leaf, record);
+            if (seqSet.GetTotalBlocks() != blocksBefore || seqSet.GetAvailHead() != availBefore) indexStale = true;
+
+            // Keep the key filter complete once it has been built
+            if (keyFilter.IsBuilt()) {
+                keyFilter.add(zip);
+            }
+        }
+    }
+
+    if (logged) NoteLoggedChange();
+    return true;
 }
 
 /**
@@ -67,26 +435,87 @@ void BPlusTree::Insert(const std::string& record)
  */
 bool BPlusTree::Search(const std::string& key, std::string& outRecord)
 {
-    // For a static tree with sequence set as root, search the sequence set directly
-    // In a full B+ tree, this would traverse from root through index blocks to find
-    // the appropriate leaf block, then search within that leaf.
-    
-    // For now, we search all records in the sequence set
-    const auto& records = seqSet.getRecords();
-    
-    for (const auto& recStr : records) {
-        // Extract ZIP code (first field before comma)
-        size_t commaPos = recStr.find(',');
-        if (commaPos != string::npos) {
-            string recordKey = recStr.substr(0, commaPos);
-            if (recordKey == key) {
-                outRecord = recStr;
-                return true;
-            }
+    // Reject malformed and absent keys before any block access
+    uint32_t zip = 0;
+    if (!Block::ParseKey(key, zip)) return false;
+
+    std::shared_lock<SharedLatch> tree = LatchIndex();
+    if (!keyFilter.mayContain(zip)) return false;
+
+    // Before the index is built, fall back to probing every leaf
+    if (treeHeight == 0) return seqSet.Search(zip, outRecord);
+
+    int leaf = FindLeaf(zip);
+    if (leaf == -1) return false;
+    std::shared_lock<SharedLatch> page(LeafLatch(leaf));
+    return seqSet.GetBlock(leaf).FindRecord(zip, outRecord);
+}
+
+/**
+ * @brief Group prefetching: every pass over the group prefetches what the
+ *        next pass reads.
+ *
+ * The group's distinct leaf latch stripes are taken together (each once,
+ * as a waiting writer would block a second shared hold of the same latch).
+ */
+void BPlusTree::SearchBatch(const std::vector<uint32_t>& keys, std::vector<std::string>& outRecords,
+                            std::vector<char>& found)
+{
+    outRecords.assign(keys.size(), std::string());
+    found.assign(keys.size(), 0);
+
+    std::shared_lock<SharedLatch> tree = LatchIndex();
+    if (treeHeight == 0) {
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (keyFilter.mayContain(keys[i])) found[i] = seqSet.Search(keys[i], outRecords[i]);
+        }
+        return;
+    }
+
+    int at[SEARCH_GROUP];    // page each lookup is on (-1 once it has failed)
+    int slot[SEARCH_GROUP];  // record found on that leaf
+    for (size_t base = 0; base < keys.size(); base += SEARCH_GROUP) {
+        const size_t n = std::min<size_t>(SEARCH_GROUP, keys.size() - base);
+        const uint32_t* key = &keys[base];
+
+        for (size_t i = 0; i < n; ++i) keyFilter.prefetch(key[i]);
+        for (size_t i = 0; i < n; ++i) at[i] = keyFilter.mayContain(key[i]) ? 0 : -1;
+        FindLeaves(key, n, at);
+
+        int stripes[SEARCH_GROUP];
+        size_t stripeCount = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] != -1) stripes[stripeCount++] = at[i] % LEAF_LATCH_COUNT;
+        }
+        std::sort(stripes, stripes + stripeCount);
+        stripeCount = std::unique(stripes, stripes + stripeCount) - stripes;
+        std::shared_lock<SharedLatch> pages[SEARCH_GROUP];
+        for (size_t s = 0; s < stripeCount; ++s) {
+            pages[s] = std::shared_lock<SharedLatch>(leafLatches[stripes[s]]);
+        }
+
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] != -1) PrefetchLine(&seqSet.GetBlock(at[i]));
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] != -1) seqSet.GetBlock(at[i]).PrefetchKeys();
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] == -1) continue;
+            const Block& leaf = seqSet.GetBlock(at[i]);
+            slot[i] = leaf.FindSlot(key[i]);
+            if (slot[i] < 0) at[i] = -1;
+            else PrefetchLine(&leaf.getRecords()[slot[i]]);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] != -1) PrefetchLine(seqSet.GetBlock(at[i]).getRecords()[slot[i]].data());
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (at[i] == -1) continue;
+            outRecords[base + i] = seqSet.GetBlock(at[i]).getRecords()[slot[i]];
+            found[base + i] = 1;
         }
     }
-    
-    return false;
 }
 
 /**
@@ -97,9 +526,217 @@ bool BPlusTree::Search(const std::string& key, std::string& outRecord)
  */
 bool BPlusTree::Delete(const std::string& key)
 {
-    // This would require modifying the BlockedSequenceSet to support deletion
-    // For now, return false
-    return false;
+    uint32_t zip;
+    if (!Block::ParseKey(key, zip)) return false;  // before waiting on the writer
+    std::lock_guard<std::mutex> writer(writerMutex);
+    return ApplyDelete(key);
+}
+
+/**
+ * @brief Deletes under the leaf's latch (under the tree latch before the index exists).
+ *
+ * A leaf left empty is then freed under the tree latch, since its
+ * neighbours' links change, and the index is rebuilt on next use.
+ *
+ * @param key Primary key value of the record to delete
+ * @return true if record found, logged and deleted; false, with nothing
+ *         deleted, if not found, not a ZIP, or the log could not be written
+ */
+bool BPlusTree::ApplyDelete(const std::string& key)
+{
+    uint32_t zip;
+    if (!Block::ParseKey(key, zip)) return false;
+
+    // Only a delete that will happen is logged, and before the tree changes;
+    // the writer mutex keeps the record in place in between
+    bool logged = wal.IsOpen() && !replaying;
+    if (logged) {
+        std::string record;
+        if (!Search(key, record) || wal.Append('D', key) == 0) return false;
+    }
+
+    bool deleted = false;
+    int emptied = -1;
+    {
+        std::shared_lock<SharedLatch> tree = LatchIndex();
+        if (treeHeight > 0) {
+            // Separators stay valid upper bounds after a delete, so only the leaf is latched
+            int leaf = FindLeaf(zip);
+            if (leaf != -1) {
+                std::unique_lock<SharedLatch> page(LeafLatch(leaf));
+                deleted = seqSet.DeleteFromBlock(leaf, zip);
+                if (deleted && seqSet.GetBlock(leaf).GetRecordCount() == 0) emptied = leaf;
+            }
+        } else {
+            tree.unlock();
+            std::unique_lock<SharedLatch> scan(treeLatch);
+            deleted = seqSet.Delete(key);
+        }
+    }
+
+    if (emptied != -1) {
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        if (seqSet.FreeBlock(emptied)) indexStale = true;
+    }
+
+    if (logged) NoteLoggedChange();
+    return deleted;
+}
+
+/**
+ * @brief Checkpoints once checkpointInterval changes have been logged.
+ */
+void BPlusTree::NoteLoggedChange()
+{
+    if (++changesSinceCheckpoint >= checkpointInterval) Checkpoint();
+}
+
+void BPlusTree::WriteToFile()
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    Checkpoint();
+}
+
+/**
+ * @brief Writes header, leaf pages and index pages to the tree's file.
+ *
+ * With the log enabled this is a checkpoint (see BPlusTree.h). Readers keep
+ * going while the pages are written: only the writer changes blocks, and it
+ * is busy here.
+ */
+void BPlusTree::Checkpoint()
+{
+    {
+        // Splitting a leaf that does not compress into its page changes the separators
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        if (seqSet.SplitOverfullBlocks() > 0) indexStale = true;
+        if (indexStale) BuildIndexLevels();
+    }
+    std::shared_lock<SharedLatch> tree(treeLatch);
+
+    // Every logged change is in the pages about to be written. If the log
+    // has failed they are the only durable copy, and Truncate() restarts it.
+    if (wal.IsOpen()) {
+        wal.Commit();
+        seqSet.SetCheckpointLSN(wal.GetLastLSN());
+    }
+    seqSet.SetIndexRoot(rootRBN, treeHeight);
+
+    // The filter goes first: if the pages are not written it only holds extra keys
+    if (keyFilter.IsBuilt() && !keyFilter.writeToFile(filename + ".bloom")) return;
+    // A model that does not match the pages written is retrained by Open()
+    if (useLearnedIndex && treeHeight > 1) leafModel.writeToFile(filename + ".pgm");
+
+    if (seqSet.IsFileCurrent()) {
+        // In place: header page, changed leaves and rebuilt index pages only
+        PageFile file;
+        if (!file.Open(filename)) {
+            std::cerr << "Cannot open file: " << filename << "\n";
+            return;
+        }
+        seqSet.StageDirtyPages(file);
+        for (const Block& node : indexBlocks) {
+            if (node.IsDirty()) file.Stage(static_cast<long long>(node.GetRBN() + 1) * blockSize, node.Serialize());
+        }
+        long long pages = 1LL + seqSet.GetTotalBlocks() + static_cast<long long>(indexBlocks.size());
+        if (!file.Commit(true, pages * blockSize)) return;  // dirty flags kept for the next attempt
+    } else {
+        // A journal left by a failed in-place commit would be replayed over the new file
+        if (!PageFile::Recover(filename)) return;
+        std::string tempFile = filename + ".tmp";
+        std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Cannot open file: " << tempFile << "\n";
+            return;
+        }
+        bool written = seqSet.Write(out);
+        for (const Block& node : indexBlocks) node.Write(out);
+        written = written && out.good();
+        out.close();
+
+        if (!written || !WriteAheadLog::ReplaceFile(tempFile, filename)) {
+            std::cerr << "Cannot write file: " << filename << "\n";
+            return;
+        }
+    }
+    seqSet.MarkClean();
+    for (Block& node : indexBlocks) node.ClearDirty();
+
+    if (wal.IsOpen()) {
+        wal.Truncate();
+        changesSinceCheckpoint = 0;
+    }
+}
+
+/**
+ * @brief Creates a fresh log for the tree's current state.
+ */
+bool BPlusTree::EnableLog(int groupSize, int checkpointEvery)
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    wal.SetGroupSize(groupSize);
+    checkpointInterval = max(checkpointEvery, 1);
+    changesSinceCheckpoint = 0;
+    return wal.Create(filename + ".wal", seqSet.GetCheckpointLSN());
+}
+
+/**
+ * @brief Reads the leaves and index pages, loads the key filter and replays
+ *        the log.
+ */
+bool BPlusTree::Open(int groupSize, int checkpointEvery)
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    {
+        std::unique_lock<SharedLatch> tree(treeLatch);
+        std::vector<Block> storedIndex;
+        if (!seqSet.ReadFromFile(&storedIndex)) return false;
+        blockSize = seqSet.GetBlockSize();
+
+        // A file checkpointed before BuildStaticIndex() may hold unsorted leaves;
+        // one whose header records a tree was written in key order
+        uint32_t prevKey = 0;
+        bool sorted = true;
+        if (seqSet.GetIndexHeight() == 0) {
+            for (int rbn = seqSet.GetHeadRBN(); rbn != -1 && sorted; rbn = seqSet.GetBlock(rbn).GetNextRBN()) {
+                for (uint32_t zip : seqSet.GetBlock(rbn).GetKeys()) {
+                    if (zip < prevKey) sorted = false;
+                    prevKey = zip;
+                }
+            }
+        }
+        if (!sorted) seqSet.SortByKey();
+
+        // The index pages written with the header's root and height are used as they are
+        if (!AdoptIndexPages(storedIndex)) BuildIndexLevels();
+
+        // Checkpoint() writes the filter before the pages, so a stored filter
+        // holds every key in the file; the log replay below adds the rest
+        std::string filterFile = filename + ".bloom";
+        if (!std::ifstream(filterFile).is_open() || !keyFilter.readFromFile(filterFile)) BuildKeyFilter();
+    }
+
+    std::string logFile = filename + ".wal";
+    if (!std::ifstream(logFile).is_open()) return true;
+
+    // Redo recovery: reapply every change logged after the file was written
+    wal.SetGroupSize(groupSize);
+    checkpointInterval = max(checkpointEvery, 1);
+    changesSinceCheckpoint = 0;
+    replaying = true;
+    bool opened = wal.Open(logFile, seqSet.GetCheckpointLSN(),
+                           [this](char op, const std::string& payload) {
+                               if (op == 'I') ApplyInsert(payload);
+                               else if (op == 'D') ApplyDelete(payload);
+                           });
+    replaying = false;
+    return opened;
+}
+
+bool BPlusTree::Sync()
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    return !wal.IsOpen() || wal.Commit();
 }
 
 /**
@@ -107,10 +744,15 @@ bool BPlusTree::Delete(const std::string& key)
  */
 void BPlusTree::PrintSummary() const
 {
+    std::unique_lock<SharedLatch> tree(treeLatch);
     std::cout << "\n=== B+ Tree Summary ===" << std::endl;
     std::cout << "Root RBN: " << rootRBN << std::endl;
     std::cout << "Block Size: " << blockSize << " bytes" << std::endl;
-    std::cout << "Total Records: " << seqSet.getRecords().size() << std::endl;
+    std::cout << "Tree Height: " << treeHeight << std::endl;
+    std::cout << "Leaf Blocks: " << seqSet.GetTotalBlocks() - seqSet.GetFreeBlockCount() << std::endl;
+    std::cout << "Free Blocks: " << seqSet.GetFreeBlockCount() << std::endl;
+    std::cout << "Index Blocks: " << indexBlocks.size() << std::endl;
+    std::cout << "Total Records: " << seqSet.GetTotalRecords() << std::endl;
     std::cout << "========================\n" << std::endl;
 }
 
@@ -122,31 +764,26 @@ void BPlusTree::PrintSummary() const
  */
 void BPlusTree::SearchByState(const std::string& state, std::vector<std::string>& outRecords) const
 {
-    // Search all records in the sequence set for matching state
-    const auto& records = seqSet.getRecords();
-    
-    for (const auto& recStr : records) {
-        // Parse: ZIP,PLACE,STATE,COUNTY,LAT,LON
-        // State is the 3rd field
-        int fieldCount = 0;
-        size_t start = 0;
-        size_t end = 0;
-        std::string currentField;
-        
-        for (size_t i = 0; i <= recStr.length(); ++i) {
-            if (i == recStr.length() || recStr[i] == ',') {
-                if (fieldCount == 2) {  // STATE field is the 3rd (index 2)
-                    currentField = recStr.substr(start, i - start);
-                    if (currentField == state) {
-                        outRecords.push_back(recStr);
-                    }
-                    break;
-                }
-                fieldCount++;
-                start = i + 1;
-            }
-        }
-    }
+    // Scan a frozen version of the leaves; writers carry on meanwhile
+    Snapshot().SearchByState(state, outRecords);
+}
+
+void BPlusTree::Scan(const ScanPredicate& predicate, ScanOrder order, std::vector<std::string>& outRecords) const
+{
+    TreeSnapshot view = Snapshot();
+    LeafScan(view, predicate, order).Run(outRecords);
+}
+
+/**
+ * @brief Shares the leaf pages between changes.
+ *
+ * Holding the writer mutex keeps every page of the snapshot from the same
+ * moment; readers are not held up.
+ */
+TreeSnapshot BPlusTree::Snapshot() const
+{
+    std::lock_guard<std::mutex> writer(writerMutex);
+    return TreeSnapshot(seqSet.Snapshot());
 }
 
 /**
@@ -156,26 +793,36 @@ void BPlusTree::SearchByState(const std::string& state, std::vector<std::string>
  */
 void BPlusTree::DumpTree(std::ostream& out) const
 {
+    std::unique_lock<SharedLatch> tree(treeLatch);
     out << "\n=== B+ Tree Structure Dump ===" << std::endl;
     out << "Root RBN: " << rootRBN << std::endl;
     out << "Block Size: " << blockSize << " bytes" << std::endl;
+    out << "Tree Height: " << treeHeight << std::endl;
+
+    if (treeHeight > 1) {
+        const Block& root = indexBlocks[rootRBN - firstIndexRBN];
+        out << "\n--- Root Index Block (RBN " << rootRBN << ", "
+            << root.GetRecordCount() << " entries: highestKey,childRBN) ---" << std::endl;
+        for (const auto& entry : root.getRecords()) out << "  " << entry << std::endl;
+        out << "Index Blocks: " << indexBlocks.size() << std::endl;
+    }
+
     out << "\n--- Leaf Level (Sequence Set) ---" << std::endl;
     
-    const auto& records = seqSet.getRecords();
-    out << "Total Records: " << records.size() << std::endl;
+    const int total = seqSet.GetTotalRecords();
+    out << "Total Records: " << total << std::endl;
     
-    // Show first few records as sample
+    // Show first few records (in physical block order) as sample
     int count = 0;
-    for (const auto& rec : records) {
-        out << "  " << rec << std::endl;
-        count++;
-        if (count >= 10) {
-            if (records.size() > 10) {
-                out << "  ... (" << (records.size() - 10) << " more records)" << std::endl;
-            }
-            break;
+    for (int rbn = 0; rbn < seqSet.GetTotalBlocks() && count < 10; ++rbn) {
+        for (const auto& rec : seqSet.GetBlock(rbn).getRecords()) {
+            out << "  " << rec << std::endl;
+            if (++count >= 10) break;
         }
     }
+    if (total > 10) {
+        out << "  ... (" << (total - 10) << " more records)" << std::endl;
+    }
     
     out << "\n================================" << std::endl;
 }
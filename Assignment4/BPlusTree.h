@@ -11,6 +11,30 @@
  *   - **Leaf blocks** (sequence set): Linked blocks containing actual records
  *   - **Index blocks**: Non-leaf nodes containing search keys and child RBNs
  *   - **Root block**: Entry point for tree traversal
+ *
+ * Lookups descend the index pages. With SetLearnedIndex(true) they ask a
+ * LearnedIndex over the bottom index level instead; the model is saved next
+ * to the block file as "<filename>.pgm" and loaded by Open() if it still
+ * fits the tree's separators.
+ *
+ * With a write-ahead log enabled (EnableLog() or Open()), every Insert and
+ * Delete is logged and WriteToFile() acts as a checkpoint; see WriteAheadLog.h.
+ *
+ * Concurrency: any number of threads may call Search() and SearchByState()
+ * while one thread at a time changes the tree (writers queue on a mutex).
+ * Two levels of latches keep readers and the writer apart:
+ *   - the **tree latch** covers the node vectors, the index levels and the
+ *     key filter; readers and in-place leaf changes hold it shared, while a
+ *     leaf split or index rebuild holds it exclusively (a split can move
+ *     every block when the vector grows, and it changes the separators);
+ *   - a **leaf latch** per page (striped by RBN) is held shared by a reader
+ *     inside the leaf and exclusively by a writer changing that leaf.
+ * Index pages change only under the exclusive tree latch, so a reader needs
+ * no latch on them and goes straight from the tree latch to one leaf latch.
+ *
+ * Long scans read a Snapshot() instead (see TreeSnapshot.h): it shares the
+ * leaf pages copy-on-write, takes no latches while scanning and sees the
+ * tree as of one moment, however long the scan runs.
  */
 
 #ifndef BPLUSTREE_H
@@ -20,7 +44,15 @@
 #include <fstream>
 #include <vector>
 #include <ostream> // for std::ostream
+#include <functional>
+#include <mutex>
+#include "SharedLatch.h"
 #include "BlockedSequenceSet.h"
+#include "BloomFilter.h"
+#include "LearnedIndex.h"
+#include "WriteAheadLog.h"
+#include "TreeSnapshot.h"
+#include "LeafScan.h"
 
 /**
  * @class BPlusTree
@@ -51,10 +83,135 @@
  */
 class BPlusTree {
 private:
+    static const int LEAF_LATCH_COUNT = 256;  ///< Leaf latch stripes (RBN modulo this)
+    static const int SEARCH_GROUP = 16;       ///< Lookups interleaved by SearchBatch()
+
     int rootRBN;              ///< Record Block Number of the root index block
     int blockSize;            ///< Size of each block in bytes (typically 512)
+    int treeHeight;           ///< Levels including the leaf level (0 = not built)
+    bool indexStale;          ///< True when leaf splits invalidated the index levels
     std::string filename;     ///< File path for persistent storage of all blocks
     BlockedSequenceSet seqSet;  ///< Sequence set (leaf level) containing all records
+    std::vector<Block> indexBlocks;  ///< INDEX_BLOCKs, RBN = firstIndexRBN + position
+    int firstIndexRBN;        ///< RBN of indexBlocks[0] (index pages follow the leaves)
+    std::vector<uint32_t> leafSeparators;  ///< Bottom index level: separator of each leaf, in chain order
+    std::vector<int> leafRBNs;             ///< Leaf RBN for each entry of leafSeparators
+    LearnedIndex leafModel;   ///< Predicts a position in leafSeparators for FindLeaf()
+    bool useLearnedIndex;     ///< True if FindLeaf() uses leafModel instead of the index pages
+    BloomFilter keyFilter;    ///< Rejects absent keys in Search() before any block access
+    WriteAheadLog wal;        ///< Redo log of Insert/Delete ("<filename>.wal"), closed if unused
+    bool replaying;           ///< True while recovery replays the log (nothing is re-logged)
+    int checkpointInterval;   ///< Logged changes between automatic checkpoints
+    int changesSinceCheckpoint;  ///< Logged changes since the last checkpoint
+    mutable SharedLatch treeLatch;  ///< Structure latch (see the file comment)
+    mutable SharedLatch leafLatches[LEAF_LATCH_COUNT];  ///< Striped leaf page latches
+    mutable std::mutex writerMutex;  ///< Admits one writer (Insert, Delete, checkpoint, snapshot) at a time
+
+    /**
+     * @brief Rebuilds the index levels bottom-up over the current leaf chain.
+     *
+     * Each index entry is "separator,childRBN". Above the leaves the separator
+     * is the shortest (most trailing zeros) key s with
+     * highestKey(child) <= s < lowestKey(next child), which keeps index pages
+     * compact; the last child's separator is its exact highest key. A level
+     * is packed into as few blocks as fit, and levels are added until one
+     * block (the root) remains. Leaves are not touched.
+     */
+    void BuildIndexLevels();
+
+    /**
+     * @brief Takes the index pages read from the file as the index levels.
+     *
+     * The root and height come from the file's header. The pages are used
+     * only if, level by level from the root, every entry points at a page of
+     * the next level down and the bottom level points at leaves.
+     *
+     * @param pages Index pages in RBN order, following the leaves; moved from
+     *              when they are used
+     * @return true if the pages were used; false if the index must be rebuilt
+     */
+    bool AdoptIndexPages(std::vector<Block>& pages);
+
+    /**
+     * @brief Trains leafModel over leafSeparators if the model is in use.
+     */
+    void TrainLeafModel();
+
+    /**
+     * @brief Loads leafModel from "<filename>.pgm", or trains it if that file
+     *        is missing or does not fit leafSeparators.
+     */
+    void LoadLeafModel();
+
+    /**
+     * @brief Finds the leaves whose key ranges cover up to SEARCH_GROUP keys.
+     *
+     * Descends the index pages for all keys together, prefetching each
+     * lookup's next page while the others are searched. With the learned
+     * index enabled, leafModel instead predicts the position of the first
+     * separator >= each key and a few entries around it are binary-searched.
+     * Both find the leaf the descent reaches.
+     *
+     * @param key Keys to locate
+     * @param n Number of keys (at most SEARCH_GROUP)
+     * @param at In: -1 for a key to skip. Out: each other key's leaf RBN, or
+     *           -1 if it is larger than every separator in the tree
+     */
+    void FindLeaves(const uint32_t* key, size_t n, int* at) const;
+
+    /**
+     * @brief Finds the leaf whose key range covers @p key (see FindLeaves()).
+     *
+     * @param key ZIP code to locate
+     * @return Leaf RBN, or -1 if @p key is larger than every separator in the tree
+     */
+    int FindLeaf(uint32_t key) const;
+
+    /**
+     * @brief Rebuilds the key filter from every key in the leaves.
+     */
+    void BuildKeyFilter();
+
+    /**
+     * @brief Builds the key filter of a freshly built tree, then writes the
+     *        filter and the tree's pages.
+     */
+    void FinishBuild();
+
+    /**
+     * @brief Counts one logged change and checkpoints when the interval is reached.
+     */
+    void NoteLoggedChange();
+
+    /**
+     * @brief Returns the latch guarding leaf @p rbn.
+     */
+    SharedLatch& LeafLatch(int rbn) const { return leafLatches[rbn % LEAF_LATCH_COUNT]; }
+
+    /**
+     * @brief Takes the tree latch shared, rebuilding stale index levels first.
+     *
+     * The rebuild briefly takes the latch exclusively; the first thread to
+     * find the index stale does it.
+     *
+     * @return Shared lock on the tree latch with a current index
+     */
+    std::shared_lock<SharedLatch> LatchIndex();
+
+    /**
+     * @brief Insert() without the writer mutex (the caller holds it).
+     */
+    bool ApplyInsert(const std::string& record);
+
+    /**
+     * @brief Delete() without the writer mutex (the caller holds it).
+     */
+    bool ApplyDelete(const std::string& key);
+
+    /**
+     * @brief WriteToFile() without the writer mutex (the caller holds it).
+     */
+    void Checkpoint();
 
 public:
     /**
@@ -62,42 +219,77 @@ public:
      *
      * @param fname Path to the file where blocks will be written
      * @param blkSize Size of each block in bytes (e.g., 512)
+     * @param codec Page codec for the leaf level (index pages stay plain)
      *
      * Initializes:
      *   - filename = fname
-     *   - blockSize = blkSize
+     *   - blockSize = blkSize (also used for every leaf in seqSet)
      *   - rootRBN = -1 (tree not yet built)
      *   - seqSet with empty blocks
      */
-    BPlusTree(const std::string& fname, int blkSize);
+    BPlusTree(const std::string& fname, int blkSize, PageCodecType codec = CODEC_NONE);
 
     /**
      * @brief Builds the complete static B+ tree index.
      *
      * This method must be called after all records have been added to the
-     * sequence set. It creates index blocks in a bottom-up fashion, organizing
-     * leaf blocks into a hierarchical tree structure according to B+ tree rules.
+     * sequence set. It sorts the sequence set by key, creates index blocks in a
+     * bottom-up fashion, organizing leaf blocks into a hierarchical tree
+     * structure according to B+ tree rules, and writes the file.
+     *
+     * Also builds the key filter over every stored ZIP and persists it next to
+     * the block file as "<filename>.bloom".
      *
      * @note This is the key step that transforms a flat BlockedSequenceSet into
      *       a multi-level B+ tree suitable for efficient searching.
      */
     void BuildStaticIndex();
 
+    /**
+     * @brief Builds the tree in one pass from records supplied in key order.
+     *
+     * Each record goes straight into the last leaf (leaves are packed full
+     * as they fill), then the index levels are built and the file and key
+     * filter are written as by BuildStaticIndex(). Unlike Insert() followed
+     * by BuildStaticIndex(), no record is held twice or re-sorted; a source
+     * that turns out not to be in key order is sorted afterwards. Replaces
+     * the tree's previous records.
+     *
+     * @param next Called once per record: stores the next record in its
+     *             argument and returns true, or returns false at the end.
+     *             It runs with the tree latched and must not call the tree.
+     * @return false if a record whose first field is not a 32-bit ZIP was skipped
+     */
+    bool BulkLoad(const std::function<bool(std::string&)>& next);
+
     /**
      * @brief Inserts a record into the B+ tree.
      *
      * For a static B+ tree, this typically delegates to the sequence set and
-     * marks the tree as needing rebuilding before searches.
+     * marks the tree as needing rebuilding before searches. Before
+     * BuildStaticIndex() the record is simply appended; afterwards it is placed
+     * in the leaf found through the index, splitting the leaf if it is full,
+     * and the index levels are rebuilt lazily by the next Search().
+     *
+     * With a log enabled the record is appended to it before the tree
+     * changes; a log that cannot be written is reported here and by Sync()
+     * until the next WriteToFile().
      *
      * @param record String record to insert (comma-separated fields)
+     * @return true if the record was stored (and logged); false, with the
+     *         tree unchanged, if its first field is not a 32-bit ZIP, it is
+     *         too large for a block or it could not be logged
      */
-    void Insert(const std::string& record);
+    bool Insert(const std::string& record);
 
     /**
      * @brief Searches for a record by primary key using tree traversal.
      *
      * Begins at the root block and recursively traverses index blocks until
      * reaching the appropriate leaf block, then searches within the leaf.
+     * Keys that are not plain decimal digits (no sign or spaces) or do not
+     * fit in 32 bits, and keys the key filter reports as absent, return false
+     * without touching any block.
      *
      * @param key Primary key value to search for (e.g., ZIP code)
      * @param outRecord Reference to string where matching record is stored
@@ -105,11 +297,29 @@ public:
      */
     bool Search(const std::string& key, std::string& outRecord);
 
+    /**
+     * @brief Looks up a batch of ZIP codes with their cache misses overlapped.
+     *
+     * The keys go down the tree SEARCH_GROUP at a time. Each step (filter
+     * probe, one index level, the leaf) is taken for the whole group before
+     * the next, and prefetches the memory the next step reads, so a group
+     * waits for its misses together rather than one after another (group
+     * prefetching). Finds the same records as Search() on each key.
+     *
+     * @param keys ZIP codes to look up
+     * @param outRecords Receives one entry per key (empty if not found)
+     * @param found Receives 1 for each key found, 0 otherwise
+     */
+    void SearchBatch(const std::vector<uint32_t>& keys, std::vector<std::string>& outRecords,
+                     std::vector<char>& found);
+
     /**
      * @brief Deletes a record by primary key.
      *
      * @param key Primary key value of the record to delete
-     * @return true if record found and deleted; false if not found
+     * @return true if record found, deleted and (with a log) logged; false,
+     *         with the tree unchanged, if not found, not a ZIP, or the log
+     *         could not be written
      */
     bool Delete(const std::string& key);
 
@@ -124,22 +334,128 @@ public:
      */
     void PrintSummary() const;
 
+    /**
+     * @brief Writes the header page, leaf pages and index pages to the file.
+     *
+     * Index pages follow the leaves, so block RBN r is always at byte
+     * (r + 1) * blockSize. Once the file holds the tree, only the header page,
+     * dirty leaves and rebuilt index pages are rewritten in place, as one
+     * journaled batch (see PageFile). Otherwise the file is written to
+     * "<filename>.tmp", which then replaces the old one. Either way a crash
+     * never leaves a partial file.
+     *
+     * With the log enabled this is a checkpoint: pending log records are
+     * committed, the last LSN is stored in the header, and the log is
+     * emptied once the new file is in place.
+     *
+     * A built key filter is rewritten to "<filename>.bloom" before the pages,
+     * so the stored filter never lacks a key the file holds.
+     */
+    void WriteToFile();
+
+    /**
+     * @brief Starts logging Insert and Delete to "<filename>.wal".
+     *
+     * Any previous log file is discarded, so call this on a new tree or after
+     * Open() has recovered the file.
+     *
+     * @param groupSize Log records written and synced together
+     * @param checkpointEvery Logged changes between automatic checkpoints
+     * @return true if the log was created; false on I/O error
+     */
+    bool EnableLog(int groupSize = 32, int checkpointEvery = 1000);
+
+    /**
+     * @brief Loads a file written by WriteToFile() and recovers it.
+     *
+     * The leaves are read, with the index pages the header's root and height
+     * describe (the index is rebuilt from the leaves if the file has none or
+     * they do not match the leaves). The key
+     * filter is loaded from "<filename>.bloom" (rebuilt from the leaves if
+     * that file is missing or damaged). If "<filename>.wal" exists every
+     * change logged after the file's checkpoint LSN is replayed (redo
+     * recovery). Logging then continues in the same log.
+     *
+     * @param groupSize Log records written and synced together
+     * @param checkpointEvery Logged changes between automatic checkpoints
+     * @return true if the file (and log, if any) were read
+     */
+    bool Open(int groupSize = 32, int checkpointEvery = 1000);
+
+    /**
+     * @brief Commits the current log group, making every change so far durable.
+     *
+     * After a log write fails this keeps returning false until WriteToFile()
+     * checkpoints the tree and restarts the log.
+     *
+     * @return true on success or when logging is off; false on I/O error
+     */
+    bool Sync();
+
+    /**
+     * @brief Switches lookups between the index pages (the default) and the
+     *        learned index over the bottom index level.
+     *
+     * Call it before Open() to load a saved model; turned on later, the model
+     * is trained at once. Either way it is written with the tree's pages.
+     *
+     * @param enabled True to look leaves up through the learned index
+     */
+    void SetLearnedIndex(bool enabled);
+
+    /**
+     * @brief Returns the number of levels, including the leaf level.
+     */
+    int GetTreeHeight() const { return treeHeight; }
+
+    /**
+     * @brief Returns the number of index (non-leaf) blocks.
+     */
+    int GetIndexBlockCount() const { return static_cast<int>(indexBlocks.size()); }
+
     /**
      * @brief Searches for all records matching a given state abbreviation.
      *
      * Performs a full scan of the leaf blocks (sequence set) to find all records
-     * with the specified state code in their state field.
+     * with the specified state code in their state field. The scan reads a
+     * snapshot, so records come back in key order as of the call, and
+     * concurrent inserts and deletes are not held up.
      *
      * @param state Two-letter state code to search for (e.g., "MT", "MN")
      * @param outRecords Reference to vector where matching records are stored
      */
     void SearchByState(const std::string& state, std::vector<std::string>& outRecords) const;
 
+    /**
+     * @brief Collects every record that satisfies a predicate.
+     *
+     * Scans a snapshot with a LeafScan: the leaves are split into runs that
+     * are scanned in parallel on the shared thread pool.
+     *
+     * @param predicate Records to keep (state, county, lat/lon box, ...)
+     * @param order SCAN_KEY_ORDER for ascending ZIP codes, SCAN_ANY_ORDER
+     *              when the caller does not need an order
+     * @param outRecords Matching records are appended here
+     */
+    void Scan(const ScanPredicate& predicate, ScanOrder order, std::vector<std::string>& outRecords) const;
+
+    /**
+     * @brief Freezes the current records for a consistent read.
+     *
+     * Waits for the change in progress (if any), then shares the leaf pages
+     * with the snapshot; taking it copies only pointers. Pages changed later
+     * are copied first, so the snapshot never changes.
+     *
+     * @return Read-only view of every record as of this call
+     */
+    TreeSnapshot Snapshot() const;
+
     /**
      * @brief Provides access to the underlying BlockedSequenceSet.
      *
      * Useful for directly manipulating the leaf level (sequence set) and
-     * adding records before tree construction.
+     * adding records before tree construction. Access through this reference
+     * takes no latches, so it must not overlap other threads' calls.
      *
      * @return Reference to the internal BlockedSequenceSet object
      */
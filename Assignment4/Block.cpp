@@ -1,36 +1,439 @@
 #include "Block.h"
+#include "Prefetch.h"
+#include "Crc32c.h"
 #include <iostream>
 #include <fstream>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <memory_resource>
+#include <string_view>
 
 using namespace std;
 
 // Default constructor
-Block::Block() : RBN(-1), prevRBN(-1), nextRBN(-1), blockSize(512), usedBytes(0), type(LEAF_BLOCK) {}
+Block::Block() : RBN(-1), prevRBN(-1), nextRBN(-1), blockSize(512), usedBytes(0), type(LEAF_BLOCK),
+                 dirty(true), codec(CODEC_NONE), packedBytes(0), packedAtUsed(0), packedCurrent(false) {}
 
-// Constructor with RBN and max bytes
-Block::Block(int rbn_, int maxBytes) 
-    : RBN(rbn_), prevRBN(-1), nextRBN(-1), blockSize(maxBytes), usedBytes(0), type(LEAF_BLOCK) {}
+// Constructor with RBN, max bytes and codec
+Block::Block(int rbn_, int maxBytes, PageCodecType codec_) 
+    : RBN(rbn_), prevRBN(-1), nextRBN(-1), blockSize(maxBytes), usedBytes(0), type(LEAF_BLOCK),
+      dirty(true), codec(codec_), packedBytes(0), packedAtUsed(0), packedCurrent(false) {}
 
 
-    // Add record (no space check)
+// Split a record into its comma-separated fields (views into rec)
+static void splitFields(string_view rec, pmr::vector<string_view>& fields) {
+    fields.clear();
+    while (true) {
+        size_t comma = rec.find(',');
+        fields.push_back(rec.substr(0, comma));
+        if (comma == string_view::npos) break;
+        rec.remove_prefix(comma + 1);
+    }
+}
+
+// Room for the field views of a record and its predecessor, so that coding
+// a record needs no heap allocation (longer records spill to the heap)
+static const size_t FIELD_SCRATCH_BYTES = 2 * 16 * sizeof(string_view);
+
+// Front-code one field against the same field of the previous record
+static void encodeField(string_view field, const string_view* prevField, string& out) {
+    if (prevField && !field.empty() && field == *prevField) {
+        out += '=';
+        return;
+    }
+    size_t shared = 0;
+    if (prevField) {
+        while (shared < field.size() && shared < prevField->size() && shared < 99 &&
+               field[shared] == (*prevField)[shared]) ++shared;
+    }
+    if (shared >= 4) {
+        out += '+';
+        out += to_string(shared);
+        out += '|';
+        out.append(field.substr(shared));
+        return;
+    }
+    if (!field.empty() && (field[0] == '=' || field[0] == '+')) out += "+0|";  // escape
+    out.append(field);
+}
+
+// Undo encodeField(), appending the field to out
+static void decodeField(string_view token, const string_view* prevField, string& out) {
+    if (token == "=" && prevField) {
+        out.append(*prevField);
+        return;
+    }
+    if (!token.empty() && token[0] == '+') {
+        size_t bar = token.find('|');
+        size_t shared = 0;
+        for (size_t i = 1; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i) {
+            shared = shared * 10 + static_cast<size_t>(token[i] - '0');
+        }
+        if (prevField) out.append(prevField->substr(0, shared));
+        out.append(token.substr(bar == string_view::npos ? token.size() : bar + 1));
+        return;
+    }
+    out.append(token);
+}
+
+// Append rec encoded against prev (key delta + front-coded fields) to out
+static void appendEncoded(const string& rec, const string& prev, string& out) {
+    alignas(string_view) char scratch[FIELD_SCRATCH_BYTES];
+    pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    pmr::vector<string_view> fields(&arena), prevFields(&arena);
+    fields.reserve(8);
+    prevFields.reserve(8);
+    splitFields(rec, fields);
+    splitFields(prev, prevFields);
+
+    uint32_t key = Block::ExtractKey(rec);
+    uint32_t prevKey = Block::ExtractKey(prev);
+    if (fields[0] == to_string(key) && key >= prevKey) {
+        out += to_string(key - prevKey);
+    } else {
+        out += "+0|";  // non-canonical key text is kept verbatim
+        out.append(fields[0]);
+    }
+    for (size_t i = 1; i < fields.size(); ++i) {
+        out += ',';
+        encodeField(fields[i], i < prevFields.size() ? &prevFields[i] : nullptr, out);
+    }
+}
+
+// Append the record that enc (from appendEncoded()) stands for to out
+static void appendDecoded(string_view enc, const string& prev, string& out) {
+    alignas(string_view) char scratch[FIELD_SCRATCH_BYTES];
+    pmr::monotonic_buffer_resource arena(scratch, sizeof(scratch));
+    pmr::vector<string_view> tokens(&arena), prevFields(&arena);
+    tokens.reserve(8);
+    prevFields.reserve(8);
+    splitFields(enc, tokens);
+    splitFields(prev, prevFields);
+
+    if (!tokens[0].empty() && tokens[0][0] == '+') {
+        decodeField(tokens[0], nullptr, out);
+    } else {
+        uint32_t delta = 0;
+        for (char c : tokens[0]) {
+            if (c < '0' || c > '9') break;
+            delta = delta * 10 + static_cast<uint32_t>(c - '0');
+        }
+        out += to_string(Block::ExtractKey(prev) + delta);
+    }
+    for (size_t i = 1; i < tokens.size(); ++i) {
+        out += ',';
+        decodeField(tokens[i], i < prevFields.size() ? &prevFields[i] : nullptr, out);
+    }
+}
+
+// Encode a record against its predecessor
+string Block::EncodeRecord(const string& rec, const string* prev) {
+    if (!prev) return rec;  // first record of a page is stored verbatim
+    string out;
+    out.reserve(rec.size());
+    appendEncoded(rec, *prev, out);
+    return out;
+}
+
+// Decode a record written by EncodeRecord()
+string Block::DecodeRecord(const string& enc, const string* prev) {
+    if (!prev) return enc;
+    string out;
+    out.reserve(prev->size() + enc.size());
+    appendDecoded(enc, *prev, out);
+    return out;
+}
+
+// Number of decimal digits in n
+static int digitCount(uint32_t n) {
+    int digits = 1;
+    while (n >= 10) { n /= 10; ++digits; }
+    return digits;
+}
+
+// Bytes a record occupies on the page (encoded form plus newline).
+// Computes the length EncodeRecord() would produce without building it.
+static int encodedCost(const string& rec, const string* prev) {
+    if (!prev) return static_cast<int>(rec.size()) + 1;
+
+    const int MAX_FIELDS = 16;
+    string_view fields[MAX_FIELDS], prevFields[MAX_FIELDS];
+    int count = 0, prevCount = 0;
+    for (string_view text(rec);; ++count) {
+        size_t comma = text.find(',');
+        if (count == MAX_FIELDS) return static_cast<int>(Block::EncodeRecord(rec, prev).size()) + 1;
+        fields[count] = text.substr(0, comma);
+        if (comma == string_view::npos) { ++count; break; }
+        text.remove_prefix(comma + 1);
+    }
+    for (string_view text(*prev); prevCount < MAX_FIELDS; ++prevCount) {
+        size_t comma = text.find(',');
+        prevFields[prevCount] = text.substr(0, comma);
+        if (comma == string_view::npos) { ++prevCount; break; }
+        text.remove_prefix(comma + 1);
+    }
+
+    int length = 1;  // newline
+    uint32_t key = Block::ExtractKey(rec);
+    uint32_t prevKey = Block::ExtractKey(*prev);
+    bool canonical = static_cast<int>(fields[0].size()) == digitCount(key) &&
+                     (fields[0].size() == 1 || fields[0][0] != '0') &&
+                     fields[0].find_first_not_of("0123456789") == string_view::npos;
+    if (key >= prevKey && canonical) {
+        length += digitCount(key - prevKey);
+    } else {
+        length += 3 + static_cast<int>(fields[0].size());
+    }
+
+    for (int i = 1; i < count; ++i) {
+        string_view field = fields[i];
+        length += 1;  // comma
+        if (i < prevCount && !field.empty() && field == prevFields[i]) {
+            length += 1;
+            continue;
+        }
+        size_t shared = 0;
+        if (i < prevCount) {
+            while (shared < field.size() && shared < prevFields[i].size() && shared < 99 &&
+                   field[shared] == prevFields[i][shared]) ++shared;
+        }
+        if (shared >= 4) {
+            length += 2 + digitCount(static_cast<uint32_t>(shared)) + static_cast<int>(field.size() - shared);
+        } else {
+            if (!field.empty() && (field[0] == '=' || field[0] == '+')) length += 3;
+            length += static_cast<int>(field.size());
+        }
+    }
+    return length;
+}
+
+// Change in page bytes if rec is inserted at slot pos
+int Block::InsertCost(const std::string& rec, size_t pos) const {
+    const string* prev = pos > 0 ? &records[pos - 1] : nullptr;
+    int cost = encodedCost(rec, prev);
+    if (pos < records.size()) {
+        // The following record is re-encoded against rec instead of prev
+        cost += encodedCost(records[pos], &rec) - encodedCost(records[pos], prev);
+    }
+    return cost;
+}
+
+// Change in page bytes if rec is inserted at its key's slot
+int Block::InsertCost(const std::string& rec) const {
+    size_t pos = lower_bound(keys.begin(), keys.end(), ExtractKey(rec)) - keys.begin();
+    return InsertCost(rec, pos);
+}
+
+// Recompute usedBytes from the encoded records
+void Block::RecomputeUsedBytes() {
+    usedBytes = 0;
+    packedBytes = 0;
+    packedCurrent = false;
+    columns.Reset();
+    dirty = true;
+    for (size_t i = 0; i < records.size(); ++i) {
+        usedBytes += encodedCost(records[i], i > 0 ? &records[i - 1] : nullptr);
+    }
+}
+
+// Check whether cost more encoded bytes fit, compressing the page if needed
+bool Block::Fits(int cost) const {
+    if (cost <= GetFreeSpace()) return true;
+    if (codec == CODEC_NONE) return false;
+
+    int capacity = blockSize - PAGE_OVERHEAD;
+    if (usedBytes + cost > MAX_PACKING * capacity) return false;
+    if (packedBytes > 0 && packedBytes + (usedBytes - packedAtUsed) + cost <= capacity) return true;
+
+    if (!packedCurrent) {
+        string packed;
+        PageCodec::Compress(EncodePage(), packed);
+        packedBytes = static_cast<int>(packed.size());
+        packedAtUsed = usedBytes;
+        packedCurrent = true;
+    }
+    return packedBytes + cost <= capacity;
+}
+
+// Add record in key order if it fits
 bool Block::AddRecord(const std::string& rec) {
-    records.push_back(rec);
-    usedBytes += static_cast<int>(rec.size());// Update used bytes
+    uint32_t key = ExtractKey(rec);
+    size_t pos = lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    int cost = InsertCost(rec, pos);
+    if (!Fits(cost)) return false;
+
+    records.insert(records.begin() + pos, rec);
+    keys.insert(keys.begin() + pos, key);
+    usedBytes += cost;// Update used bytes
+    packedCurrent = false;
+    columns.Reset();
+    dirty = true;
     return true;
 }
 
-// Write block to file
+// Columnar form of the records, built once per version of the records
+std::shared_ptr<const ColumnBatch> Block::GetColumns() const {
+    std::shared_ptr<const ColumnBatch> built = columns.Get();
+    if (!built) {
+        auto batch = std::make_shared<ColumnBatch>();
+        batch->Reserve(records.size());
+        for (const auto& rec : records) batch->Append(rec);
+        built = batch;
+        columns.Set(built);
+    }
+    return built;
+}
+
+// Encoded record lines of the page
+string Block::EncodePage() const {
+    string body;
+    body.reserve(usedBytes);
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (i == 0) body += records[0];
+        else appendEncoded(records[i], records[i - 1], body);
+        body += '\n';
+    }
+    return body;
+}
+
+// Check that the page fits in blockSize, compressed if allowed
+bool Block::FitsPage() const {
+    if (GetFreeSpace() >= 0) return true;
+    if (codec == CODEC_NONE) return false;
+
+    if (!packedCurrent) {
+        string packed;
+        PageCodec::Compress(EncodePage(), packed);
+        packedBytes = static_cast<int>(packed.size());
+        packedAtUsed = usedBytes;
+        packedCurrent = true;
+    }
+    return packedBytes <= blockSize - PAGE_OVERHEAD;
+}
+
+// Write block to file as one fixed-size page
 void Block::Write(ofstream& out) const {
-    out << "BLOCK " << RBN << " PREV=" << prevRBN << " NEXT=" << nextRBN
-        << " COUNT=" << records.size() << "\n";
-    for (const auto& rec : records) out << rec << "\n";
-    out << "END_BLOCK\n";
+    string text = Serialize();
+    out.write(text.data(), text.size());
+}
+
+// Build the fixed-size page Write() emits
+string Block::Serialize() const {
+    string body = EncodePage();
+    char header[128];
+    int headerLength = snprintf(header, sizeof(header), "BLOCK %d TYPE=%s PREV=%d NEXT=%d COUNT=%zu", RBN,
+                                type == INDEX_BLOCK ? "INDEX" : type == AVAIL_BLOCK ? "AVAIL" : "LEAF", prevRBN,
+                                nextRBN, records.size());
+
+    // Built in one string sized for the whole page
+    string text;
+    text.reserve(max(static_cast<size_t>(blockSize), body.size() + sizeof(header) + 16));
+    text.append(header, static_cast<size_t>(headerLength));
+    if (codec != CODEC_NONE && static_cast<int>(body.size()) > blockSize - PAGE_OVERHEAD) {
+        // Records only fit compressed: length-prefixed binary record area
+        string packed;
+        PageCodec::Compress(body, packed);
+        text += " ZLEN=";
+        text += to_string(packed.size());
+        text += '\n';
+        text += packed;
+        text += '\n';
+    } else {
+        text += '\n';
+        text += body;
+    }
+    text += "END_BLOCK\n";
+    SealPage(text, blockSize);
+    return text;
+}
+
+// Pad to the page size and append the checksum line
+void Block::SealPage(std::string& text, int pageSize) {
+    if (static_cast<int>(text.size()) < pageSize - PAGE_TRAILER) {
+        // Pad with spaces, keeping a newline before the checksum line
+        text.append(pageSize - PAGE_TRAILER - text.size() - 1, ' ');
+        text.push_back('\n');
+    }
+    char trailer[PAGE_TRAILER + 1];
+    snprintf(trailer, sizeof(trailer), "CRC=%08x\n", static_cast<unsigned>(Crc32c(text.data(), text.size())));
+    text.append(trailer, PAGE_TRAILER);
+}
+
+// Compare a page's checksum line with the CRC of the bytes before it
+bool Block::VerifyPage(const std::string& page) {
+    if (page.size() < static_cast<size_t>(PAGE_TRAILER)) return false;
+    size_t body = page.size() - PAGE_TRAILER;
+    if (page.compare(body, 4, "CRC=") != 0 || page.back() != '\n') return false;
+    uint32_t stored = 0;
+    for (size_t i = body + 4; i < page.size() - 1; ++i) {
+        char c = page[i];
+        int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (digit < 0) return false;
+        stored = (stored << 4) | static_cast<uint32_t>(digit);
+    }
+    return stored == Crc32c(page.data(), body);
+}
+
+// Read one page written by Write()
+bool Block::Read(istream& in, int maxBytes, PageCodecType codec_) {
+    string line;
+    if (!getline(in, line)) return false;
+
+    int rbn = -1, prev = -1, next = -1, count = 0, packedLength = -1;
+    char typeName[8] = {0};
+    if (sscanf(line.c_str(), "BLOCK %d TYPE=%7s PREV=%d NEXT=%d COUNT=%d ZLEN=%d",
+               &rbn, typeName, &prev, &next, &count, &packedLength) < 5) {
+        return false;
+    }
+
+    *this = Block(rbn, maxBytes, codec_);
+    prevRBN = prev;
+    nextRBN = next;
+    type = (strcmp(typeName, "INDEX") == 0) ? INDEX_BLOCK : (strcmp(typeName, "AVAIL") == 0) ? AVAIL_BLOCK : LEAF_BLOCK;
+
+    // A compressed page is expanded in memory and its lines read from there
+    istream* lines = &in;
+    istringstream unpacked;
+    if (packedLength >= 0) {
+        string packed(static_cast<size_t>(min(packedLength, maxBytes)), '\0');
+        string text;
+        if (packedLength > maxBytes || !in.read(&packed[0], packed.size()) || in.get() != '\n' ||
+            !PageCodec::Decompress(packed.data(), packed.size(), text,
+                                   static_cast<size_t>(MAX_PACKING) * maxBytes)) {
+            return false;
+        }
+        unpacked.str(text);
+        lines = &unpacked;
+    }
+
+    size_t expected = static_cast<size_t>(max(0, min(count, maxBytes)));  // a bad COUNT must not over-allocate
+    keys.reserve(expected);
+    records.reserve(expected);
+    for (int i = 0; i < count; ++i) {
+        if (!getline(*lines, line)) return false;
+        string rec;
+        if (records.empty()) {
+            rec = line;
+        } else {
+            rec.reserve(records.back().size() + line.size());
+            appendDecoded(line, records.back(), rec);
+        }
+        keys.push_back(ExtractKey(rec));
+        records.push_back(move(rec));
+    }
+    RecomputeUsedBytes();
+    dirty = false;
+    return getline(in, line) && line == "END_BLOCK";
 }
 
 // Print block summary
 void Block::PrintSummary() const {
     cout << "Block RBN: " << RBN << ", Records: " << records.size()
-         << ", Free space: " << GetFreeSpace() << "\n";
+         << ", Free space: " << GetFreeSpace() << (type == AVAIL_BLOCK ? " (available)" : "") << "\n";
 }
 
 // Dump all records
@@ -46,38 +449,105 @@ void Block::DumpLogicOrder() const {
         string key = rec.substr(0, rec.find(','));
         cout << key << " ";
     }
+    if (type == AVAIL_BLOCK) cout << "*available* ";
     cout << "RBN " << RBN << endl;
 }
 
 // Return key of last record
 string Block::getHighestKey() const {
     if (records.empty()) return "";
-    string last = records.back();
+    const string& last = records.back();
     return last.substr(0, last.find(','));
 }
 
+// Parse leading digits of a record without allocating
+uint32_t Block::ExtractKey(const std::string& rec) {
+    uint32_t key = 0;
+    for (char c : rec) {
+        if (c < '0' || c > '9') break;
+        key = key * 10 + static_cast<uint32_t>(c - '0');
+    }
+    return key;
+}
+
+// Whole-string ZIP parse; strtoull() alone would skip spaces, take a sign and wrap
+bool Block::ParseKey(const std::string& key, uint32_t& zip) {
+    if (key.empty()) return false;
+    for (char c : key) {
+        if (c < '0' || c > '9') return false;
+    }
+    errno = 0;
+    unsigned long long value = strtoull(key.c_str(), nullptr, 10);
+    if (errno == ERANGE || value > UINT32_MAX) return false;
+    zip = static_cast<uint32_t>(value);
+    return true;
+}
+
+// Binary search the slot directory
+int Block::FindSlot(uint32_t key) const {
+    auto it = lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) return -1;
+    return static_cast<int>(it - keys.begin());
+}
+
+// Look up a record by key
+bool Block::FindRecord(uint32_t key, std::string& outRecord) const {
+    int slot = FindSlot(key);
+    if (slot < 0) return false;
+    outRecord = records[slot];
+    return true;
+}
+
+// One hint per 64-byte line of keys
+void Block::PrefetchKeys() const {
+    for (size_t i = 0; i < keys.size(); i += 64 / sizeof(uint32_t)) PrefetchLine(&keys[i]);
+}
+
 // Insert record in sorted key order
 void Block::InsertSorted(const std::string& rec) {
-    string key = rec.substr(0, rec.find(','));
-    auto it = records.begin();
-    while (it != records.end() && it->substr(0, it->find(',')) < key) ++it;
-    records.insert(it, rec);
-    usedBytes += static_cast<int>(rec.size());// Update used bytes
+    uint32_t key = ExtractKey(rec);
+    size_t pos = lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    usedBytes += InsertCost(rec, pos);// Update used bytes
+    packedCurrent = false;
+    columns.Reset();
+    dirty = true;
+    records.insert(records.begin() + pos, rec);
+    keys.insert(keys.begin() + pos, key);
 }
 
-// Check if record fits in block
+// Check if record (encoded, plus its newline) fits in block
 bool Block::HasSpace(const std::string& rec) const {
-    return (usedBytes + static_cast<int>(rec.size())) <= blockSize;
+    return Fits(InsertCost(rec));
+}
+
+// Move the upper half of the records into an empty block
+void Block::MoveUpperHalf(Block& right) {
+    size_t half = records.size() / 2;
+    for (size_t i = half; i < records.size(); ++i) {
+        right.records.push_back(records[i]);
+        right.keys.push_back(keys[i]);
+    }
+    records.resize(half);
+    keys.resize(half);
+    RecomputeUsedBytes();
+    right.RecomputeUsedBytes();
 }
 
 // Delete record by key
 bool Block::DeleteRecord(const std::string& key) {
-    for (auto it = records.begin(); it != records.end(); ++it) {
-        if (it->substr(0, it->find(',')) == key) {
-            usedBytes -= it->size();
-            records.erase(it);
-            return true;
-        }
-    }
-    return false;
+    return DeleteRecord(ExtractKey(key));
+}
+
+// Delete record by integer key
+bool Block::DeleteRecord(uint32_t key) {
+    int slot = FindSlot(key);
+    if (slot < 0) return false;
+    string removed = std::move(records[slot]);
+    records.erase(records.begin() + slot);
+    keys.erase(keys.begin() + slot);
+    usedBytes -= InsertCost(removed, slot);
+    packedCurrent = false;
+    columns.Reset();
+    dirty = true;
+    return true;
 }
@@ -8,6 +8,24 @@
  *
  * Blocks are linked together via RBN references (prevRBN, nextRBN) to form a doubly-linked
  * chain, enabling sequential traversal without random access.
+ *
+ * On disk every block occupies exactly @c blockSize bytes: a one-line block
+ * header, one line per record, an END_BLOCK line, and space padding. Block
+ * RBN r therefore starts at byte (r + 1) * blockSize, after the header page.
+ *
+ * Records are compressed on the page against the record before them (see
+ * EncodeRecord()): the key is stored as a delta, and every other field is
+ * front-coded. Capacity is measured in encoded bytes, so a page holds more
+ * records than their raw length would allow.
+ *
+ * In a file created with CODEC_LZ (see PageCodec.h), a leaf page whose encoded
+ * records outgrow blockSize is stored with its record area compressed, and
+ * the header line gains a ZLEN=<bytes> field. Such a page may hold up to
+ * MAX_PACKING times the records of a plain page.
+ *
+ * Every page ends in a "CRC=<8 hex digits>" line holding the CRC-32C of the
+ * bytes before it (see SealPage()), so a page damaged on disk is caught when
+ * it is read instead of being parsed as data.
  */
 
 #ifndef BLOCK_H
@@ -18,19 +36,25 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include "PageCodec.h"
+#include "ColumnBatch.h"
 
 /**
  * @enum BlockType
  * @brief Enumeration to distinguish block functionality.
  *
- * A Block can serve two distinct purposes depending on its type:
+ * A Block can serve three distinct purposes depending on its type:
  *   - **LEAF_BLOCK**: Stores actual data records in a sequence set
  *   - **INDEX_BLOCK**: Stores index entries (key-RBN pairs) in the B+ tree index
+ *   - **AVAIL_BLOCK**: Holds nothing; it is on the file's avail list, and its
+ *     next RBN is the next free block
  */
 enum BlockType
 {
     LEAF_BLOCK,  ///< Block stores data records
-    INDEX_BLOCK  ///< Block stores index entries (key, RBN pairs)
+    INDEX_BLOCK, ///< Block stores index entries (key, RBN pairs)
+    AVAIL_BLOCK  ///< Block is free (see BlockedSequenceSet::FreeBlock())
 };
 
 /**
@@ -45,7 +69,10 @@ enum BlockType
  *   - A Record Block Number (RBN) for identification in a file
  *   - Links to previous and next blocks (prevRBN, nextRBN) for sequencing
  *   - A vector of records and tracking of available space
- *   - A block type indicator (LEAF_BLOCK or INDEX_BLOCK)
+ *   - A slot directory: the integer key of every record, kept sorted in step
+ *     with the records so lookups, inserts and deletes binary-search it
+ *     without building key strings
+ *   - A block type indicator (LEAF_BLOCK, INDEX_BLOCK or AVAIL_BLOCK)
  *
  * Example usage (leaf block):
  * @code
@@ -55,16 +82,73 @@ enum BlockType
  * @endcode
  */
 class Block {
+public:
+    /**
+     * @brief Bytes of every page reserved for the block header, END_BLOCK and CRC lines.
+     *
+     * The longest possible header line
+     * ("BLOCK <rbn> TYPE=INDEX PREV=<rbn> NEXT=<rbn> COUNT=<n> ZLEN=<n>") plus
+     * the END_BLOCK and CRC lines fits in this allowance, so a page never
+     * outgrows blockSize.
+     */
+    static const int PAGE_OVERHEAD = 128;
+
+    /**
+     * @brief Bytes of the checksum line that ends every page ("CRC=xxxxxxxx\n").
+     */
+    static const int PAGE_TRAILER = 13;
+
+    /**
+     * @brief Limit on encoded bytes per compressed page, as a multiple of the page capacity.
+     */
+    static const int MAX_PACKING = 4;
+
 private:
     int RBN;           ///< Relative Block Number (unique identifier within file)
     int prevRBN;       ///< RBN of previous block in logical sequence (-1 if none)
     int nextRBN;       ///< RBN of next block in logical sequence (-1 if none)
     int blockSize;     ///< Maximum capacity of block in bytes
-    int usedBytes;     ///< Bytes currently occupied by records
+    int usedBytes;     ///< Bytes currently occupied by records (including one newline each)
     
-    std::vector<std::string> records;  ///< Records stored in this block
+    std::vector<std::string> records;  ///< Records stored in this block, sorted by key
+    std::vector<uint32_t> keys;        ///< Slot directory: keys[i] is the key of records[i]
    
     BlockType type;    ///< Indicates whether block stores records (LEAF) or keys (INDEX)
+    bool dirty;        ///< True if the block changed since it was last read or written
+    PageCodecType codec;  ///< Compression allowed for this page when it is written
+
+    mutable int packedBytes;    ///< Compressed size of the record area at the last trial (0 = none)
+    mutable int packedAtUsed;   ///< usedBytes when packedBytes was measured
+    mutable bool packedCurrent; ///< True while the records are unchanged since that trial
+    ColumnCache columns;        ///< Columnar form of the records, built by the first scan
+
+    /**
+     * @brief Page bytes added if @p rec were inserted at slot @p pos.
+     *
+     * Includes the record's own encoded length and newline, plus the change
+     * in size of the following record, which is re-encoded against @p rec.
+     */
+    int InsertCost(const std::string& rec, size_t pos) const;
+
+    /**
+     * @brief Recomputes usedBytes from the encoded form of every record.
+     */
+    void RecomputeUsedBytes();
+
+    /**
+     * @brief Checks whether @p cost more encoded bytes still fit on the page.
+     *
+     * Plain pages compare against the free space. Compressed pages estimate
+     * the new compressed size from the last trial compression, treating the
+     * added bytes as incompressible, and compress the page again only when
+     * that estimate does not fit and the last trial is out of date.
+     */
+    bool Fits(int cost) const;
+
+    /**
+     * @brief Builds the text of the record area: encoded records and END_BLOCK.
+     */
+    std::string EncodePage() const;
 
 public:
     /**
@@ -84,6 +168,7 @@ public:
      *
      * @param rbn_ Record Block Number to assign to this block
      * @param maxBytes Maximum block size in bytes (e.g., 512)
+     * @param codec_ Compression allowed when the page is written
      *
      * Initializes:
      *   - RBN to @c rbn_
@@ -92,7 +177,7 @@ public:
      *   - usedBytes = 0 (empty)
      *   - type = LEAF_BLOCK
      */
-    Block(int rbn_, int maxBytes);
+    Block(int rbn_, int maxBytes, PageCodecType codec_ = CODEC_NONE);
 
     /**
      * @name Accessor Methods
@@ -125,9 +210,21 @@ public:
 
     /**
      * @brief Retrieves the number of free bytes remaining.
-     * @return blockSize - usedBytes
+     * @return blockSize - PAGE_OVERHEAD - usedBytes
+     */
+    int GetFreeSpace() const { return blockSize - PAGE_OVERHEAD - usedBytes; }
+
+    /**
+     * @brief Retrieves the page size of this block.
+     * @return Block size in bytes
+     */
+    int GetBlockSize() const { return blockSize; }
+
+    /**
+     * @brief Retrieves the codec this page is written with.
+     * @return CODEC_NONE or CODEC_LZ
      */
-    int GetFreeSpace() const { return blockSize - usedBytes; }
+    PageCodecType GetCodec() const { return codec; }
 
     /**
      * @brief Provides const access to all records in this block.
@@ -135,12 +232,35 @@ public:
      */
     const std::vector<std::string>& getRecords() const { return records; }
 
+    /**
+     * @brief Provides const access to the sorted slot directory.
+     * @return Const reference to the integer keys, parallel to getRecords()
+     */
+    const std::vector<uint32_t>& GetKeys() const { return keys; }
+
+    /**
+     * @brief Returns the records as columns, row i being getRecords()[i].
+     *
+     * Built on the first call and kept until the records change. Safe to
+     * call from several threads on a page that is not being changed (such
+     * as a snapshot page).
+     *
+     * @return Shared columnar batch of this block's records
+     */
+    std::shared_ptr<const ColumnBatch> GetColumns() const;
+
     /**
      * @brief Retrieves the block type (LEAF or INDEX).
      * @return Current BlockType value
      */
     BlockType GetType() const { return type; }
 
+    /**
+     * @brief Checks whether the block differs from its page on disk.
+     * @return true for new blocks and blocks changed since ClearDirty()
+     */
+    bool IsDirty() const { return dirty; }
+
     /** @} */
 
     /**
@@ -152,19 +272,24 @@ public:
      * @brief Sets the RBN of the previous block.
      * @param rbn RBN of the previous block (-1 for none)
      */
-    void SetPrevRBN(int rbn) { prevRBN = rbn; }
+    void SetPrevRBN(int rbn) { if (prevRBN != rbn) { prevRBN = rbn; dirty = true; } }
 
     /**
      * @brief Sets the RBN of the next block.
      * @param rbn RBN of the next block (-1 for none)
      */
-    void SetNextRBN(int rbn) { nextRBN = rbn; }
+    void SetNextRBN(int rbn) { if (nextRBN != rbn) { nextRBN = rbn; dirty = true; } }
 
     /**
-     * @brief Sets the block type (LEAF_BLOCK or INDEX_BLOCK).
+     * @brief Sets the block type (LEAF_BLOCK, INDEX_BLOCK or AVAIL_BLOCK).
      * @param t The desired BlockType
      */
-    void SetType(BlockType t) { type = t; }
+    void SetType(BlockType t) { if (type != t) { type = t; dirty = true; } }
+
+    /**
+     * @brief Marks the block as matching its page on disk.
+     */
+    void ClearDirty() { dirty = false; }
 
     /** @} */
 
@@ -176,8 +301,9 @@ public:
     /**
      * @brief Attempts to add a record to this block.
      *
-     * The record is added only if sufficient free space is available.
-     * Records are stored in sorted order by their primary key (first field).
+     * The record is added only if sufficient free space is available
+     * (see HasSpace()). Records are stored in sorted order by their primary
+     * key (first field).
      *
      * @param rec String record to insert
      * @return true if record was added; false if insufficient space
@@ -190,18 +316,73 @@ public:
     /**
      * @brief Writes the block's contents to an output file stream.
      *
-     * Format includes metadata (RBN, type, record count) followed by each record.
+     * Format includes metadata (RBN, type, links, record count) followed by
+     * each encoded record, padded with spaces to exactly @c blockSize bytes.
      * Example:
      * @code
-     * [Block RBN=0 TYPE=LEAF COUNT=3]
-     * 12345,Helena,MT,...
-     * 12346,Missoula,MT,...
+     * BLOCK 0 TYPE=LEAF PREV=-1 NEXT=1 COUNT=3
+     * 1002,Amherst,MA,Hampshire,42.367100,-72.464600
+     * 1,=,=,=,+4|391900,+5|524800
+     * 1,=,=,=,+4|384500,+5|513200
+     * END_BLOCK
      * @endcode
      *
+     * A compressed page has the same header line followed by " ZLEN=<n>",
+     * then n bytes of PageCodec output holding the record lines, then
+     * "\nEND_BLOCK".
+     *
      * @param out Reference to open std::ofstream
      */
     void Write(std::ofstream& out) const;
 
+    /**
+     * @brief Returns the page exactly as Write() emits it (blockSize bytes).
+     *
+     * @return Page bytes, for writing the block at its offset in place
+     */
+    std::string Serialize() const;
+
+    /**
+     * @brief Checks that the page, compressed if need be, fits in blockSize.
+     *
+     * Insertion only estimates the compressed size; a page that turns out
+     * too large must be split before it is written.
+     *
+     * @return true if Write() will produce exactly blockSize bytes
+     */
+    bool FitsPage() const;
+
+    /**
+     * @brief Reads one page written by Write() from the current stream position.
+     *
+     * Replaces the block's contents, links and type with those on disk.
+     *
+     * @param in Open stream (file or in-memory page) positioned at a page start
+     * @param maxBytes Page size of the file (from its HeaderRecord)
+     * @param codec_ Codec of the file (from its HeaderRecord)
+     * @return true if a well-formed page was read; false otherwise
+     */
+    bool Read(std::istream& in, int maxBytes, PageCodecType codec_ = CODEC_NONE);
+
+    /**
+     * @brief Pads a page to @p pageSize bytes and ends it with its checksum line.
+     *
+     * The text is padded with spaces up to a newline just before the last
+     * PAGE_TRAILER bytes, which hold the CRC-32C of everything before them.
+     *
+     * @param text Page text ending in a newline (a block or the header page)
+     * @param pageSize Page size of the file
+     */
+    static void SealPage(std::string& text, int pageSize);
+
+    /**
+     * @brief Checks the checksum line at the end of a page read from a file.
+     *
+     * @param page Page bytes, exactly one page
+     * @return true if the page ends in a checksum line matching its contents
+     */
+    static bool VerifyPage(const std::string& page);
+
     /**
      * @brief Prints a summary of block metadata to console.
      *
@@ -237,6 +418,83 @@ public:
      */
     std::string getHighestKey() const;
 
+    /**
+     * @brief Retrieves the highest key as an integer from the slot directory.
+     *
+     * @return Highest key, or 0 if the block is empty
+     */
+    uint32_t GetHighestKeyValue() const { return keys.empty() ? 0 : keys.back(); }
+
+    /**
+     * @brief Extracts the integer primary key (first field) of a record.
+     *
+     * Parses the leading digits in place, so no temporary string is built.
+     *
+     * @param rec Record or key string (e.g., "56301,Waite Park,MN,..." or "56301")
+     * @return Key value (0 if the record does not start with a digit)
+     */
+    static uint32_t ExtractKey(const std::string& rec);
+
+    /**
+     * @brief Parses a ZIP code given as a string of decimal digits.
+     *
+     * Unlike ExtractKey() it rejects anything else, so "-5" or "4295057506"
+     * does not name some other ZIP.
+     *
+     * @param key Text to parse
+     * @param zip Set to the value when the text is valid
+     * @return true if @p key is only digits and fits in 32 bits
+     */
+    static bool ParseKey(const std::string& key, uint32_t& zip);
+
+    /**
+     * @brief Encodes a record for the page relative to the record before it.
+     *
+     * The first record of a page (@p prev == nullptr) is stored verbatim.
+     * Otherwise the key becomes its delta from the previous key, and each
+     * other field becomes:
+     *   - "=" if it equals the previous record's field,
+     *   - "+n|suffix" if it shares an n-character prefix (n >= 4) with it,
+     *   - the field itself otherwise (escaped as "+0|field" if it starts
+     *     with '=' or '+').
+     *
+     * @param rec Record to encode
+     * @param prev Previous record on the page, or nullptr
+     * @return Encoded record text
+     */
+    static std::string EncodeRecord(const std::string& rec, const std::string* prev);
+
+    /**
+     * @brief Reverses EncodeRecord().
+     *
+     * @param enc Encoded record text
+     * @param prev Previously decoded record on the page, or nullptr
+     * @return Original record
+     */
+    static std::string DecodeRecord(const std::string& enc, const std::string* prev);
+
+    /**
+     * @brief Binary-searches the slot directory for a key.
+     *
+     * @param key Primary key to look for
+     * @return Index of the matching record, or -1 if not present
+     */
+    int FindSlot(uint32_t key) const;
+
+    /**
+     * @brief Retrieves the record with the given key.
+     *
+     * @param key Primary key to look for
+     * @param outRecord Receives the record when found
+     * @return true if found; false otherwise
+     */
+    bool FindRecord(uint32_t key, std::string& outRecord) const;
+
+    /**
+     * @brief Starts loading the key array into the cache ahead of FindSlot().
+     */
+    void PrefetchKeys() const;
+
     /**
      * @brief Inserts a record maintaining sorted order by primary key.
      *
@@ -246,14 +504,38 @@ public:
      */
     void InsertSorted(const std::string& rec);
 
+    /**
+     * @brief Page bytes @p rec would add if inserted in key order.
+     *
+     * The record is encoded against the record before its slot, so the cost
+     * differs from page to page; it is at most its length plus one newline
+     * when it would be the page's first record.
+     *
+     * @param rec Record string
+     * @return Encoded bytes added, before any page compression
+     */
+    int InsertCost(const std::string& rec) const;
+
     /**
      * @brief Checks if a record of the given length can fit in free space.
      *
+     * A record costs its encoded length plus one newline on disk (see InsertCost()).
+     *
      * @param rec Record string to check
      * @return true if the block has sufficient space; false otherwise
      */
     bool HasSpace(const std::string& rec) const;
 
+    /**
+     * @brief Moves the upper half of this block's records into @p right.
+     *
+     * Used to split a full block. Links are not changed; the caller relinks
+     * the chain.
+     *
+     * @param right Empty block that receives the records with the highest keys
+     */
+    void MoveUpperHalf(Block& right);
+
     /**
      * @brief Removes a record by its primary key.
      *
@@ -262,6 +544,14 @@ public:
      */
     bool DeleteRecord(const std::string& key);
 
+    /**
+     * @brief Removes a record by its integer primary key.
+     *
+     * @param key Primary key of the record to delete
+     * @return true if record found and deleted; false if not found
+     */
+    bool DeleteRecord(uint32_t key);
+
     /** @} */
 };
 
@@ -7,56 +7,482 @@
  * deleting, serializing, and displaying records across multiple blocks.
  */
 #include "BlockedSequenceSet.h"
+#include "AsyncPageReader.h"
 #include "Block.h"
+#include "HeaderRecord.h"
+#include "ThreadPool.h"
+#include "WriteAheadLog.h"
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <map>
 #include <vector>
 #include <cstdint>
+#include <algorithm>
+#include <utility>
 using namespace std;
 
 /**
  * @brief Constructs a BlockedSequenceSet associated with a target filename.
  *
  * @param fname Name of the file to which blocks will eventually be written.
+ * @param blkSize Size of each block in bytes.
+ * @param codec_ Page codec for the leaves.
  *
  * Initializes an empty block vector.
  */
-BlockedSequenceSet::BlockedSequenceSet(const std::string& fname) : filename(fname) {
+BlockedSequenceSet::BlockedSequenceSet(const std::string& fname, int blkSize, PageCodecType codec_)
+    : snapshotEpoch(0), filename(fname), blockSize(blkSize), codec(codec_), checkpointLSN(0),
+      indexRootRBN(-1), indexHeight(0), availHead(-1), chainHead(-1), chainTail(-1), freeSpace(blkSize),
+      fileCurrent(false) {
     blocks.clear();
 }
 
 /**
- * @brief Adds a record to the last block or creates a new block if necessary.
+ * @brief Copies block @p rbn if it was shared with a snapshot since it was last copied.
+ *
+ * @param rbn RBN of the block to modify.
+ * @return The block, private to this set.
+ */
+Block& BlockedSequenceSet::MutableBlock(int rbn) {
+    if (blockEpochs[rbn] != snapshotEpoch) {
+        blocks[rbn] = std::make_shared<Block>(*blocks[rbn]);
+        blockEpochs[rbn] = snapshotEpoch;
+    }
+    return *blocks[rbn];
+}
+
+/**
+ * @brief Free bytes of a leaf; a free block takes records only once reused.
+ */
+void BlockedSequenceSet::NoteFreeSpace(int rbn) {
+    const Block& block = *blocks[rbn];
+    freeSpace.Update(rbn, block.GetType() == LEAF_BLOCK ? block.GetFreeSpace() : 0);
+}
+
+/**
+ * @brief Shares the current blocks in chain order and starts a new epoch.
+ *
+ * @return The blocks; none of them is modified afterwards.
+ */
+std::vector<std::shared_ptr<const Block>> BlockedSequenceSet::Snapshot() const {
+    ++snapshotEpoch;
+    std::vector<std::shared_ptr<const Block>> leaves;
+    leaves.reserve(blocks.size());
+    for (int rbn = GetHeadRBN(); rbn != -1 && leaves.size() < blocks.size(); rbn = blocks[rbn]->GetNextRBN()) {
+        leaves.push_back(blocks[rbn]);
+    }
+    return leaves;
+}
+
+/**
+ * @brief Creates an empty block and links it into the chain after @p afterRBN.
+ *
+ * @param afterRBN RBN of the predecessor block, or -1 for an unlinked block.
+ * @return RBN of the new block: the head of the avail list, or else the
+ *         next physical position.
+ */
+int BlockedSequenceSet::NewBlockAfter(int afterRBN) {
+    int rbn = availHead;
+    if (rbn != -1) {
+        availHead = blocks[rbn]->GetNextRBN();
+    } else {
+        rbn = static_cast<int>(blocks.size());
+        blocks.emplace_back();
+        blockEpochs.push_back(snapshotEpoch);
+    }
+    Block newBlock(rbn, blockSize, codec);
+    if (afterRBN >= 0) {
+        int nextRBN = blocks[afterRBN]->GetNextRBN();
+        newBlock.SetPrevRBN(afterRBN);
+        newBlock.SetNextRBN(nextRBN);
+        MutableBlock(afterRBN).SetNextRBN(rbn);
+        if (nextRBN >= 0) MutableBlock(nextRBN).SetPrevRBN(rbn);
+        if (afterRBN == chainTail) chainTail = rbn;
+    } else if (chainHead == -1) {
+        chainHead = chainTail = rbn;  // the first leaf
+    }
+    // A reused block is replaced, not changed: snapshots keep the free page
+    blocks[rbn] = std::make_shared<Block>(std::move(newBlock));
+    blockEpochs[rbn] = snapshotEpoch;
+    NoteFreeSpace(rbn);
+    return rbn;
+}
+
+/**
+ * @brief Adds a record to the tail leaf or creates a new block if necessary.
  *
  * @param rec The record string to be added.
  *
- * If the last block does not have enough space for the record, a new block
- * is created. Each new block has a default size of 512 bytes.
+ * If the tail leaf does not have enough space for the record, a new block
+ * of @c blockSize bytes is created and linked after it.
  */
 void BlockedSequenceSet::AddRecord(const std::string& rec) {
-    if (blocks.empty() || blocks.back().GetFreeSpace() < static_cast<int>(rec.size())) {
-        Block newBlock(blocks.size(), 512);
-        blocks.push_back(newBlock);
+    int last = chainTail;
+    // Checked before MutableBlock(), which copies a block shared with a snapshot
+    if (last >= 0 && blocks[last]->HasSpace(rec)) {
+        MutableBlock(last).AddRecord(rec);
+        NoteFreeSpace(last);
+        return;
+    }
+
+    last = NewBlockAfter(last);
+    if (!blocks[last]->AddRecord(rec)) {
+        std::cerr << "Record too large for " << blockSize << "-byte blocks: "
+                  << rec.substr(0, rec.find(',')) << "\n";
+    }
+    NoteFreeSpace(last);
+}
+
+/**
+ * @brief Asks the free-space map for a leaf with room for @p rec.
+ *
+ * @param rec The record string to insert.
+ */
+void BlockedSequenceSet::InsertWhereFits(const std::string& rec) {
+    if (chainTail != -1) {
+        // The encoded size depends on the neighbours: the cost in the tail leaf
+        // picks a page, and the cost at the record's slot there decides
+        int rbn = freeSpace.Find(blocks[chainTail]->InsertCost(rec));
+        if (rbn != -1 && blocks[rbn]->HasSpace(rec)) {
+            MutableBlock(rbn).AddRecord(rec);
+            NoteFreeSpace(rbn);
+            return;
+        }
+    }
+    AddRecord(rec);
+}
+
+/**
+ * @brief Unlinks the empty leaf @p rbn and pushes it on the avail list.
+ *
+ * @param rbn RBN of the leaf.
+ * @return True if the block was freed.
+ */
+bool BlockedSequenceSet::FreeBlock(int rbn) {
+    if (rbn < 0 || rbn >= static_cast<int>(blocks.size())) return false;
+    const Block& block = *blocks[rbn];
+    if (block.GetType() != LEAF_BLOCK || block.GetRecordCount() > 0) return false;
+    int prevRBN = block.GetPrevRBN();
+    int nextRBN = block.GetNextRBN();
+    if (prevRBN == -1 && nextRBN == -1) return false;  // the only leaf
+
+    if (prevRBN != -1) MutableBlock(prevRBN).SetNextRBN(nextRBN);
+    if (nextRBN != -1) MutableBlock(nextRBN).SetPrevRBN(prevRBN);
+    if (rbn == chainHead) chainHead = nextRBN;
+    if (rbn == chainTail) chainTail = prevRBN;
+
+    Block freed(rbn, blockSize, codec);
+    freed.SetType(AVAIL_BLOCK);
+    freed.SetNextRBN(availHead);
+    blocks[rbn] = std::make_shared<Block>(std::move(freed));
+    blockEpochs[rbn] = snapshotEpoch;
+    availHead = rbn;
+    NoteFreeSpace(rbn);
+    return true;
+}
+
+/**
+ * @brief Counts the blocks on the avail list.
+ *
+ * @return Number of free blocks.
+ */
+int BlockedSequenceSet::GetFreeBlockCount() const {
+    int count = 0;
+    for (int rbn = availHead; rbn != -1 && count < static_cast<int>(blocks.size()); rbn = blocks[rbn]->GetNextRBN()) {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Builds the header page: the superblock followed by zero bytes.
+ *
+ * @return One block holding the HeaderRecord superblock.
+ */
+std::string BlockedSequenceSet::HeaderPage() const {
+    HeaderRecord header(blockSize);
+    header.SetRecordCount(GetTotalRecords());
+    header.SetCodec(codec);
+    header.SetCheckpointLSN(checkpointLSN);
+    header.SetPageChecksums(true);
+    header.SetRoot(indexRootRBN, indexHeight);
+    header.SetLeafChain(GetHeadRBN(), GetTailRBN());
+    header.SetAvailHead(availHead);
+
+    std::ostringstream superblock;
+    header.Write(superblock);
+    std::string page = superblock.str();
+    page.resize(static_cast<size_t>(blockSize), '\0');
+    return page;
+}
+
+/**
+ * @brief Splits blocks whose records do not fit their page, even compressed.
+ *
+ * @return Number of blocks added.
+ */
+int BlockedSequenceSet::SplitOverfullBlocks() {
+    int added = 0;
+    for (size_t rbn = 0; rbn < blocks.size(); ++rbn) {
+        while (!blocks[rbn]->FitsPage() && blocks[rbn]->GetRecordCount() > 1) {
+            int newRBN = NewBlockAfter(static_cast<int>(rbn));
+            MutableBlock(static_cast<int>(rbn)).MoveUpperHalf(*blocks[newRBN]);
+            NoteFreeSpace(static_cast<int>(rbn));
+            NoteFreeSpace(newRBN);
+            ++added;
+        }
+    }
+    return added;
+}
+
+/**
+ * @brief Serializes the header page and all blocks in human-readable format.
+ *
+ * The header page holds the HeaderRecord superblock (see HeaderRecord.h);
+ * each block is serialized by Block::Serialize() into its
+ * own fixed-size page, on the shared thread pool.
+ *
+ * @param out Stream positioned at the start of the file.
+ * @return True if the stream is still good after the last page.
+ */
+bool BlockedSequenceSet::Write(std::ofstream& out) {
+    SplitOverfullBlocks();
+
+    std::string header = HeaderPage();
+    out.write(header.data(), header.size());
+
+    // Pages are encoded (and compressed) in parallel a batch at a time and
+    // written in RBN order
+    const size_t batch = 256;
+    std::vector<std::string> pages;
+    for (size_t first = 0; first < blocks.size(); first += batch) {
+        size_t count = std::min(batch, blocks.size() - first);
+        pages.assign(count, std::string());
+        ThreadPool::Shared().ParallelFor(0, count, 16, [&](size_t lo, size_t hi) {
+            for (size_t i = lo; i < hi; ++i) pages[i] = blocks[first + i]->Serialize();
+        });
+        for (const auto& page : pages) out.write(page.data(), page.size());
+    }
+    return out.good();
+}
+
+/**
+ * @brief Stages the header page and the dirty blocks at their offsets.
+ *
+ * @param file Open page file of this sequence set's file.
+ */
+void BlockedSequenceSet::StageDirtyPages(PageFile& file) const {
+    file.Stage(0, HeaderPage());
+    for (const auto& block : blocks) {
+        if (block->IsDirty()) {
+            file.Stage(static_cast<long long>(block->GetRBN() + 1) * blockSize, block->Serialize());
+        }
+    }
+}
+
+/**
+ * @brief Marks every block as written.
+ */
+void BlockedSequenceSet::MarkClean() {
+    for (const auto& block : blocks) block->ClearDirty();
+    fileCurrent = true;
+}
+
+/**
+ * @brief Writes the changed pages in place, or the whole file if it is not current.
+ *
+ * @param sync Journal and sync the batch.
+ * @return True if every page was written.
+ */
+bool BlockedSequenceSet::Flush(bool sync) {
+    if (!fileCurrent) {
+        WriteToFile();
+        return fileCurrent;
+    }
+
+    SplitOverfullBlocks();
+    PageFile file;
+    if (!file.Open(filename)) {
+        std::cerr << "Cannot open file: " << filename << "\n";
+        return false;
     }
-    blocks.back().AddRecord(rec);
+    StageDirtyPages(file);
+    if (!file.Commit(sync, static_cast<long long>(blocks.size() + 1) * blockSize)) return false;
+    MarkClean();
+    return true;
 }
 
 /**
- * @brief Serializes all blocks to the configured file in human-readable format.
+ * @brief Writes the file through a temporary copy that replaces it atomically.
  *
- * Each block is written using Block::Write().
- * Existing file content is overwritten.
+ * Existing file content is overwritten. A journal left by an interrupted
+ * in-place commit is applied to the old file first, not to the new one.
  */
 void BlockedSequenceSet::WriteToFile() {
-    std::ofstream out(filename);
+    // A journal left by a failed in-place commit would be replayed over the new file
+    if (!PageFile::Recover(filename)) return;
+    std::string tempFile = filename + ".tmp";
+    std::ofstream out(tempFile, std::ios::binary | std::ios::trunc);
     if (!out.is_open()) {
-        std::cerr << "Cannot open file: " << filename << "\n";
+        std::cerr << "Cannot open file: " << tempFile << "\n";
         return;
     }
-    for (const auto& block : blocks) block.Write(out);
+    bool written = Write(out);
     out.close();
+    if (!written || !WriteAheadLog::ReplaceFile(tempFile, filename)) {
+        std::cerr << "Cannot write file: " << filename << "\n";
+        return;
+    }
+    MarkClean();
+}
+
+/**
+ * @brief Reads the leaf pages of @p file in RBN order with up to @p depth
+ *        reads in flight, handing each parsed leaf to @p visit.
+ *
+ * Reads finish in any order; pages that arrive early wait (counted against
+ * @p depth) until their turn. Stops at the first index page, at the end of
+ * the file, or when @p visit returns false.
+ */
+static bool streamPages(const std::string& file, const HeaderRecord& header, unsigned depth,
+                        const std::function<bool(Block&)>& visit) {
+    const int blockSize = header.GetBlockSize();
+    std::ifstream sized(file, std::ios::binary | std::ios::ate);
+    long long fileSize = sized.is_open() ? static_cast<long long>(sized.tellg()) : 0;
+    int pages = static_cast<int>(std::max(0LL, (fileSize - 1) / blockSize));
+
+    AsyncPageReader reader(depth);
+    if (!reader.Open(file)) {
+        std::cerr << "Cannot open file: " << file << "\n";
+        return false;
+    }
+
+    std::map<int, std::string> arrived;
+    int nextRead = 0;
+    for (int rbn = 0; rbn < pages; ++rbn) {
+        auto page = arrived.find(rbn);
+        while (page == arrived.end()) {
+            while (nextRead < pages && reader.InFlight() + arrived.size() < reader.GetQueueDepth() &&
+                   reader.Submit(static_cast<uint64_t>(nextRead), (nextRead + 1LL) * blockSize,
+                                 static_cast<size_t>(blockSize))) {
+                ++nextRead;
+            }
+            CompletedRead done;
+            if (!reader.WaitNext(done) || !done.ok) {
+                std::cerr << "Cannot read block " << rbn << " in file: " << file << "\n";
+                return false;
+            }
+            arrived[static_cast<int>(done.tag)] = std::move(done.bytes);
+            page = arrived.find(rbn);
+        }
+
+        if (header.HasPageChecksums() && !Block::VerifyPage(page->second)) {
+            std::cerr << "Checksum mismatch in block " << rbn << " of file: " << file << "\n";
+            return false;
+        }
+        std::istringstream text(page->second);
+        Block block;
+        bool parsed = block.Read(text, blockSize, header.GetCodec()) && block.GetRBN() == rbn;
+        arrived.erase(page);
+        if (!parsed) {
+            std::cerr << "Bad block " << rbn << " in file: " << file << "\n";
+            return false;
+        }
+        if (!visit(block)) break;
+    }
+    return true;
+}
+
+/**
+ * @brief Loads the header page and leaf blocks written by WriteToFile().
+ *
+ * @return True if the file was opened and every leaf page parsed.
+ */
+bool BlockedSequenceSet::ReadFromFile(std::vector<Block>* indexPages) {
+    // Finish an in-place flush that was interrupted by a crash
+    if (!PageFile::Recover(filename)) return false;
+    fileCurrent = false;
+
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open file: " << filename << "\n";
+        return false;
+    }
+
+    HeaderRecord header;
+    if (!header.Read(in) || header.GetBlockSize() <= Block::PAGE_OVERHEAD) {
+        std::cerr << "Bad header in file: " << filename << "\n";
+        return false;
+    }
+    blockSize = header.GetBlockSize();
+    codec = header.GetCodec();
+    checkpointLSN = header.GetCheckpointLSN();
+    indexRootRBN = header.GetRootRBN();
+    indexHeight = header.GetTreeHeight();
+    availHead = header.GetAvailHead();
+
+    in.close();
+
+    blocks.clear();
+    blockEpochs.clear();
+    if (indexPages != nullptr) indexPages->clear();
+    bool read = streamPages(filename, header, READ_AHEAD_PAGES, [this, indexPages](Block& block) {
+        if (block.GetType() == INDEX_BLOCK) {
+            // Index pages follow the leaves
+            if (indexPages == nullptr) return false;
+            indexPages->push_back(std::move(block));
+            return true;
+        }
+        if (indexPages != nullptr && !indexPages->empty()) return false;  // nothing follows the index
+        blocks.push_back(std::make_shared<Block>(std::move(block)));
+        blockEpochs.push_back(snapshotEpoch);
+        return true;
+    });
+    if (!read) return false;
+
+    // Trust the stored chain ends only if they are the ends of the leaf chain
+    auto isEnd = [this](int rbn, bool head) {
+        if (rbn < 0 || rbn >= static_cast<int>(blocks.size())) return rbn == -1 && blocks.empty();
+        const Block& block = *blocks[rbn];
+        return block.GetType() == LEAF_BLOCK && (head ? block.GetPrevRBN() : block.GetNextRBN()) == -1;
+    };
+    chainHead = header.GetHeadRBN();
+    chainTail = header.GetTailRBN();
+    if (!isEnd(chainHead, true) || !isEnd(chainTail, false)) FindChainEnds();
+
+    // Every block on the avail list must be a free block, and the list must end
+    int listed = 0;
+    for (int rbn = availHead; rbn != -1; rbn = blocks[rbn]->GetNextRBN()) {
+        if (rbn < 0 || rbn >= static_cast<int>(blocks.size()) || blocks[rbn]->GetType() != AVAIL_BLOCK ||
+            ++listed > static_cast<int>(blocks.size())) {
+            std::cerr << "Bad avail list in file: " << filename << "\n";
+            return false;
+        }
+    }
+    freeSpace.Reset(blockSize);
+    for (size_t rbn = 0; rbn < blocks.size(); ++rbn) NoteFreeSpace(static_cast<int>(rbn));
+    // A file from before page checksums is rewritten whole, so no page is left unsealed
+    fileCurrent = header.HasPageChecksums();
+    return true;
+}
+
+bool BlockedSequenceSet::ScanFile(const std::string& file, unsigned depth,
+                                  const std::function<bool(const Block&)>& visit) {
+    if (!PageFile::Recover(file)) return false;
+
+    std::ifstream in(file, std::ios::binary);
+    HeaderRecord header;
+    if (!in.is_open() || !header.Read(in) || header.GetBlockSize() <= Block::PAGE_OVERHEAD) {
+        std::cerr << "Bad header in file: " << file << "\n";
+        return false;
+    }
+    in.close();
+    return streamPages(file, header, depth, [&visit](Block& block) {
+        if (block.GetType() == INDEX_BLOCK) return false;  // index pages follow the leaves
+        return block.GetType() == AVAIL_BLOCK || visit(block);
+    });
 }
 
 /**
@@ -69,7 +495,7 @@ void BlockedSequenceSet::PrintSummary() const {
     std::cout << "File: " << filename << "\n";
     std::cout << "Total records: " << GetTotalRecords() << "\n";
     std::cout << "Total blocks: " << GetTotalBlocks() << "\n";
-    for (const auto& block : blocks) block.PrintSummary();
+    for (const auto& block : blocks) block->PrintSummary();
 }
 
 /**
@@ -79,7 +505,7 @@ void BlockedSequenceSet::PrintSummary() const {
  */
 int BlockedSequenceSet::GetTotalRecords() const {
     int total = 0;
-    for (const auto& block : blocks) total += block.GetRecordCount();
+    for (const auto& block : blocks) total += block->GetRecordCount();
     return total;
 }
 
@@ -101,18 +527,23 @@ int BlockedSequenceSet::GetTotalBlocks() const {
  */
 bool BlockedSequenceSet::Search(const std::string& key, std::string& outRecord)
 {
-    for (const Block& block : blocks)
+    return Search(Block::ExtractKey(key), outRecord);
+}
+
+/**
+ * @brief Searches for a record by its integer key.
+ *
+ * @param key The ZIP code to search for.
+ * @param outRecord Reference to string to store the found record.
+ * @return True if a matching record was found, false otherwise.
+ */
+bool BlockedSequenceSet::Search(uint32_t key, std::string& outRecord) const
+{
+    for (const auto& block : blocks)
     {
-        for (const std::string& rec : block.getRecords())
+        if (block->FindRecord(key, outRecord))
         {
-            // Each record is CSV; extract the key (Zip Code)
-            std::string recordKey = rec.substr(0, rec.find(','));
-
-            if (recordKey == key)
-            {
-                outRecord = rec;
-                return true;
-            }
+            return true;
         }
     }
     return false;
@@ -123,50 +554,174 @@ bool BlockedSequenceSet::Search(const std::string& key, std::string& outRecord)
  *
  * @param record The CSV record string to insert.
  *
- * This method attempts to maintain records sorted by key within each block.
- * If no suitable block exists, a new block is created at the end.
+ * Follows the chain in logical order to the first block whose highest key
+ * covers the record, and inserts there (splitting the block if it is full).
+ * If no block covers the key, the record goes to the tail block.
  */
 void BlockedSequenceSet::Insert(const std::string& record)
 {
-    std::string key = record.substr(0, record.find(','));
+    uint32_t key = Block::ExtractKey(record);
 
-    for (Block& block : blocks)
+    int rbn = GetHeadRBN();
+    int lastRBN = -1;
+    while (rbn != -1)
     {
+        const Block& block = *blocks[rbn];
         if (block.GetRecordCount() == 0 ||
-            key <= block.getHighestKey())
+            key <= block.GetHighestKeyValue())
         {
-            block.InsertSorted(record);
+            InsertIntoBlock(rbn, record);
             return;
         }
+        lastRBN = rbn;
+        rbn = block.GetNextRBN();
     }
 
     // if no block found, append to last block
-    if (blocks.empty() || !blocks.back().HasSpace(record))
+    if (lastRBN == -1)
+    {
+        lastRBN = NewBlockAfter(-1);
+    }
+    InsertIntoBlock(lastRBN, record);
+}
+
+/**
+ * @brief Inserts a record into block @p rbn, splitting it when full.
+ *
+ * @param rbn RBN of the block covering the record's key.
+ * @param record The CSV record string to insert.
+ * @return RBN of the block holding the record, or -1 if it can never fit.
+ */
+int BlockedSequenceSet::InsertIntoBlock(int rbn, const std::string& record)
+{
+    if (blocks[rbn]->HasSpace(record))
+    {
+        MutableBlock(rbn).InsertSorted(record);
+        NoteFreeSpace(rbn);
+        return rbn;
+    }
+    if (!FitsBlock(record))
+    {
+        std::cerr << "Record too large for " << blockSize << "-byte blocks: "
+                  << record.substr(0, record.find(',')) << "\n";
+        return -1;
+    }
+
+    // Split: upper half moves to a new block linked right after this one
+    uint32_t key = Block::ExtractKey(record);
+    int newRBN = NewBlockAfter(rbn);
+    if (blocks[rbn]->GetRecordCount() < 2)
     {
-        blocks.push_back(Block(blocks.size(), 512));
+        // One record that cannot share a page: the new record gets a page of its
+        // own on the side its key belongs, so the chain stays in key order
+        if (key < blocks[rbn]->GetHighestKeyValue())
+        {
+            MutableBlock(rbn).MoveUpperHalf(*blocks[newRBN]);
+            std::swap(rbn, newRBN);
+        }
+        MutableBlock(newRBN).InsertSorted(record);
+        NoteFreeSpace(rbn);
+        NoteFreeSpace(newRBN);
+        return newRBN;
     }
+    MutableBlock(rbn).MoveUpperHalf(*blocks[newRBN]);
+    NoteFreeSpace(rbn);
+    NoteFreeSpace(newRBN);
 
-    blocks.back().InsertSorted(record);
+    int target = (blocks[rbn]->GetRecordCount() > 0 &&
+                  key <= blocks[rbn]->GetHighestKeyValue()) ? rbn : newRBN;
+    return InsertIntoBlock(target, record);
 }
 
 /**
  * @brief Deletes a record by key from the sequence set.
  *
  * @param key The key identifying the record to delete.
- * @return True if deletion succeeded, false if key not found.
+ * @return True if deletion succeeded, false if key not found or not a ZIP.
  */
 bool BlockedSequenceSet::Delete(const std::string& key)
 {
-    for (Block& block : blocks)
+    uint32_t zip;
+    if (!Block::ParseKey(key, zip)) return false;
+    for (size_t rbn = 0; rbn < blocks.size(); ++rbn)
     {
-        if (block.DeleteRecord(key))
+        if (blocks[rbn]->FindSlot(zip) >= 0)
         {
+            if (!MutableBlock(static_cast<int>(rbn)).DeleteRecord(zip)) return false;
+            NoteFreeSpace(static_cast<int>(rbn));
+            if (blocks[rbn]->GetRecordCount() == 0) FreeBlock(static_cast<int>(rbn));
             return true;
         }
     }
     return false;
 }
 
+/**
+ * @brief Deletes a record by key from one block.
+ *
+ * @param rbn RBN of the block covering the key.
+ * @param key The key identifying the record to delete.
+ * @return True if deletion succeeded, false if key not found.
+ */
+bool BlockedSequenceSet::DeleteFromBlock(int rbn, uint32_t key)
+{
+    if (rbn < 0 || rbn >= static_cast<int>(blocks.size()) || blocks[rbn]->FindSlot(key) < 0) return false;
+    if (!MutableBlock(rbn).DeleteRecord(key)) return false;
+    NoteFreeSpace(rbn);
+    return true;
+}
+
+/**
+ * @brief Finds the leaves with no predecessor and no successor.
+ */
+void BlockedSequenceSet::FindChainEnds()
+{
+    chainHead = chainTail = -1;
+    for (const auto& block : blocks)
+    {
+        if (block->GetType() != LEAF_BLOCK) continue;
+        if (chainHead == -1 && block->GetPrevRBN() == -1) chainHead = block->GetRBN();
+        if (chainTail == -1 && block->GetNextRBN() == -1) chainTail = block->GetRBN();
+    }
+}
+
+/**
+ * @brief Re-packs every record into full blocks in ascending key order.
+ */
+void BlockedSequenceSet::SortByKey()
+{
+    std::vector<std::pair<uint32_t, std::string>> keyed;
+    keyed.reserve(GetTotalRecords());
+    for (const auto& block : blocks)
+    {
+        const auto& recs = block->getRecords();
+        const auto& keys = block->GetKeys();
+        for (size_t i = 0; i < recs.size(); ++i) keyed.emplace_back(keys[i], recs[i]);
+    }
+    std::stable_sort(keyed.begin(), keyed.end(),
+                     [](const std::pair<uint32_t, std::string>& a,
+                        const std::pair<uint32_t, std::string>& b) { return a.first < b.first; });
+
+    blocks.clear();
+    blockEpochs.clear();
+    availHead = -1;
+    chainHead = chainTail = -1;
+    freeSpace.Reset(blockSize);
+    for (const auto& kr : keyed) AddRecord(kr.second);
+}
+
+void BlockedSequenceSet::Clear()
+{
+    blocks.clear();
+    blockEpochs.clear();
+    indexRootRBN = -1;
+    indexHeight = 0;
+    availHead = -1;
+    chainHead = chainTail = -1;
+    freeSpace.Reset(blockSize);
+    fileCurrent = false;
+}
+
 
 /**
  * @brief Returns a copy of the internal vector of blocks.
@@ -174,7 +729,10 @@ bool BlockedSequenceSet::Delete(const std::string& key)
  * @return Vector of Block objects.
  */
 const std::vector<Block> BlockedSequenceSet::getBlocks() const {
-    return blocks;
+    std::vector<Block> copies;
+    copies.reserve(blocks.size());
+    for (const auto& block : blocks) copies.push_back(*block);
+    return copies;
 }
 
 /**
@@ -186,7 +744,7 @@ const std::vector<std::string> BlockedSequenceSet::getRecords() const
 {
     std::vector<std::string> allRecords;
     for (const auto& block : blocks) {
-        const auto& recs = block.getRecords();
+        const auto& recs = block->getRecords();
         allRecords.insert(allRecords.end(), recs.begin(), recs.end());
     }
     return allRecords;
@@ -199,9 +757,9 @@ const std::vector<std::string> BlockedSequenceSet::getRecords() const
  */
 void BlockedSequenceSet::dumpPhysicalOrder()
 { 
-    for(const Block& block: blocks) 
+    for(const auto& block: blocks) 
     {
-        block.DumpContents();
+        block->DumpContents();
         
     }
 }
@@ -218,26 +776,25 @@ void BlockedSequenceSet::dumpLogicOrder()
     // Build a map from RBN to Block pointer for quick lookup
     std::map<int, const Block*> rbnToBlock;
     for (const auto& block : blocks) {
-        rbnToBlock[block.GetRBN()] = &block;
+        rbnToBlock[block->GetRBN()] = block.get();
     }
 
-    // Find the logical head block (the one with no predecessor)
-    int headRBN = -1;
-    for (const auto& block : blocks) {
-        if (block.GetPrevRBN() == -1) {
-            headRBN = block.GetRBN();
-            break;
-        }
-    }
-    if (headRBN == -1) return; // No head found
+    // Find the logical head block (the leaf with no predecessor)
+    int headRBN = GetHeadRBN();
 
     // Traverse blocks in logical order
     int currentRBN = headRBN;
-    while (rbnToBlock.count(currentRBN)) {
+    while (headRBN != -1 && rbnToBlock.count(currentRBN)) {
         const Block* block = rbnToBlock[currentRBN];
         block->DumpLogicOrder();
         int nextRBN = block->GetNextRBN();
         if (nextRBN == -1 || nextRBN == currentRBN) break;
         currentRBN = nextRBN;
     }
+
+    // Then the avail list
+    int freeCount = GetFreeBlockCount();
+    for (int rbn = availHead; freeCount-- > 0; rbn = blocks[rbn]->GetNextRBN()) {
+        blocks[rbn]->DumpLogicOrder();
+    }
 }
\ No newline at end of file
@@ -11,6 +11,23 @@
  *
  * The structure works by grouping multiple logical records into fixed-size
  * blocks, allowing efficient reading and writing operations.
+ *
+ * File layout: page 0 holds the HeaderRecord superblock (block size, record count, codec,
+ * checkpoint LSN, index root and height, leaf chain ends), padded to one block;
+ * block RBN r follows at byte (r + 1) * blockSize.
+ *
+ * A leaf emptied by deletes is unlinked from the chain and pushed on the
+ * avail list: it becomes an AVAIL_BLOCK whose next RBN is the next free
+ * block, and the list's head is kept in the superblock. New blocks are taken
+ * from the avail list before the file is extended, so the file does not grow
+ * under a steady mix of inserts and deletes. A FreeSpaceMap tracks the free
+ * bytes of every leaf, so InsertWhereFits() finds a page with room without
+ * visiting the blocks.
+ *
+ * Blocks are shared, copy-on-write pages: Snapshot() hands out the current
+ * pages, and the first change to a page after a snapshot replaces it with a
+ * private copy, so the snapshot keeps the version it was given. A page
+ * version is freed when the last snapshot holding it is destroyed.
  */
 #ifndef BLOCKEDSEQUENCESET_H
 #define BLOCKEDSEQUENCESET_H
@@ -18,7 +35,13 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
 #include "Block.h"
+#include "FreeSpaceMap.h"
+#include "PageFile.h"
 
 /**
  * @class BlockedSequenceSet
@@ -46,9 +69,22 @@ private:
      *
      * Blocks are stored in RBN order (i.e., element index in the vector
      * corresponds to block number). This keeps the model simple and enables
-     * predictable sequential storage.
+     * predictable sequential storage. Each block may also be held by
+     * snapshots, so it is changed only through MutableBlock().
+     */
+    std::vector<std::shared_ptr<Block>> blocks;
+
+    /**
+     * @brief Snapshot epoch at which each block became private to this set.
+     *
+     * A block whose entry differs from @c snapshotEpoch may be in a snapshot.
+     */
+    std::vector<uint64_t> blockEpochs;
+
+    /**
+     * @brief Number of snapshots taken so far.
      */
-    std::vector<Block> blocks;
+    mutable uint64_t snapshotEpoch;
 
     /**
      * @brief The name of the file to which this BlockedSequenceSet will be written.
@@ -57,34 +93,290 @@ private:
      */
     std::string filename;
 
+    /**
+     * @brief Size in bytes of every block (page) in the file.
+     *
+     * Stored in the file's HeaderRecord and used for every new block.
+     */
+    int blockSize;
+
+    /**
+     * @brief Page codec for every leaf (stored in the HeaderRecord).
+     */
+    PageCodecType codec;
+
+    /**
+     * @brief Write-ahead log LSN reflected in the blocks (stored in the HeaderRecord).
+     */
+    uint64_t checkpointLSN;
+
+    int indexRootRBN;  ///< Tree root recorded in the header (-1 if none)
+    int indexHeight;   ///< Tree height recorded in the header (leaf level included)
+    int availHead;     ///< First block of the avail list (-1 if none); stored in the header
+    int chainHead;     ///< First leaf in key order (-1 if none); stored in the header
+    int chainTail;     ///< Last leaf in key order (-1 if none); stored in the header
+
+    /**
+     * @brief Free bytes of every leaf (0 for free blocks), for InsertWhereFits().
+     */
+    FreeSpaceMap freeSpace;
+
+    /**
+     * @brief True when the file holds every block except those marked dirty.
+     *
+     * Set by WriteToFile() and ReadFromFile(); allows Flush() to write only
+     * the changed pages.
+     */
+    bool fileCurrent;
+
+    /**
+     * @brief Builds the header page: the HeaderRecord superblock padded to one block.
+     */
+    std::string HeaderPage() const;
+
+    /**
+     * @brief Returns block @p rbn for modification, copying it first if a
+     *        snapshot may hold it.
+     *
+     * @param rbn RBN of the block (0 <= rbn < GetTotalBlocks())
+     * @return Reference to a block no snapshot shares
+     */
+    Block& MutableBlock(int rbn);
+
+    /**
+     * @brief Records the current free bytes of block @p rbn in the free-space map.
+     */
+    void NoteFreeSpace(int rbn);
+
+    /**
+     * @brief Sets chainHead and chainTail by scanning the blocks.
+     */
+    void FindChainEnds();
+
+    /**
+     * @brief Creates a new empty block and links it into the chain.
+     *
+     * The block is taken from the avail list when it is not empty, and
+     * appended after the last page otherwise.
+     *
+     * @param afterRBN RBN of the block to link the new block after (-1 for none)
+     * @return RBN of the new block
+     */
+    int NewBlockAfter(int afterRBN);
+
 public:
     /**
      * @brief Constructs a BlockedSequenceSet and associates it with a target filename.
      *
      * @param fname Name of output file used when writing blocks to disk.
+     * @param blkSize Size of each block in bytes (e.g., 512, 4096, 16384).
+     * @param codec_ Page codec for the leaves (CODEC_LZ packs more records per page).
      *
      * The constructor initializes the block container but performs no I/O.
      */
-    BlockedSequenceSet(const std::string& fname);
+    BlockedSequenceSet(const std::string& fname, int blkSize = 512, PageCodecType codec_ = CODEC_NONE);
+
+    /**
+     * @brief Returns the block size used by this sequence set.
+     *
+     * @return Block size in bytes.
+     */
+    int GetBlockSize() const { return blockSize; }
+
+    /**
+     * @brief Returns the page codec used by this sequence set.
+     *
+     * @return CODEC_NONE or CODEC_LZ.
+     */
+    PageCodecType GetCodec() const { return codec; }
+
+    /**
+     * @brief Returns true if @p rec fits an empty block of this set.
+     *
+     * @param rec The record string to check.
+     */
+    bool FitsBlock(const std::string& rec) const { return Block(-1, blockSize, codec).HasSpace(rec); }
+
+    /**
+     * @brief Returns the log LSN recorded with the blocks.
+     *
+     * @return Checkpoint LSN read from or written to the header.
+     */
+    uint64_t GetCheckpointLSN() const { return checkpointLSN; }
+
+    /**
+     * @brief Sets the log LSN written into the header by the next write.
+     *
+     * @param lsn LSN of the last log record applied to the blocks.
+     */
+    void SetCheckpointLSN(uint64_t lsn) { checkpointLSN = lsn; }
+
+    /**
+     * @brief Returns the tree root recorded in the header.
+     *
+     * @return RBN read from or written to the header, -1 if no tree was
+     *         built or the file predates the superblock.
+     */
+    int GetIndexRootRBN() const { return indexRootRBN; }
+
+    /**
+     * @brief Returns the tree height recorded in the header (leaf level included).
+     */
+    int GetIndexHeight() const { return indexHeight; }
+
+    /**
+     * @brief Sets the tree root written into the header by the next write.
+     *
+     * The index pages themselves belong to the caller (see BPlusTree).
+     *
+     * @param rbn RBN of the root page, or -1 for none
+     * @param height Levels from the root down to the leaves, inclusive
+     */
+    void SetIndexRoot(int rbn, int height) { indexRootRBN = rbn; indexHeight = height; }
 
     /**
      * @brief Adds a new record to the sequence set.
      *
-     * If the last block does not have enough space, a new block is created.
+     * If the tail leaf (the last in key order) does not have enough space, a
+     * new block is created and linked after it. A record that cannot fit even in an empty block is
+     * rejected with an error message.
      *
      * @param rec The record string to insert into the Blocked Sequence Set.
      */
     void AddRecord(const std::string& rec);
 
     /**
-     * @brief Writes all blocks to the configured output file.
+     * @brief Adds a record to any leaf with room for it, else as AddRecord().
+     *
+     * The leaf is found through the free-space map, so space left by deletes
+     * is reused. Records land out of key order across blocks; use it only
+     * before the leaves are sorted (see BPlusTree::BuildStaticIndex()).
+     *
+     * @param rec The record string to insert
+     */
+    void InsertWhereFits(const std::string& rec);
+
+    /**
+     * @brief Unlinks an empty leaf from the chain and puts it on the avail list.
+     *
+     * The only leaf of the chain is kept, so the set always has a block to
+     * add records to. The caller rebuilds any index that names the block.
+     *
+     * @param rbn RBN of the leaf
+     * @return true if the block was freed; false if it holds records, is not
+     *         a linked leaf, or is the only leaf
+     */
+    bool FreeBlock(int rbn);
+
+    /**
+     * @brief Returns the first block of the avail list (-1 if none).
+     */
+    int GetAvailHead() const { return availHead; }
+
+    /**
+     * @brief Returns the number of blocks on the avail list.
+     */
+    int GetFreeBlockCount() const;
+
+    /**
+     * @brief Splits every block that does not fit its page, even compressed.
+     *
+     * Inserts into compressed blocks only estimate the compressed size, so
+     * this runs before any page is written.
+     *
+     * @return Number of blocks added by splitting.
+     */
+    int SplitOverfullBlocks();
+
+    /**
+     * @brief Writes the header page and all blocks to an open stream.
+     *
+     * Overfull blocks are split first (see SplitOverfullBlocks()).
+     *
+     * @param out Stream positioned at the start of the file.
+     * @return true if every page was written.
+     */
+    bool Write(std::ofstream& out);
+
+    /**
+     * @brief Writes only the header page and dirty blocks, in place.
+     *
+     * Falls back to WriteToFile() when the file does not hold the current
+     * blocks yet (never written or read).
+     *
+     * @param sync If true the pages are journaled and synced (see PageFile);
+     *             if false they are only written, for callers that sync later
+     * @return true if every page was written
+     */
+    bool Flush(bool sync = true);
+
+    /**
+     * @brief Stages the header page and every dirty block into @p file.
+     *
+     * Used by BPlusTree to write leaves and index pages in one batch.
+     *
+     * @param file Open page file of this sequence set's file
+     */
+    void StageDirtyPages(PageFile& file) const;
+
+    /**
+     * @brief Records that the file now holds every block (clears dirty flags).
+     */
+    void MarkClean();
+
+    /**
+     * @brief Returns true if Flush() can update the file in place.
+     */
+    bool IsFileCurrent() const { return fileCurrent; }
+
+    /**
+     * @brief Writes the header page and all blocks to the configured output file.
      *
      * The output is written in a human-readable text format defined by Block::Write().
+     * The pages go to "<filename>.tmp", which then replaces the file (see
+     * WriteAheadLog::ReplaceFile()), so a crash leaves the old or the new file.
      *
      * @note Existing file contents are overwritten.
      */
     void WriteToFile();
 
+    /**
+     * @brief Loads the header page and all leaf blocks from the configured file.
+     *
+     * The block size, codec, index root and leaf chain ends are taken from the
+     * file's HeaderRecord; chain ends that do not match the leaves (or a legacy
+     * header without them) are found by scanning the leaves instead.
+     * The index pages written by BPlusTree follow the leaves: they are read
+     * into @p indexPages when it is given, and otherwise reading stops at the
+     * first one.
+     *
+     * @param indexPages Receives the index pages in RBN order (may be null)
+     * @return true if the file was read; false if it is missing or malformed
+     */
+    bool ReadFromFile(std::vector<Block>* indexPages = nullptr);
+
+    /**
+     * @brief Leaf pages kept in flight ahead of the parser by ReadFromFile()
+     *        and ScanFile().
+     */
+    static const unsigned READ_AHEAD_PAGES = 32;
+
+    /**
+     * @brief Streams the leaf pages of a file without loading them into a set.
+     *
+     * Pages are visited in RBN order, which is key order in a file written
+     * after BPlusTree::BuildStaticIndex(). Up to @p depth page reads are in
+     * flight ahead of @p visit (see AsyncPageReader.h), so a cold scan keeps
+     * the device busy. Stops at the first index page.
+     *
+     * @param file Path of a file written by WriteToFile() or BPlusTree
+     * @param depth Page reads kept in flight
+     * @param visit Called with each leaf; returns false to stop early
+     * @return true if every visited page parsed (also when stopped early)
+     */
+    static bool ScanFile(const std::string& file, unsigned depth,
+                         const std::function<bool(const Block&)>& visit);
+
     /**
      * @brief Prints a summary of all blocks in the sequence set.
      *
@@ -116,6 +408,56 @@ public:
      */
     const std::vector<Block> getBlocks() const;
 
+    /**
+     * @brief Provides const access to a single block without copying.
+     *
+     * @param rbn RBN of the block (0 <= rbn < GetTotalBlocks())
+     * @return Reference to the block
+     */
+    const Block& GetBlock(int rbn) const { return *blocks[rbn]; }
+
+    /**
+     * @brief Captures the current leaves without copying them.
+     *
+     * Later changes copy a page before modifying it, so the returned pages
+     * never change. Must not run concurrently with changes to this set.
+     *
+     * @return Blocks in logical (chain) order
+     */
+    std::vector<std::shared_ptr<const Block>> Snapshot() const;
+
+    /**
+     * @brief Returns the RBN of the first leaf in logical (key) order.
+     *
+     * The chain ends are kept up to date as blocks are linked and freed, so
+     * this does not scan the blocks.
+     *
+     * @return Head RBN, or -1 if the sequence set is empty
+     */
+    int GetHeadRBN() const { return chainHead; }
+
+    /**
+     * @brief Returns the RBN of the last leaf in logical (key) order.
+     *
+     * @return Tail RBN, or -1 if the sequence set is empty
+     */
+    int GetTailRBN() const { return chainTail; }
+
+    /**
+     * @brief Rewrites the sequence set with all records sorted by key.
+     *
+     * Blocks are packed full in key order, so physical order equals logical
+     * order afterwards (RBN 0 holds the smallest keys) and no block is free.
+     */
+    void SortByKey();
+
+    /**
+     * @brief Removes every block (snapshots keep the pages they hold).
+     *
+     * The next write rewrites the whole file.
+     */
+    void Clear();
+
     /**
      * @brief Collects all records from all blocks into a single vector.
      *
@@ -135,7 +477,8 @@ public:
      * @brief Dumps all blocks in logical order following RBN links.
      *
      * Traverses blocks via prevRBN/nextRBN chain to show logical sequence,
-     * useful for verifying doubly-linked block connectivity.
+     * useful for verifying doubly-linked block connectivity. The blocks of
+     * the avail list follow, marked "*available*".
      */
     void dumpLogicOrder();
 
@@ -152,6 +495,18 @@ public:
      */
     bool Search(const std::string& key, std::string& outRecord);
 
+    /**
+     * @brief Searches for a record by integer primary key.
+     *
+     * Same as Search(const std::string&, std::string&) but skips key parsing;
+     * each block is probed with a binary search of its slot directory.
+     *
+     * @param key Primary key to search for (ZIP code)
+     * @param outRecord Reference to string where matching record is stored
+     * @return true if record found; false if not found
+     */
+    bool Search(uint32_t key, std::string& outRecord) const;
+
     /**
      * @brief Inserts a record into the sequence set (with block management).
      *
@@ -162,10 +517,35 @@ public:
      */
     void Insert(const std::string& record);
 
+    /**
+     * @brief Inserts a record into a specific block, splitting it if full.
+     *
+     * When the block has no room, its upper half moves to a new block linked
+     * directly after it, and the record goes to whichever half covers its key.
+     *
+     * @param rbn RBN of the block that covers the record's key
+     * @param record String record to insert
+     * @return RBN of the block that received the record
+     */
+    int InsertIntoBlock(int rbn, const std::string& record);
+
+    /**
+     * @brief Deletes a record from a specific block.
+     *
+     * An emptied block stays in the chain; the caller may free it with
+     * FreeBlock() once no reader can be following the chain.
+     *
+     * @param rbn RBN of the block that covers the key
+     * @param key Primary key of the record to delete
+     * @return true if record found and deleted; false if not found
+     */
+    bool DeleteFromBlock(int rbn, uint32_t key);
+
     /**
      * @brief Deletes a record from the sequence set by primary key.
      *
-     * Searches all blocks for the key and removes the record if found.
+     * Searches all blocks for the key and removes the record if found. A
+     * block left empty is freed (see FreeBlock()).
      *
      * @param key Primary key of record to delete
      * @return true if record found and deleted; false if not found
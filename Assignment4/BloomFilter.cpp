@@ -0,0 +1,157 @@
+/**
+ * @file BloomFilter.cpp
+ * @brief Implementation of the cache-line blocked Bloom filter.
+ */
+
+#include "BloomFilter.h"
+#include "Prefetch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static const char BLOOM_MAGIC[4] = {'B', 'L', 'M', '1'};
+
+/// 64-bit finalizer (splitmix64) so that adjacent ZIPs land in unrelated blocks.
+static uint64_t mixKey(uint32_t key)
+{
+    uint64_t h = key + 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+BloomFilter::BloomFilter() : blockCount(0), hashCount(0) {}
+
+/**
+ * @brief Sizes the filter and picks the number of probes.
+ *
+ * The optimal probe count for b bits per key is b * ln 2; it is capped at 8
+ * because every probe falls in the same cache line anyway.
+ *
+ * @param expectedKeys Number of keys that will be added
+ * @param bitsPerKey Filter bits per key
+ */
+BloomFilter::BloomFilter(size_t expectedKeys, int bitsPerKey)
+{
+    if (bitsPerKey < 1) bitsPerKey = 1;
+    size_t bits = max<size_t>(expectedKeys, 1) * bitsPerKey;
+    blockCount = static_cast<uint32_t>((bits + 511) / 512);
+    hashCount = static_cast<uint32_t>(lround(bitsPerKey * 0.69));
+    if (hashCount < 1) hashCount = 1;
+    if (hashCount > 8) hashCount = 8;
+    words = vector<atomic<uint64_t>>(static_cast<size_t>(blockCount) * WORDS_PER_BLOCK);
+}
+
+/**
+ * @brief Sets @c hashCount bits inside the key's 512-bit block.
+ *
+ * The high half of the hash selects the block; the low half drives double
+ * hashing (h1 + i * h2) over the 512 bit positions of that block.
+ */
+void BloomFilter::add(uint32_t key)
+{
+    if (blockCount == 0) return;
+    uint64_t h = mixKey(key);
+    atomic<uint64_t>* block = &words[((h >> 32) * blockCount >> 32) * WORDS_PER_BLOCK];
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = (h1 >> 16) | 1;
+    for (uint32_t i = 0; i < hashCount; ++i) {
+        uint32_t bit = (h1 + i * h2) & 511;
+        block[bit >> 6].fetch_or(1ULL << (bit & 63), memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Checks the same bits add() would set.
+ */
+bool BloomFilter::mayContain(uint32_t key) const
+{
+    if (blockCount == 0) return true;
+    uint64_t h = mixKey(key);
+    const atomic<uint64_t>* block = &words[((h >> 32) * blockCount >> 32) * WORDS_PER_BLOCK];
+    uint32_t h1 = static_cast<uint32_t>(h);
+    uint32_t h2 = (h1 >> 16) | 1;
+    for (uint32_t i = 0; i < hashCount; ++i) {
+        uint32_t bit = (h1 + i * h2) & 511;
+        if ((block[bit >> 6].load(memory_order_relaxed) & (1ULL << (bit & 63))) == 0) return false;
+    }
+    return true;
+}
+
+void BloomFilter::prefetch(uint32_t key) const
+{
+    if (blockCount == 0) return;
+    uint64_t h = mixKey(key);
+    PrefetchLine(&words[((h >> 32) * blockCount >> 32) * WORDS_PER_BLOCK]);
+}
+
+/**
+ * @brief Writes magic, geometry and bit words in binary form.
+ */
+bool BloomFilter::writeToFile(const std::string& filterFilename) const
+{
+    ofstream out(filterFilename, ios::binary | ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: cannot create filter file " << filterFilename << '\n';
+        return false;
+    }
+    out.write(BLOOM_MAGIC, sizeof(BLOOM_MAGIC));
+    out.write(reinterpret_cast<const char*>(&blockCount), sizeof(blockCount));
+    out.write(reinterpret_cast<const char*>(&hashCount), sizeof(hashCount));
+    vector<uint64_t> bits(words.size());
+    for (size_t i = 0; i < words.size(); ++i) bits[i] = words[i].load(memory_order_relaxed);
+    out.write(reinterpret_cast<const char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    return out.good();
+}
+
+/**
+ * @brief Reads a filter file; on failure the filter is left empty.
+ *
+ * The geometry is checked against the file's length before any words are
+ * allocated, so a damaged or foreign file cannot request a huge filter.
+ */
+bool BloomFilter::readFromFile(const std::string& filterFilename)
+{
+    blockCount = hashCount = 0;
+    words.clear();
+
+    ifstream in(filterFilename, ios::binary | ios::ate);
+    if (!in.is_open()) {
+        cerr << "Error: cannot open filter file " << filterFilename << '\n';
+        return false;
+    }
+    streamoff fileSize = in.tellg();
+    in.seekg(0);
+
+    char magic[4];
+    uint32_t blocks = 0, hashes = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&blocks), sizeof(blocks));
+    in.read(reinterpret_cast<char*>(&hashes), sizeof(hashes));
+    if (!in.good() || memcmp(magic, BLOOM_MAGIC, sizeof(magic)) != 0) {
+        cerr << "Error: " << filterFilename << " is not a filter file\n";
+        return false;
+    }
+
+    // The constructor never makes an empty filter or more than 8 probes, and
+    // the words must fill the rest of the file exactly
+    streamoff headerSize = sizeof(magic) + sizeof(blocks) + sizeof(hashes);
+    streamoff blockBytes = WORDS_PER_BLOCK * static_cast<streamoff>(sizeof(uint64_t));
+    if (blocks == 0 || hashes < 1 || hashes > 8 || fileSize - headerSize != blocks * blockBytes) {
+        cerr << "Error: filter file " << filterFilename << " has a bad block count\n";
+        return false;
+    }
+
+    vector<uint64_t> bits(static_cast<size_t>(blocks) * WORDS_PER_BLOCK);
+    in.read(reinterpret_cast<char*>(bits.data()), bits.size() * sizeof(uint64_t));
+    if (!in.good()) return false;
+    words = vector<atomic<uint64_t>>(bits.size());
+    for (size_t i = 0; i < bits.size(); ++i) words[i].store(bits[i], memory_order_relaxed);
+    blockCount = blocks;
+    hashCount = hashes;
+    return true;
+}
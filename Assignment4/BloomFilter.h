@@ -0,0 +1,113 @@
+/**
+ * @file BloomFilter.h
+ * @brief Declares the BloomFilter class, a cache-line blocked Bloom filter
+ *        used to reject absent ZIP codes before any index or block I/O.
+ *
+ * A lookup for a key that is not in the file (a typo'd -Z flag, for example)
+ * normally costs a full probe of the index and at least one block read just to
+ * print "not found". The filter answers "definitely absent" for most of those
+ * keys from memory:
+ *   - **mayContain() == false**: the key is certainly not stored
+ *   - **mayContain() == true**: the key is probably stored (about 1% false
+ *     positives at the default 10 bits per key)
+ *
+ * All probe bits for a key live in one 64-byte block, so a query touches a
+ * single cache line.
+ *
+ * The bit words are atomics, so add() may run while other threads call
+ * mayContain(); a key added concurrently may or may not be reported yet.
+ *
+ * Filter file format (binary):
+ * @code
+ * "BLM1" | uint32 blockCount | uint32 hashCount | blockCount * 8 uint64 words
+ * @endcode
+ */
+
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class BloomFilter
+ * @brief Blocked Bloom filter over 32-bit ZIP keys.
+ *
+ * Example usage:
+ * @code
+ * BloomFilter filter(40000);
+ * filter.add(56301);
+ * filter.mayContain(56301);  // true
+ * filter.mayContain(99999);  // almost certainly false
+ * @endcode
+ */
+class BloomFilter {
+private:
+    static const int WORDS_PER_BLOCK = 8;   ///< 8 * 64 bits = one 64-byte cache line
+
+    uint32_t blockCount;          ///< Number of 512-bit blocks (0 = empty filter)
+    uint32_t hashCount;           ///< Bits set per key
+    std::vector<std::atomic<uint64_t>> words;  ///< blockCount * WORDS_PER_BLOCK bit words
+
+public:
+    /**
+     * @brief Constructs an empty filter that reports every key as possibly present.
+     */
+    BloomFilter();
+
+    /**
+     * @brief Constructs a filter sized for @p expectedKeys keys.
+     *
+     * @param expectedKeys Number of keys that will be added
+     * @param bitsPerKey Filter bits per key (10 gives about 1% false positives)
+     */
+    BloomFilter(size_t expectedKeys, int bitsPerKey = 10);
+
+    /**
+     * @brief Adds a key to the filter.
+     * @param key ZIP code to record
+     */
+    void add(uint32_t key);
+
+    /**
+     * @brief Tests whether a key may be present.
+     *
+     * @param key ZIP code to test
+     * @return false if the key was never added; true if it may have been.
+     *         An empty (unsized) filter always returns true.
+     */
+    bool mayContain(uint32_t key) const;
+
+    /**
+     * @brief Starts loading the cache line mayContain(@p key) will test.
+     *
+     * @param key ZIP code that will be tested
+     */
+    void prefetch(uint32_t key) const;
+
+    /**
+     * @brief Returns true if the filter has been sized and can reject keys.
+     */
+    bool IsBuilt() const { return blockCount > 0; }
+
+    /**
+     * @brief Writes the filter to a binary file.
+     *
+     * @param filterFilename Path of the file to create
+     * @return true on success; false on I/O error
+     */
+    bool writeToFile(const std::string& filterFilename) const;
+
+    /**
+     * @brief Loads a filter previously written by writeToFile().
+     *
+     * @param filterFilename Path of the filter file
+     * @return true on success; false on I/O error, bad magic number or a
+     *         block count that does not match the file's length
+     */
+    bool readFromFile(const std::string& filterFilename);
+};
+
+#endif // BLOOMFILTER_H
@@ -0,0 +1,66 @@
+/**
+ * @file ColumnBatch.cpp
+ * @brief Implementation of the ColumnBatch columnar record layout.
+ */
+
+#include "ColumnBatch.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+uint16_t ColumnBatch::StateId(const std::string& state)
+{
+    if (state.size() != 2) return NO_STATE;
+    return static_cast<uint16_t>(static_cast<unsigned char>(state[0]) << 8 |
+                                 static_cast<unsigned char>(state[1]));
+}
+
+void ColumnBatch::Reserve(size_t rows)
+{
+    zips.reserve(rows);
+    states.reserve(rows);
+    latitudes.reserve(rows);
+    longitudes.reserve(rows);
+}
+
+/**
+ * @brief Walks the commas once; the coordinates are parsed in place.
+ */
+void ColumnBatch::Append(const std::string& record)
+{
+    const char* bytes = record.c_str();
+    const char* stop = bytes + record.size();
+    const char* fields[6] = {bytes, nullptr, nullptr, nullptr, nullptr, nullptr};
+    for (int i = 1; i < 6; ++i) {
+        const char* comma = static_cast<const char*>(memchr(fields[i - 1], ',', stop - fields[i - 1]));
+        if (comma == nullptr) break;
+        fields[i] = comma + 1;
+    }
+
+    zips.push_back(static_cast<uint32_t>(strtoul(bytes, nullptr, 10)));
+
+    uint16_t state = NO_STATE;
+    const char* stateEnd = fields[3] != nullptr ? fields[3] - 1 : stop;
+    if (fields[2] != nullptr && stateEnd - fields[2] == 2) {
+        state = static_cast<uint16_t>(static_cast<unsigned char>(fields[2][0]) << 8 |
+                                      static_cast<unsigned char>(fields[2][1]));
+    }
+    states.push_back(state);
+
+    float latitude = NAN, longitude = NAN;
+    if (fields[4] != nullptr) {
+        char* after = nullptr;
+        double value = strtod(fields[4], &after);
+        if (after != fields[4] && *after == ',') {
+            latitude = static_cast<float>(value);
+            const char* next = after + 1;
+            value = strtod(next, &after);
+            if (after != next) longitude = static_cast<float>(value);
+            else latitude = NAN;
+        }
+    }
+    latitudes.push_back(latitude);
+    longitudes.push_back(longitude);
+}
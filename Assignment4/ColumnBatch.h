@@ -0,0 +1,133 @@
+/**
+ * @file ColumnBatch.h
+ * @brief Declares ColumnBatch, the columnar form of a page's records, and
+ *        ColumnCache, which keeps a page's batch between scans.
+ *
+ * Predicates on the record text have to find and compare fields one record
+ * at a time. A ColumnBatch holds the same records as arrays instead: ZIP
+ * codes, state ids (the two letters of the state code packed into 16 bits),
+ * and latitudes and longitudes as floats. ColumnFilter (see ColumnFilter.h)
+ * then evaluates a predicate over a whole array at once into a selection
+ * bitmap.
+ *
+ * Each Block builds its batch the first time a scan asks for it and keeps
+ * it until its records change, so repeated scans of the same pages skip
+ * the parsing.
+ */
+
+#ifndef COLUMNBATCH_H
+#define COLUMNBATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @class ColumnBatch
+ * @brief Records of one page, one array per field.
+ *
+ * Row i of every array describes the record in slot i of the page. A
+ * missing or unreadable coordinate is stored as NaN, which no range
+ * comparison selects.
+ *
+ * Example usage:
+ * @code
+ * ColumnBatch batch;
+ * batch.Append("55401,Minneapolis,MN,Hennepin,44.98,-93.27");
+ * uint16_t mn = ColumnBatch::StateId("MN");
+ * @endcode
+ */
+class ColumnBatch {
+public:
+    /**
+     * @brief State id of a state code that is not two characters long.
+     */
+    static const uint16_t NO_STATE = 0;
+
+private:
+    std::vector<uint32_t> zips;    ///< ZIP code of each row
+    std::vector<uint16_t> states;  ///< State id of each row
+    std::vector<float> latitudes;  ///< Latitude of each row
+    std::vector<float> longitudes; ///< Longitude of each row
+
+public:
+    /**
+     * @brief Returns the id of a state code: its two bytes, first byte high.
+     *
+     * @return The id, or NO_STATE if @p state is not two characters long
+     */
+    static uint16_t StateId(const std::string& state);
+
+    /**
+     * @brief Adds one record (zip,place_name,state,county,latitude,longitude).
+     */
+    void Append(const std::string& record);
+
+    /**
+     * @brief Sizes the columns for @p rows rows (each column is then one allocation).
+     */
+    void Reserve(size_t rows);
+
+    /**
+     * @brief Returns the number of rows.
+     */
+    size_t Size() const { return zips.size(); }
+
+    /**
+     * @brief Returns the ZIP code column.
+     */
+    const uint32_t* Zips() const { return zips.data(); }
+
+    /**
+     * @brief Returns the state id column.
+     */
+    const uint16_t* States() const { return states.data(); }
+
+    /**
+     * @brief Returns the latitude column.
+     */
+    const float* Latitudes() const { return latitudes.data(); }
+
+    /**
+     * @brief Returns the longitude column.
+     */
+    const float* Longitudes() const { return longitudes.data(); }
+};
+
+/**
+ * @class ColumnCache
+ * @brief Holder for a page's ColumnBatch that scans may fill concurrently.
+ *
+ * The batch pointer is read and replaced atomically: scans of a snapshot
+ * share its pages, and two of them may build the same page's batch at once
+ * (both build the same columns; the later one is kept). Copying a page does
+ * not copy its batch, because the copy is made in order to be changed.
+ */
+class ColumnCache {
+private:
+    mutable std::shared_ptr<const ColumnBatch> batch;  ///< Built batch (null = none)
+
+public:
+    ColumnCache() {}
+    ColumnCache(const ColumnCache&) {}
+    ColumnCache& operator=(const ColumnCache&) { Reset(); return *this; }
+
+    /**
+     * @brief Returns the batch, or null if none has been built.
+     */
+    std::shared_ptr<const ColumnBatch> Get() const { return std::atomic_load(&batch); }
+
+    /**
+     * @brief Keeps @p built as the batch.
+     */
+    void Set(std::shared_ptr<const ColumnBatch> built) const { std::atomic_store(&batch, std::move(built)); }
+
+    /**
+     * @brief Drops the batch after the records changed.
+     */
+    void Reset() const { std::atomic_store(&batch, std::shared_ptr<const ColumnBatch>()); }
+};
+
+#endif // COLUMNBATCH_H
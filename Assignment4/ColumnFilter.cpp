@@ -0,0 +1,219 @@
+/**
+ * @file ColumnFilter.cpp
+ * @brief Implementation of the ColumnFilter kernels and their dispatch.
+ *
+ * The SIMD versions handle whole 64-row words only; the rows of a final
+ * partial word always go through the portable code.
+ */
+
+#include "ColumnFilter.h"
+#include <bitset>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLUMNFILTER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum KernelLevel {
+    KERNEL_PORTABLE,
+    KERNEL_SSE2,
+    KERNEL_AVX2
+};
+
+KernelLevel DetectLevel()
+{
+#ifdef COLUMNFILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2")) return KERNEL_SSE2;
+#endif
+    return KERNEL_PORTABLE;
+}
+
+/// Kernels in use; detected at the first call, changed by SetInstructionSet()
+KernelLevel& Level()
+{
+    static KernelLevel level = DetectLevel();
+    return level;
+}
+
+uint64_t EqualRows(const uint16_t* values, size_t rows, uint16_t target)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < rows; ++i) mask |= static_cast<uint64_t>(values[i] == target) << i;
+    return mask;
+}
+
+uint64_t BetweenRows(const float* values, size_t rows, float low, float high)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        mask |= static_cast<uint64_t>(values[i] >= low && values[i] <= high) << i;
+    }
+    return mask;
+}
+
+void EqualPortable(const uint16_t* values, size_t words, uint16_t target, uint64_t* bits)
+{
+    for (size_t w = 0; w < words; ++w) bits[w] = EqualRows(values + w * 64, 64, target);
+}
+
+void BetweenPortable(const float* values, size_t words, float low, float high, uint64_t* bits, bool intersect)
+{
+    for (size_t w = 0; w < words; ++w) {
+        uint64_t mask = BetweenRows(values + w * 64, 64, low, high);
+        bits[w] = intersect ? bits[w] & mask : mask;
+    }
+}
+
+#ifdef COLUMNFILTER_X86
+
+__attribute__((target("sse2")))
+void EqualSse2(const uint16_t* values, size_t words, uint16_t target, uint64_t* bits)
+{
+    const __m128i wanted = _mm_set1_epi16(static_cast<short>(target));
+    for (size_t w = 0; w < words; ++w) {
+        const uint16_t* row = values + w * 64;
+        uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 16) {
+            __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)), wanted);
+            __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i + 8)), wanted);
+            // Narrow the 16-bit lanes to bytes so that one movemask covers 16 rows
+            uint32_t found = static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(a, b)));
+            mask |= static_cast<uint64_t>(found) << i;
+        }
+        bits[w] = mask;
+    }
+}
+
+__attribute__((target("sse2")))
+void BetweenSse2(const float* values, size_t words, float low, float high, uint64_t* bits, bool intersect)
+{
+    const __m128 lo = _mm_set1_ps(low);
+    const __m128 hi = _mm_set1_ps(high);
+    for (size_t w = 0; w < words; ++w) {
+        const float* row = values + w * 64;
+        uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 4) {
+            __m128 x = _mm_loadu_ps(row + i);
+            __m128 inside = _mm_and_ps(_mm_cmpge_ps(x, lo), _mm_cmple_ps(x, hi));
+            mask |= static_cast<uint64_t>(_mm_movemask_ps(inside)) << i;
+        }
+        bits[w] = intersect ? bits[w] & mask : mask;
+    }
+}
+
+__attribute__((target("avx2")))
+void EqualAvx2(const uint16_t* values, size_t words, uint16_t target, uint64_t* bits)
+{
+    const __m256i wanted = _mm256_set1_epi16(static_cast<short>(target));
+    for (size_t w = 0; w < words; ++w) {
+        const uint16_t* row = values + w * 64;
+        uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 32) {
+            __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i)), wanted);
+            __m256i b = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i + 16)), wanted);
+            // packs works per 128-bit lane; the permute puts the rows back in order
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+            uint32_t found = static_cast<uint32_t>(_mm256_movemask_epi8(packed));
+            mask |= static_cast<uint64_t>(found) << i;
+        }
+        bits[w] = mask;
+    }
+}
+
+__attribute__((target("avx2")))
+void BetweenAvx2(const float* values, size_t words, float low, float high, uint64_t* bits, bool intersect)
+{
+    const __m256 lo = _mm256_set1_ps(low);
+    const __m256 hi = _mm256_set1_ps(high);
+    for (size_t w = 0; w < words; ++w) {
+        const float* row = values + w * 64;
+        uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 8) {
+            __m256 x = _mm256_loadu_ps(row + i);
+            // Ordered comparisons: NaN is outside every range
+            __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x, lo, _CMP_GE_OQ), _mm256_cmp_ps(x, hi, _CMP_LE_OQ));
+            mask |= static_cast<uint64_t>(_mm256_movemask_ps(inside)) << i;
+        }
+        bits[w] = intersect ? bits[w] & mask : mask;
+    }
+}
+
+#endif // COLUMNFILTER_X86
+
+void Between(const float* values, size_t count, float low, float high, uint64_t* bits, bool intersect)
+{
+    size_t words = count / 64;
+    switch (Level()) {
+#ifdef COLUMNFILTER_X86
+    case KERNEL_AVX2: BetweenAvx2(values, words, low, high, bits, intersect); break;
+    case KERNEL_SSE2: BetweenSse2(values, words, low, high, bits, intersect); break;
+#endif
+    default: BetweenPortable(values, words, low, high, bits, intersect); break;
+    }
+    if (count % 64 != 0) {
+        uint64_t mask = BetweenRows(values + words * 64, count % 64, low, high);
+        bits[words] = intersect ? bits[words] & mask : mask;
+    }
+}
+
+} // namespace
+
+void ColumnFilter::SelectEqual(const uint16_t* values, size_t count, uint16_t target, uint64_t* bits)
+{
+    size_t words = count / 64;
+    switch (Level()) {
+#ifdef COLUMNFILTER_X86
+    case KERNEL_AVX2: EqualAvx2(values, words, target, bits); break;
+    case KERNEL_SSE2: EqualSse2(values, words, target, bits); break;
+#endif
+    default: EqualPortable(values, words, target, bits); break;
+    }
+    if (count % 64 != 0) bits[words] = EqualRows(values + words * 64, count % 64, target);
+}
+
+void ColumnFilter::SelectBetween(const float* values, size_t count, float low, float high, uint64_t* bits)
+{
+    Between(values, count, low, high, bits, false);
+}
+
+void ColumnFilter::AndBetween(const float* values, size_t count, float low, float high, uint64_t* bits)
+{
+    Between(values, count, low, high, bits, true);
+}
+
+size_t ColumnFilter::CountSelected(const uint64_t* bits, size_t words)
+{
+    size_t total = 0;
+    for (size_t w = 0; w < words; ++w) total += std::bitset<64>(bits[w]).count();
+    return total;
+}
+
+bool ColumnFilter::SetInstructionSet(const char* name)
+{
+    KernelLevel wanted;
+    if (std::strcmp(name, "avx2") == 0)
+        wanted = KERNEL_AVX2;
+    else if (std::strcmp(name, "sse2") == 0)
+        wanted = KERNEL_SSE2;
+    else if (std::strcmp(name, "portable") == 0)
+        wanted = KERNEL_PORTABLE;
+    else
+        return false;
+    if (wanted > DetectLevel()) return false;
+    Level() = wanted;
+    return true;
+}
+
+const char* ColumnFilter::InstructionSet()
+{
+    switch (Level()) {
+    case KERNEL_AVX2: return "avx2";
+    case KERNEL_SSE2: return "sse2";
+    default: return "portable";
+    }
+}
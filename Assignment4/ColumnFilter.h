@@ -0,0 +1,92 @@
+/**
+ * @file ColumnFilter.h
+ * @brief Declares ColumnFilter, the batch predicate kernels that turn a
+ *        column into a selection bitmap.
+ *
+ * A selection bitmap has one bit per row: bit (i % 64) of word (i / 64) is
+ * set when row i is selected. Bits past the last row are always clear, so
+ * bitmaps can be combined and counted word by word.
+ *
+ * Each kernel has an AVX2 version (32 state ids or 8 floats per
+ * instruction), an SSE2 version and a portable one. The best version the
+ * processor supports is chosen once, at the first call; builds for other
+ * processors get the portable version only.
+ */
+
+#ifndef COLUMNFILTER_H
+#define COLUMNFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class ColumnFilter
+ * @brief Vectorized comparisons over columns (see ColumnBatch.h).
+ *
+ * Example usage:
+ * @code
+ * std::vector<uint64_t> bits(ColumnFilter::WordsFor(batch.Size()));
+ * ColumnFilter::SelectEqual(batch.States(), batch.Size(), ColumnBatch::StateId("MN"), bits.data());
+ * size_t matches = ColumnFilter::CountSelected(bits.data(), bits.size());
+ * @endcode
+ */
+class ColumnFilter {
+public:
+    /**
+     * @brief Returns the number of bitmap words for @p rows rows.
+     */
+    static size_t WordsFor(size_t rows) { return (rows + 63) / 64; }
+
+    /**
+     * @brief Selects the rows whose value equals @p target.
+     *
+     * @param values Column of @p count values
+     * @param count Number of rows
+     * @param target Value to select
+     * @param bits Receives the bitmap (WordsFor(count) words, overwritten)
+     */
+    static void SelectEqual(const uint16_t* values, size_t count, uint16_t target, uint64_t* bits);
+
+    /**
+     * @brief Selects the rows whose value lies in [@p low, @p high].
+     *
+     * NaN values are never selected.
+     *
+     * @param values Column of @p count values
+     * @param count Number of rows
+     * @param low Lowest value selected
+     * @param high Highest value selected
+     * @param bits Receives the bitmap (WordsFor(count) words, overwritten)
+     */
+    static void SelectBetween(const float* values, size_t count, float low, float high, uint64_t* bits);
+
+    /**
+     * @brief Clears the bits of the rows whose value is not in [@p low, @p high].
+     *
+     * Same as SelectBetween() followed by a word-wise AND into @p bits.
+     */
+    static void AndBetween(const float* values, size_t count, float low, float high, uint64_t* bits);
+
+    /**
+     * @brief Returns the number of selected rows.
+     */
+    static size_t CountSelected(const uint64_t* bits, size_t words);
+
+    /**
+     * @brief Returns the kernels in use: "avx2", "sse2" or "portable".
+     */
+    static const char* InstructionSet();
+
+    /**
+     * @brief Switches to the kernels named @p name ("avx2", "sse2" or
+     *        "portable"), so that they can be compared with each other.
+     *
+     * Not thread-safe: call it while no other thread uses ColumnFilter.
+     *
+     * @return false if the name is unknown or the processor (or build)
+     *         lacks that instruction set; the kernels in use are unchanged
+     */
+    static bool SetInstructionSet(const char* name);
+};
+
+#endif // COLUMNFILTER_H
@@ -0,0 +1,122 @@
+/**
+ * @file Crc32c.cpp
+ * @brief Implementation of Crc32c() and its dispatch.
+ *
+ * The x86 version is picked at run time, like the ColumnFilter kernels; the
+ * ARM version when the compiler targets a CPU with the CRC extension.
+ */
+
+#include "Crc32c.h"
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CRC32C_X86 1
+#include <nmmintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define CRC32C_X86 1
+#include <intrin.h>
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#define CRC32C_ARM 1
+#include <arm_acle.h>
+#endif
+
+namespace {
+
+const uint32_t POLY = 0x82F63B78u;  // Castagnoli polynomial, reflected
+
+/// Table for the portable version: one byte at a time
+struct Table {
+    uint32_t entries[256];
+    Table()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (POLY & (0u - (crc & 1u)));
+            entries[i] = crc;
+        }
+    }
+};
+
+uint32_t Portable(const unsigned char* p, size_t length, uint32_t crc)
+{
+    static const Table table;
+    while (length--) crc = table.entries[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC32C_X86
+bool DetectSse42()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+bool HasSse42()
+{
+    static const bool has = DetectSse42();
+    return has;
+}
+
+#if defined(__GNUC__)
+__attribute__((target("sse4.2")))
+#endif
+uint32_t Sse42(const unsigned char* p, size_t length, uint32_t crc)
+{
+    uint64_t wide = crc;
+    for (; length >= 8; p += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = static_cast<uint32_t>(wide);
+    for (; length > 0; ++p, --length) crc = _mm_crc32_u8(crc, *p);
+    return crc;
+}
+#endif
+
+#ifdef CRC32C_ARM
+uint32_t Armv8(const unsigned char* p, size_t length, uint32_t crc)
+{
+    for (; length >= 8; p += 8, length -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; length > 0; ++p, --length) crc = __crc32cb(crc, *p);
+    return crc;
+}
+#endif
+
+} // namespace
+
+uint32_t Crc32c(const void* data, size_t length, uint32_t crc)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+#if defined(CRC32C_X86)
+    crc = HasSse42() ? Sse42(p, length, crc) : Portable(p, length, crc);
+#elif defined(CRC32C_ARM)
+    crc = Armv8(p, length, crc);
+#else
+    crc = Portable(p, length, crc);
+#endif
+    return ~crc;
+}
+
+const char* Crc32cImplementation()
+{
+#if defined(CRC32C_X86)
+    return HasSse42() ? "sse4.2" : "portable";
+#elif defined(CRC32C_ARM)
+    return "armv8";
+#else
+    return "portable";
+#endif
+}
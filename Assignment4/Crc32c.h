@@ -0,0 +1,35 @@
+/**
+ * @file Crc32c.h
+ * @brief Declares Crc32c(), the page checksum (CRC-32C, Castagnoli).
+ *
+ * Every page of a block file ends in its CRC-32C (see Block::SealPage()),
+ * checked whenever the page is read. The CPU's CRC instruction is used where
+ * there is one (SSE4.2 on x86, the CRC extension on ARMv8), so checking a
+ * page costs well under a microsecond; elsewhere a table-driven version is
+ * used that gives the same results.
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Computes the CRC-32C of a byte range.
+ *
+ * @param data First byte
+ * @param length Number of bytes
+ * @param crc CRC of the bytes before @p data, to continue a running CRC (0 to start)
+ * @return CRC-32C of everything so far
+ */
+uint32_t Crc32c(const void* data, size_t length, uint32_t crc = 0);
+
+/**
+ * @brief Names the implementation Crc32c() uses on this machine.
+ *
+ * @return "sse4.2", "armv8" or "portable"
+ */
+const char* Crc32cImplementation();
+
+#endif // CRC32C_H
@@ -0,0 +1,71 @@
+/**
+ * @file FreeSpaceMap.cpp
+ * @brief Implementation of the per-page free-space max-tree.
+ */
+
+#include "FreeSpaceMap.h"
+#include <algorithm>
+
+using namespace std;
+
+FreeSpaceMap::FreeSpaceMap(int pageSize_) : pageSize(max(pageSize_, 1)), leaves(1), pages(0), tree(2, 0) {}
+
+void FreeSpaceMap::Reset(int pageSize_)
+{
+    pageSize = max(pageSize_, 1);
+    leaves = 1;
+    pages = 0;
+    tree.assign(2, 0);
+}
+
+/**
+ * @brief Copies the leaves into a tree twice as wide and recomputes the maxima.
+ */
+void FreeSpaceMap::Grow(size_t rbn)
+{
+    size_t wider = leaves;
+    while (wider <= rbn) wider *= 2;
+
+    vector<uint8_t> grown(2 * wider, 0);
+    copy(tree.begin() + leaves, tree.begin() + leaves + pages, grown.begin() + wider);
+    for (size_t node = wider - 1; node >= 1; --node) {
+        grown[node] = max(grown[2 * node], grown[2 * node + 1]);
+    }
+    tree.swap(grown);
+    leaves = wider;
+}
+
+void FreeSpaceMap::Update(int rbn, int freeBytes)
+{
+    if (rbn < 0) return;
+    size_t slot = static_cast<size_t>(rbn);
+    if (slot >= leaves) Grow(slot);
+    pages = max(pages, slot + 1);
+
+    // Round down so a page never promises more than it has
+    long long units = static_cast<long long>(max(freeBytes, 0)) * 255 / pageSize;
+    size_t node = leaves + slot;
+    tree[node] = static_cast<uint8_t>(min(units, 255LL));
+    for (node /= 2; node >= 1; node /= 2) {
+        uint8_t top = max(tree[2 * node], tree[2 * node + 1]);
+        if (tree[node] == top) break;  // maxima above are unchanged too
+        tree[node] = top;
+    }
+}
+
+/**
+ * @brief Descends from the root, taking the left child whenever it has
+ *        enough room.
+ */
+int FreeSpaceMap::Find(int bytesNeeded) const
+{
+    // Round up so the page found is certain to have the room
+    long long units = (static_cast<long long>(max(bytesNeeded, 1)) * 255 + pageSize - 1) / pageSize;
+    if (units > 255 || tree[1] < units) return -1;
+
+    size_t node = 1;
+    while (node < leaves) {
+        node = (tree[2 * node] >= units) ? 2 * node : 2 * node + 1;
+    }
+    return static_cast<int>(node - leaves);
+}
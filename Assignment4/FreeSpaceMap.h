@@ -0,0 +1,88 @@
+/**
+ * @file FreeSpaceMap.h
+ * @brief Declares the FreeSpaceMap class, a compact in-memory map of how much
+ *        room is left in every page of a BlockedSequenceSet.
+ *
+ * Finding a page with room for a record by asking every Block means touching
+ * every block. The map keeps one byte per page instead: the page's free bytes
+ * in units of 1/255 of the page size, rounded down. The bytes are the leaves
+ * of a binary tree whose inner nodes hold the largest value below them, so
+ * Find() walks one root-to-leaf path and Update() one leaf-to-root path.
+ *
+ * Because values are rounded down, a page returned by Find() has at least
+ * the bytes asked for; a page with a little more room than a whole unit may
+ * be passed over. The map is rebuilt from the blocks when a file is read and
+ * is not stored in it.
+ */
+
+#ifndef FREESPACEMAP_H
+#define FREESPACEMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class FreeSpaceMap
+ * @brief Max-tree over one-byte free-space categories, one per page.
+ *
+ * Example usage:
+ * @code
+ * FreeSpaceMap map(512);
+ * map.Update(0, 40);
+ * map.Update(1, 300);
+ * map.Find(100);  // 1
+ * map.Find(400);  // -1
+ * @endcode
+ */
+class FreeSpaceMap {
+private:
+    int pageSize;               ///< Bytes per page; 255 units make one page
+    size_t leaves;              ///< Leaf slots in the tree (a power of two, >= pages)
+    size_t pages;               ///< Pages recorded (one past the highest RBN updated)
+    std::vector<uint8_t> tree;  ///< Implicit tree: node i has children 2i and 2i+1, leaves from `leaves`
+
+    /**
+     * @brief Doubles the leaf slots until page @p rbn has one.
+     */
+    void Grow(size_t rbn);
+
+public:
+    /**
+     * @brief Constructs an empty map.
+     *
+     * @param pageSize_ Bytes per page
+     */
+    explicit FreeSpaceMap(int pageSize_ = 512);
+
+    /**
+     * @brief Forgets every page and sets the page size.
+     *
+     * @param pageSize_ Bytes per page
+     */
+    void Reset(int pageSize_);
+
+    /**
+     * @brief Records the free bytes of a page.
+     *
+     * @param rbn RBN of the page (the map grows to hold it)
+     * @param freeBytes Bytes still free in the page (0 for a page that must
+     *                  not receive records)
+     */
+    void Update(int rbn, int freeBytes);
+
+    /**
+     * @brief Finds the lowest-numbered page with at least @p bytesNeeded free.
+     *
+     * @param bytesNeeded Bytes the record needs
+     * @return RBN of such a page, or -1 if none is known to have the room
+     */
+    int Find(int bytesNeeded) const;
+
+    /**
+     * @brief Returns the number of pages recorded.
+     */
+    size_t GetPageCount() const { return pages; }
+};
+
+#endif // FREESPACEMAP_H
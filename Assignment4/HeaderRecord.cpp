@@ -6,14 +6,41 @@
  * The HeaderRecord stores essential information such as:
  *   - Block size (in bytes)
  *   - Number of records in the file
+ *   - Page codec
+ *   - Checkpoint LSN of the write-ahead log
+ *   - Whether pages end in a checksum line
+ *   - Index root and height, leaf chain ends and avail list head
  *
- * Gives methods for reading, writing, and printing
- * the header in a simple comma-separated text format.
+ * Gives methods for reading, writing, and printing the header as a binary
+ * superblock, and for reading the comma-separated text header of older files.
  */
 #include "HeaderRecord.h"
+#include "Block.h"
+#include "Crc32c.h"
+#include <charconv>
+#include <climits>
+#include <cstring>
 #include <iostream>
 #include <fstream>
-#include <limits>
+
+static const char SUPERBLOCK_MAGIC[4] = {'B', 'S', 'S', '1'};
+static const size_t SUPERBLOCK_CRC_AT = HeaderRecord::SUPERBLOCK_SIZE - sizeof(uint32_t);
+
+/// Stores a trivially copyable value at byte @p pos of the superblock.
+template <typename T>
+static void putAt(char* block, size_t pos, T value)
+{
+    memcpy(block + pos, &value, sizeof(value));
+}
+
+/// Loads a trivially copyable value from byte @p pos of the superblock.
+template <typename T>
+static T getAt(const char* block, size_t pos)
+{
+    T value;
+    memcpy(&value, block + pos, sizeof(value));
+    return value;
+}
 
 /**
  * @brief Default constructor.
@@ -22,7 +49,9 @@
  *   - blockSizeBytes = 512 (default block size commonly used in block storage)
  *   - recordCount = 0 (empty file)
  */
-HeaderRecord::HeaderRecord() : blockSizeBytes(512), recordCount(0) {}
+HeaderRecord::HeaderRecord()
+    : blockSizeBytes(512), recordCount(0), codec(CODEC_NONE), checkpointLSN(0), pageChecksums(false),
+      version(SUPERBLOCK_VERSION), rootRBN(-1), treeHeight(0), headRBN(-1), tailRBN(-1), availHead(-1) {}
 
 /**
  * @brief Constructs a HeaderRecord with a user-defined block size.
@@ -32,59 +61,154 @@ HeaderRecord::HeaderRecord() : blockSizeBytes(512), recordCount(0) {}
  * The number of records is set to zero initially and will typically be
  * updated later once the file is populated.
  */
-HeaderRecord::HeaderRecord(int blockSize) : blockSizeBytes(blockSize), recordCount(0) {}
+HeaderRecord::HeaderRecord(int blockSize)
+    : blockSizeBytes(blockSize), recordCount(0), codec(CODEC_NONE), checkpointLSN(0), pageChecksums(false),
+      version(SUPERBLOCK_VERSION), rootRBN(-1), treeHeight(0), headRBN(-1), tailRBN(-1), availHead(-1) {}
 
 /**
  * @brief Writes the header metadata to an output file stream.
  *
- * The header is written in a comma-separated format:
+ * The header is written as the SUPERBLOCK_SIZE-byte binary superblock laid
+ * out in HeaderRecord.h, ending in the CRC-32C of the bytes before it. It
+ * is always written with the current SUPERBLOCK_VERSION.
  *
- * @code
- * 512,1000
- * @endcode
+ * @param out Reference to an open output stream where the header is written.
+ * @return true if the write operation succeeds, false if the stream is in a failed state.
+ */
+bool HeaderRecord::Write(std::ostream &out) const {
+    if (!out.good()) return false;
+    char block[SUPERBLOCK_SIZE] = {0};
+    memcpy(block, SUPERBLOCK_MAGIC, sizeof(SUPERBLOCK_MAGIC));
+    putAt<uint32_t>(block, 4, SUPERBLOCK_VERSION);
+    putAt<uint32_t>(block, 8, static_cast<uint32_t>(blockSizeBytes));
+    putAt<uint32_t>(block, 12, static_cast<uint32_t>(recordCount));
+    putAt<int32_t>(block, 16, rootRBN);
+    putAt<int32_t>(block, 20, treeHeight);
+    putAt<int32_t>(block, 24, headRBN);
+    putAt<int32_t>(block, 28, tailRBN);
+    putAt<int32_t>(block, 32, availHead);
+    putAt<uint16_t>(block, 36, static_cast<uint16_t>(codec));
+    putAt<uint16_t>(block, 38, pageChecksums ? FLAG_PAGE_CHECKSUMS : 0);
+    putAt<uint64_t>(block, 40, checkpointLSN);
+    putAt<uint32_t>(block, SUPERBLOCK_CRC_AT, Crc32c(block, SUPERBLOCK_CRC_AT));
+    out.write(block, SUPERBLOCK_SIZE);
+    return out.good();
+}
+
+/**
+ * @brief Reads a header record from an input file stream.
  *
- * Where:
- *   - 512 = block size in bytes
- *   - 1000 = number of records in the file
+ * A file starting with the superblock magic is read as a superblock; any
+ * other file is read as a legacy text header (see ReadText()).
  *
- * @param out Reference to an open std::ofstream where the header is written.
- * @return true if the write operation succeeds, false if the stream is not open.
+ * @param in Reference to an open std::ifstream positioned at the header.
+ * @return true if a well-formed header was read (and its checksum
+ *         matched), false otherwise.
  */
-bool HeaderRecord::Write(std::ofstream &out) const {
-    if (!out.is_open()) return false;
-    out << blockSizeBytes << "," << recordCount << "\n";
-    return true;
+bool HeaderRecord::Read(std::ifstream &in) {
+    if (!in.is_open()) return false;
+
+    char block[SUPERBLOCK_SIZE];
+    std::streampos start = in.tellg();
+    if (!in.read(block, sizeof(SUPERBLOCK_MAGIC))) return false;
+    if (memcmp(block, SUPERBLOCK_MAGIC, sizeof(SUPERBLOCK_MAGIC)) != 0) {
+        in.seekg(start);
+        return ReadText(in);
+    }
+
+    if (!in.read(block + sizeof(SUPERBLOCK_MAGIC), SUPERBLOCK_SIZE - sizeof(SUPERBLOCK_MAGIC))) return false;
+    if (getAt<uint32_t>(block, SUPERBLOCK_CRC_AT) != Crc32c(block, SUPERBLOCK_CRC_AT)) return false;
+
+    uint32_t fileVersion = getAt<uint32_t>(block, 4);
+    uint32_t blockBytes = getAt<uint32_t>(block, 8);
+    uint32_t records = getAt<uint32_t>(block, 12);
+    uint16_t fileCodec = getAt<uint16_t>(block, 36);
+    uint16_t flags = getAt<uint16_t>(block, 38);
+    if (fileVersion == 0 || fileVersion > SUPERBLOCK_VERSION) return false;  // written by newer code
+    if (blockBytes < SUPERBLOCK_SIZE || blockBytes > INT_MAX || records > INT_MAX) return false;
+    if (fileCodec != CODEC_NONE && fileCodec != CODEC_LZ) return false;
+    if ((flags & ~FLAG_PAGE_CHECKSUMS) != 0) return false;
+
+    version = fileVersion;
+    blockSizeBytes = static_cast<int>(blockBytes);
+    recordCount = static_cast<int>(records);
+    rootRBN = getAt<int32_t>(block, 16);
+    treeHeight = getAt<int32_t>(block, 20);
+    headRBN = getAt<int32_t>(block, 24);
+    tailRBN = getAt<int32_t>(block, 28);
+    availHead = getAt<int32_t>(block, 32);
+    codec = static_cast<PageCodecType>(fileCodec);
+    pageChecksums = (flags & FLAG_PAGE_CHECKSUMS) != 0;
+    checkpointLSN = getAt<uint64_t>(block, 40);
+
+    // Leave the stream at the first block
+    in.seekg(start + static_cast<std::streamoff>(blockSizeBytes));
+    return in.good();
 }
 
 /**
- * @brief Reads a header record from an input file stream.
+ * @brief Reads the text header line of a file written before the superblock.
  *
  * Expects input of the form:
  *
  * @code
- * 512,1000
+ * 512,1000,0,0,1
  * @endcode
  *
- * Reads the values safely, skipping any commas and
- * advancing to the next line after reading both numbers.
+ * The line holds two to five comma-separated unsigned numbers and nothing
+ * else. The codec, checkpoint LSN and checksum fields are optional; older
+ * headers read as plain text pages with LSN 0 and no checksums. The tree
+ * fields are not stored and read as unknown.
  *
  * @param in Reference to an open std::ifstream positioned at the header line.
- * @return true if read is successful, false if the stream is not open.
+ * @return true if a well-formed header was read (and its page checksum
+ *         matched), false otherwise.
  */
-bool HeaderRecord::Read(std::ifstream &in) {
-    if (!in.is_open()) return false;
-
-    // Read blockSizeBytes
-    in >> blockSizeBytes;
+bool HeaderRecord::ReadText(std::ifstream &in) {
+    std::string line;
+    if (!std::getline(in, line)) return false;
 
-    // Skip comma if present
-    if (in.peek() == ',') in.ignore();
+    // Parse the numeric fields; anything unexpected fails the header
+    uint64_t fields[5];
+    int count = 0;
+    const char* pos = line.data();
+    const char* end = line.data() + line.size();
+    while (true) {
+        auto parsed = std::from_chars(pos, end, fields[count]);
+        if (parsed.ec != std::errc()) return false;
+        ++count;
+        pos = parsed.ptr;
+        if (pos == end || *pos != ',' || count == 5) break;
+        ++pos;
+    }
+    while (pos != end && (*pos == ' ' || *pos == '\r')) ++pos;
+    if (pos != end || count < 2) return false;
 
-    // Read recordCount
-    in >> recordCount;
+    if (fields[0] == 0 || fields[0] > INT_MAX || fields[1] > INT_MAX) return false;
+    if (count > 2 && fields[2] != CODEC_NONE && fields[2] != CODEC_LZ) return false;
+    if (count > 4 && fields[4] > 1) return false;
+    blockSizeBytes = static_cast<int>(fields[0]);
+    recordCount = static_cast<int>(fields[1]);
+    codec = (count > 2 && fields[2] == CODEC_LZ) ? CODEC_LZ : CODEC_NONE;
+    checkpointLSN = count > 3 ? fields[3] : 0;
+    pageChecksums = count > 4 && fields[4] == 1;
+    version = 0;
+    rootRBN = -1;
+    treeHeight = 0;
+    headRBN = -1;
+    tailRBN = -1;
+    availHead = -1;
 
-    // Discard remaining characters on this line to clean stream state
-    in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    // A checksummed header page is verified as a whole
+    if (pageChecksums) {
+        size_t lineBytes = line.size() + 1;
+        if (lineBytes + Block::PAGE_TRAILER > static_cast<size_t>(blockSizeBytes)) return false;
+        std::string page = line;
+        page += '\n';
+        page.resize(static_cast<size_t>(blockSizeBytes));
+        if (!in.read(&page[lineBytes], blockSizeBytes - lineBytes)) return false;
+        if (!Block::VerifyPage(page)) return false;
+    }
     return true;
 }
 
@@ -95,9 +219,14 @@ bool HeaderRecord::Read(std::ifstream &in) {
  *
  * Output example:
  * @code
- * Header Record -> Block Size: 512, Record Count: 1000
+ * Header Record -> Version: 1, Block Size: 512, Record Count: 1000, Codec: none, Checksums: on,
+ *                  Root RBN: 310, Height: 2, Head RBN: 0, Tail RBN: 299, Avail: -1
  * @endcode
  */
 void HeaderRecord::Print() const {
-    std::cout << "Header Record -> Block Size: " << blockSizeBytes << ", Record Count: " << recordCount << "\n";
+    std::cout << "Header Record -> Version: " << version << ", Block Size: " << blockSizeBytes
+              << ", Record Count: " << recordCount << ", Codec: " << PageCodec::Name(codec)
+              << ", Checksums: " << (pageChecksums ? "on" : "off") << ",\n"
+              << "                 Root RBN: " << rootRBN << ", Height: " << treeHeight
+              << ", Head RBN: " << headRBN << ", Tail RBN: " << tailRBN << ", Avail: " << availHead << "\n";
 }
\ No newline at end of file
@@ -7,6 +7,40 @@
  * essential metadata such as:
  *   - Block size used by the file's block storage system
  *   - Total number of data records in the file
+ *   - Page codec (0 = plain text pages, 1 = LZ-compressed pages)
+ *   - Checkpoint LSN (last write-ahead log record reflected in the file)
+ *   - Whether every page ends in a CRC-32C checksum line (see Block::SealPage())
+ *   - Root RBN and height of the index, head and tail of the leaf chain and
+ *     the head of the list of free pages
+ *
+ * It is stored as a fixed-size binary superblock at the start of page 0:
+ *
+ * @code
+ * offset  size  field
+ *      0     4  magic "BSS1"
+ *      4     4  version (SUPERBLOCK_VERSION)
+ *      8     4  block size
+ *     12     4  record count
+ *     16     4  root RBN (-1 = no tree built; a leaf when the height is 1)
+ *     20     4  tree height, counting the leaf level
+ *     24     4  head RBN of the leaf chain
+ *     28     4  tail RBN of the leaf chain
+ *     32     4  head RBN of the avail list (-1 = none)
+ *     36     2  page codec
+ *     38     2  flags (FLAG_PAGE_CHECKSUMS)
+ *     40     8  checkpoint LSN
+ *     48    12  reserved (zero)
+ *     60     4  CRC-32C of bytes 0-59
+ * @endcode
+ *
+ * Integers are in host byte order, like the page file's journal. The
+ * superblock is far smaller than a disk sector, and it is only ever written
+ * through PageFile's journal or a whole-file rename, so a reader sees either
+ * the old or the new superblock; the CRC catches anything else.
+ *
+ * Files written before the superblock start with a text line
+ * ("blockSize,recordCount[,codec[,checkpointLSN[,checksums]]]"); Read() still
+ * accepts it and reports version 0 with the tree fields unknown (-1).
  */
 #ifndef HEADERRECORD_H
 #define HEADERRECORD_H
@@ -14,6 +48,9 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include "PageCodec.h"
 
 /**
  * @class HeaderRecord
@@ -51,6 +88,36 @@ private:
      */
     int recordCount;
 
+    /**
+     * @brief Compression used for the file's pages.
+     *
+     * Files written before the codec existed have no third header field and
+     * read back as CODEC_NONE.
+     */
+    PageCodecType codec;
+
+    /**
+     * @brief LSN of the last write-ahead log record applied to the file.
+     *
+     * Recovery replays only log records with a higher LSN. Absent (0) in
+     * files written without a log.
+     */
+    uint64_t checkpointLSN;
+
+    /**
+     * @brief True if every page of the file, the header page included, ends
+     *        in a checksum line.
+     *
+     * Absent (false) in files written before pages were checksummed; their
+     * pages are read without verification.
+     */
+    bool pageChecksums;
+
+    /**
+     * @brief Format version: SUPERBLOCK_VERSION, or 0 for a text header line.
+     */
+    uint32_t version;
+
     /**
      * @brief Additional metadata for indexed files
      *
@@ -63,13 +130,27 @@ private:
      */
     int treeHeight; // Height of the index tree (for indexed files)
 
+    int headRBN;   ///< First leaf of the chain (-1 if empty or unknown)
+    int tailRBN;   ///< Last leaf of the chain (-1 if empty or unknown)
+    int availHead; ///< First free page (-1 if none)
+
+    /**
+     * @brief Parses the legacy text header line.
+     */
+    bool ReadText(std::ifstream &in);
+
 public:
+    static constexpr size_t SUPERBLOCK_SIZE = 64;        ///< Bytes of the binary superblock
+    static constexpr uint32_t SUPERBLOCK_VERSION = 1;    ///< Version written by Write()
+    static constexpr uint16_t FLAG_PAGE_CHECKSUMS = 1;   ///< Pages end in checksum lines
+
     /**
      * @brief Default constructor.
      *
      * Initializes:
      *   - `blockSizeBytes = 512` (default block size)
      *   - `recordCount = 0` (empty file)
+     *   - no index, an empty leaf chain and no free pages (RBNs -1)
      *
      * These defaults may be overridden later using setters.
      */
@@ -107,26 +188,118 @@ public:
     void SetRecordCount(int count) { recordCount = count; }
 
     /**
-     * @brief Writes the header record to an output file stream.
+     * @brief Retrieves the page codec of the file.
      *
-     * This function writes the metadata in a structured format,
-     * typically as comma-separated or length-indicated text.
+     * @return CODEC_NONE or CODEC_LZ.
+     */
+    PageCodecType GetCodec() const { return codec; }
+
+    /**
+     * @brief Sets the page codec recorded in the header.
      *
-     * Format example:
-     * @code
-     * HEADER,512,1200
-     * @endcode
+     * @param c Codec used when the file's pages are written.
+     */
+    void SetCodec(PageCodecType c) { codec = c; }
+
+    /**
+     * @brief Retrieves the checkpoint LSN recorded in the header.
+     *
+     * @return LSN of the last log record reflected in the file (0 if none).
+     */
+    uint64_t GetCheckpointLSN() const { return checkpointLSN; }
+
+    /**
+     * @brief Sets the checkpoint LSN recorded in the header.
+     *
+     * @param lsn LSN of the last log record reflected in the file.
+     */
+    void SetCheckpointLSN(uint64_t lsn) { checkpointLSN = lsn; }
+
+    /**
+     * @brief Returns true if the file's pages end in checksum lines.
+     */
+    bool HasPageChecksums() const { return pageChecksums; }
+
+    /**
+     * @brief Records whether the file's pages end in checksum lines.
+     *
+     * @param on True when every page is written with Block::SealPage()
+     */
+    void SetPageChecksums(bool on) { pageChecksums = on; }
+
+    /**
+     * @brief Returns the format version read (0 for a legacy text header).
+     */
+    uint32_t GetVersion() const { return version; }
+
+    /**
+     * @brief Returns the RBN of the root page (-1 if no tree was built or unknown).
+     */
+    int GetRootRBN() const { return rootRBN; }
+
+    /**
+     * @brief Returns the tree height counting the leaf level (0 if none or unknown).
+     */
+    int GetTreeHeight() const { return treeHeight; }
+
+    /**
+     * @brief Records the root page and the height of the tree.
+     *
+     * @param rbn RBN of the root page, or -1 for a file without a tree
+     * @param height Levels from the root down to the leaves, inclusive
+     */
+    void SetRoot(int rbn, int height) { rootRBN = rbn; treeHeight = height; }
+
+    /**
+     * @brief Returns the RBN of the first leaf of the chain (-1 if empty or unknown).
+     */
+    int GetHeadRBN() const { return headRBN; }
+
+    /**
+     * @brief Returns the RBN of the last leaf of the chain (-1 if empty or unknown).
+     */
+    int GetTailRBN() const { return tailRBN; }
+
+    /**
+     * @brief Records both ends of the leaf chain.
+     *
+     * @param head RBN of the first leaf (-1 if empty)
+     * @param tail RBN of the last leaf (-1 if empty)
+     */
+    void SetLeafChain(int head, int tail) { headRBN = head; tailRBN = tail; }
+
+    /**
+     * @brief Returns the RBN of the first free page (-1 if none).
+     */
+    int GetAvailHead() const { return availHead; }
+
+    /**
+     * @brief Records the first page of the list of free pages.
+     *
+     * @param rbn RBN of the first free page, or -1 if none
+     */
+    void SetAvailHead(int rbn) { availHead = rbn; }
+
+    /**
+     * @brief Writes the header record to an output file stream.
+     *
+     * Writes the SUPERBLOCK_SIZE bytes of the binary superblock (see the
+     * file comment); the caller pads them to a full page.
      *
-     * @param out Reference to an open std::ofstream.
-     * @return `true` if write succeeds, `false` if stream is not open.
+     * @param out Reference to an open output stream (file or string stream).
+     * @return `true` if write succeeds, `false` if the stream is in a failed state.
      */
-    bool Write(std::ofstream &out) const;
+    bool Write(std::ostream &out) const;
 
     /**
      * @brief Reads the header record from an input file stream.
      *
-     * This function expects a valid header line to be present at the
-     * beginning of the file and loads internal metadata accordingly.
+     * Reads a superblock, which must carry the magic number, a version this
+     * code knows, sane field values and a matching CRC, or else a legacy text
+     * header line. Every field of a text line must be a well-formed number
+     * in range; a damaged line is rejected rather than read as far as it
+     * parses. In both cases the stream is left at the first block when the
+     * header page is checksummed or binary.
      *
      * @param in Reference to an open std::ifstream positioned at header.
      * @return `true` if read succeeds, `false` on failure.
@@ -140,8 +313,8 @@ public:
      *
      * Example output:
      * @code
-     * Block Size: 512 bytes
-     * Record Count: 1200
+     * Header Record -> Version: 1, Block Size: 512, Record Count: 1200, Codec: none,
+     *                  Checksums: on, Root RBN: 310, Height: 2, Head RBN: 0, Tail RBN: 299, Avail: -1
      * @endcode
      */
     void Print() const;
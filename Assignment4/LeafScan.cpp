@@ -0,0 +1,257 @@
+/**
+ * @file LeafScan.cpp
+ * @brief Implementation of ScanPredicate and the parallel LeafScan.
+ */
+
+#include "LeafScan.h"
+#include "ColumnFilter.h"
+#include "Prefetch.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+using namespace std;
+
+/// Field positions in a stored record
+static const int STATE_FIELD = 2;
+static const int COUNTY_FIELD = 3;
+static const int LATITUDE_FIELD = 4;
+
+/**
+ * @brief Finds where field @p field (0-based) of @p record starts and ends.
+ *
+ * @return false if the record has fewer fields
+ */
+static bool findField(const std::string& record, int field, size_t& start, size_t& end)
+{
+    const char* bytes = record.data();
+    const char* stop = bytes + record.size();
+    const char* at = bytes;
+    for (int i = 0; i < field; ++i) {
+        at = static_cast<const char*>(memchr(at, ',', stop - at));
+        if (at == nullptr) return false;
+        ++at;
+    }
+    const char* comma = static_cast<const char*>(memchr(at, ',', stop - at));
+    start = at - bytes;
+    end = (comma == nullptr ? stop : comma) - bytes;
+    return true;
+}
+
+/**
+ * @brief Returns the index of the lowest set bit of @p word (not 0).
+ */
+static unsigned ctz64(uint64_t word)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+    unsigned index = 0;
+    while ((word & 1) == 0) {
+        word >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+/**
+ * @brief Reads the number at @p at; false if there is none.
+ */
+static bool readNumber(const char* at, double& value, const char*& next)
+{
+    char* after = nullptr;
+    value = strtod(at, &after);
+    next = after;
+    return after != at;
+}
+
+ScanPredicate::ScanPredicate()
+    : kind(MATCH_ALL), minLat(0), maxLat(0), minLon(0), maxLon(0) {}
+
+ScanPredicate::ScanPredicate(Kind kind_, std::string value_)
+    : kind(kind_), value(std::move(value_)), minLat(0), maxLat(0), minLon(0), maxLon(0) {}
+
+ScanPredicate ScanPredicate::State(const std::string& state)
+{
+    return ScanPredicate(STATE, state);
+}
+
+ScanPredicate ScanPredicate::County(const std::string& county)
+{
+    return ScanPredicate(COUNTY, county);
+}
+
+ScanPredicate ScanPredicate::Box(double minLatitude, double maxLatitude,
+                                 double minLongitude, double maxLongitude)
+{
+    ScanPredicate box(BOX, std::string());
+    box.minLat = minLatitude;
+    box.maxLat = maxLatitude;
+    box.minLon = minLongitude;
+    box.maxLon = maxLongitude;
+    return box;
+}
+
+/**
+ * @brief Compares the needed field in place; a box parses just the two
+ *        coordinates.
+ */
+bool ScanPredicate::Matches(const std::string& record) const
+{
+    size_t start = 0, end = 0;
+    switch (kind) {
+    case MATCH_ALL:
+        return true;
+    case STATE:
+    case COUNTY:
+        return findField(record, kind == STATE ? STATE_FIELD : COUNTY_FIELD, start, end) &&
+               record.compare(start, end - start, value) == 0;
+    case BOX: {
+        if (!findField(record, LATITUDE_FIELD, start, end)) return false;
+        double latitude = 0, longitude = 0;
+        const char* next = nullptr;
+        if (!readNumber(record.c_str() + start, latitude, next) || *next != ',') return false;
+        if (!readNumber(next + 1, longitude, next)) return false;
+        return latitude >= minLat && latitude <= maxLat &&
+               longitude >= minLon && longitude <= maxLon;
+    }
+    }
+    return false;
+}
+
+bool ScanPredicate::IsColumnar() const
+{
+    return kind == BOX || (kind == STATE && ColumnBatch::StateId(value) != ColumnBatch::NO_STATE);
+}
+
+/**
+ * @brief Widens the double box to float bounds that contain it.
+ */
+bool ScanPredicate::Select(const ColumnBatch& columns, std::vector<uint64_t>& bits) const
+{
+    const size_t rows = columns.Size();
+    if (kind == STATE) {
+        uint16_t id = ColumnBatch::StateId(value);
+        if (id == ColumnBatch::NO_STATE) return false;
+        bits.resize(ColumnFilter::WordsFor(rows));
+        ColumnFilter::SelectEqual(columns.States(), rows, id, bits.data());
+        return true;
+    }
+    if (kind != BOX) return false;
+
+    auto below = [](double bound) {
+        float f = static_cast<float>(bound);
+        return f > bound ? nextafterf(f, -INFINITY) : f;
+    };
+    auto above = [](double bound) {
+        float f = static_cast<float>(bound);
+        return f < bound ? nextafterf(f, INFINITY) : f;
+    };
+    bits.resize(ColumnFilter::WordsFor(rows));
+    ColumnFilter::SelectBetween(columns.Latitudes(), rows, below(minLat), above(maxLat), bits.data());
+    ColumnFilter::AndBetween(columns.Longitudes(), rows, below(minLon), above(maxLon), bits.data());
+    return true;
+}
+
+LeafScan::LeafScan(const TreeSnapshot& snapshot, const ScanPredicate& condition, ScanOrder resultOrder)
+    : view(snapshot), predicate(condition), order(resultOrder) {}
+
+/**
+ * @brief Walks the set bits of the page's selection bitmap, or tests every
+ *        record when the predicate has no columnar form.
+ */
+template <typename F>
+void LeafScan::ForEachMatch(size_t index, std::vector<uint64_t>& bits, F&& match) const
+{
+    const auto& leaves = view.GetLeaves();
+    if (index + 1 < leaves.size()) PrefetchLine(leaves[index + 1].get());  // next page while this one is tested
+    const Block& leaf = *leaves[index];
+    const auto& records = leaf.getRecords();
+    if (records.empty()) return;
+    if (!predicate.IsColumnar() || !predicate.Select(*leaf.GetColumns(), bits)) {
+        for (const auto& record : records) {
+            if (predicate.Matches(record)) match(record);
+        }
+        return;
+    }
+    for (size_t w = 0; w < bits.size(); ++w) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            const std::string& record = records[w * 64 + ctz64(word)];
+            if (!predicate.NeedsRecheck() || predicate.Matches(record)) match(record);
+        }
+    }
+}
+
+void LeafScan::ScanLeaves(size_t first, size_t last, std::vector<std::string>& outRecords) const
+{
+    vector<uint64_t> bits;
+    for (size_t i = first; i < last; ++i) {
+        ForEachMatch(i, bits, [&](const std::string& record) { outRecords.push_back(record); });
+    }
+}
+
+/**
+ * @brief Splits the chain into a few runs per thread so that runs with many
+ *        matches do not leave the other threads idle.
+ */
+void LeafScan::Run(std::vector<std::string>& outRecords) const
+{
+    ThreadPool& pool = ThreadPool::Shared();
+    const size_t leafCount = view.GetLeaves().size();
+    const size_t runs = min<size_t>(leafCount, (pool.GetThreadCount() + 1) * 4);
+    if (runs == 0) return;
+
+    if (order == SCAN_ANY_ORDER) {
+        mutex outLock;
+        pool.ParallelFor(0, runs, 1, [&](size_t lo, size_t hi) {
+            for (size_t run = lo; run < hi; ++run) {
+                vector<string> found;
+                ScanLeaves(leafCount * run / runs, leafCount * (run + 1) / runs, found);
+                lock_guard<mutex> guard(outLock);
+                outRecords.insert(outRecords.end(), make_move_iterator(found.begin()),
+                                  make_move_iterator(found.end()));
+            }
+        });
+        return;
+    }
+
+    vector<vector<string>> found(runs);
+    pool.ParallelFor(0, runs, 1, [&](size_t lo, size_t hi) {
+        for (size_t run = lo; run < hi; ++run) {
+            ScanLeaves(leafCount * run / runs, leafCount * (run + 1) / runs, found[run]);
+        }
+    });
+
+    size_t first = outRecords.size();
+    for (auto& part : found) {
+        outRecords.insert(outRecords.end(), make_move_iterator(part.begin()), make_move_iterator(part.end()));
+    }
+    // Before BuildStaticIndex() the chain need not be in key order
+    if (!view.IsKeyOrdered()) {
+        stable_sort(outRecords.begin() + first, outRecords.end(), [](const string& a, const string& b) {
+            return strtoul(a.c_str(), nullptr, 10) < strtoul(b.c_str(), nullptr, 10);
+        });
+    }
+}
+
+size_t LeafScan::Count() const
+{
+    const size_t leafCount = view.GetLeaves().size();
+    const size_t runs = min<size_t>(leafCount, (ThreadPool::Shared().GetThreadCount() + 1) * 4);
+    vector<size_t> counts(runs, 0);
+    ThreadPool::Shared().ParallelFor(0, runs, 1, [&](size_t lo, size_t hi) {
+        for (size_t run = lo; run < hi; ++run) {
+            vector<uint64_t> bits;
+            for (size_t i = leafCount * run / runs; i < leafCount * (run + 1) / runs; ++i) {
+                ForEachMatch(i, bits, [&](const std::string&) { ++counts[run]; });
+            }
+        }
+    });
+    size_t total = 0;
+    for (size_t count : counts) total += count;
+    return total;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file LeafScan.h
+ * @brief Declares ScanPredicate and LeafScan, the parallel full scan over the
+ *        leaf pages of a TreeSnapshot.
+ *
+ * The leaf chain is cut into runs of consecutive leaves, and the runs are
+ * scanned on the shared ThreadPool. State and box predicates are evaluated
+ * a page at a time over the page's columns (see ColumnBatch.h and
+ * ColumnFilter.h) into a selection bitmap; other predicates are tested on
+ * the bytes of each stored record, finding the commas of the fields they
+ * need instead of splitting the record into strings. Only matching records
+ * are copied.
+ *
+ * With SCAN_KEY_ORDER the runs' results are joined in chain order, which is
+ * key order; with SCAN_ANY_ORDER each run hands its results over as soon as
+ * it finishes, which saves holding every run's results until the slowest
+ * one is done.
+ */
+
+#ifndef LEAFSCAN_H
+#define LEAFSCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TreeSnapshot.h"
+#include "ColumnBatch.h"
+
+/**
+ * @enum ScanOrder
+ * @brief Order in which LeafScan returns the matching records.
+ */
+enum ScanOrder {
+    SCAN_KEY_ORDER = 0,  ///< Ascending ZIP code
+    SCAN_ANY_ORDER = 1   ///< Whatever order the workers finish in
+};
+
+/**
+ * @class ScanPredicate
+ * @brief Condition on the fields of a record
+ *        (zip,place_name,state,county,latitude,longitude).
+ *
+ * Example usage:
+ * @code
+ * ScanPredicate inMinnesota = ScanPredicate::State("MN");
+ * ScanPredicate nearDenver = ScanPredicate::Box(39.5, 40.0, -105.2, -104.6);
+ * @endcode
+ */
+class ScanPredicate {
+public:
+    /**
+     * @brief What the predicate tests.
+     */
+    enum Kind {
+        MATCH_ALL = 0,  ///< Every record
+        STATE = 1,      ///< State field equals a code
+        COUNTY = 2,     ///< County field equals a name
+        BOX = 3         ///< Latitude and longitude inside a box (bounds included)
+    };
+
+private:
+    Kind kind;          ///< What is tested
+    std::string value;  ///< State code or county name
+    double minLat;      ///< Southern edge of the box
+    double maxLat;      ///< Northern edge of the box
+    double minLon;      ///< Western edge of the box
+    double maxLon;      ///< Eastern edge of the box
+
+    ScanPredicate(Kind kind_, std::string value_);
+
+public:
+    /**
+     * @brief Matches every record.
+     */
+    ScanPredicate();
+
+    /**
+     * @brief Matches records whose state field is @p state (e.g. "FL").
+     */
+    static ScanPredicate State(const std::string& state);
+
+    /**
+     * @brief Matches records whose county field is @p county.
+     */
+    static ScanPredicate County(const std::string& county);
+
+    /**
+     * @brief Matches records located inside a latitude/longitude box.
+     *
+     * @param minLatitude Southern edge
+     * @param maxLatitude Northern edge
+     * @param minLongitude Western edge
+     * @param maxLongitude Eastern edge
+     */
+    static ScanPredicate Box(double minLatitude, double maxLatitude,
+                             double minLongitude, double maxLongitude);
+
+    /**
+     * @brief Returns what the predicate tests.
+     */
+    Kind GetKind() const { return kind; }
+
+    /**
+     * @brief Evaluates the predicate over a page's columns.
+     *
+     * State codes compare as state ids. A box compares the float columns
+     * against the box widened to the nearest floats outside it, so every
+     * match is selected; the selected rows must still pass Matches() to
+     * drop the few that are only inside through float rounding.
+     *
+     * @param columns Columnar batch of the page
+     * @param bits Receives the selection bitmap (resized to fit)
+     * @return false if the predicate has no columnar form (use Matches())
+     */
+    bool Select(const ColumnBatch& columns, std::vector<uint64_t>& bits) const;
+
+    /**
+     * @brief Returns true if Select() can evaluate this predicate.
+     */
+    bool IsColumnar() const;
+
+    /**
+     * @brief Returns true if rows selected by Select() need a Matches() check.
+     */
+    bool NeedsRecheck() const { return kind == BOX; }
+
+    /**
+     * @brief Tests one stored record.
+     *
+     * @param record Record text as stored in a leaf
+     * @return true if the record satisfies the predicate
+     */
+    bool Matches(const std::string& record) const;
+};
+
+/**
+ * @class LeafScan
+ * @brief Scans every leaf of a snapshot in parallel and collects the
+ *        records that satisfy a predicate.
+ *
+ * Example usage:
+ * @code
+ * TreeSnapshot view = tree.Snapshot();
+ * std::vector<std::string> rows;
+ * LeafScan(view, ScanPredicate::County("Hennepin"), SCAN_ANY_ORDER).Run(rows);
+ * @endcode
+ */
+class LeafScan {
+private:
+    const TreeSnapshot& view;  ///< Leaves to scan (must outlive the scan)
+    ScanPredicate predicate;   ///< Records to keep
+    ScanOrder order;           ///< Order of the results
+
+    /**
+     * @brief Appends the matches of leaves [first, last) in chain order.
+     */
+    void ScanLeaves(size_t first, size_t last, std::vector<std::string>& outRecords) const;
+
+    /**
+     * @brief Calls @p match(record) for each match in leaf @p index.
+     */
+    template <typename F>
+    void ForEachMatch(size_t index, std::vector<uint64_t>& bits, F&& match) const;
+
+public:
+    /**
+     * @brief Prepares a scan; nothing is read until Run().
+     *
+     * @param snapshot Leaves to scan
+     * @param condition Records to keep
+     * @param resultOrder Order of the results
+     */
+    LeafScan(const TreeSnapshot& snapshot, const ScanPredicate& condition,
+             ScanOrder resultOrder = SCAN_KEY_ORDER);
+
+    /**
+     * @brief Scans the leaves and appends the matching records.
+     *
+     * @param outRecords Matching records are appended here
+     */
+    void Run(std::vector<std::string>& outRecords) const;
+
+    /**
+     * @brief Counts the matching records without copying them.
+     */
+    size_t Count() const;
+};
+
+#endif // LEAFSCAN_H
@@ -0,0 +1,204 @@
+/**
+ * @file LearnedIndex.cpp
+ * @brief Implementation of the LearnedIndex piecewise linear ZIP -> block model.
+ */
+
+#include "LearnedIndex.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+
+/**
+ * @brief Constructs an empty model with the given error bound.
+ *
+ * @param eps Maximum error in blocks (values below 1 are raised to 1)
+ */
+LearnedIndex::LearnedIndex(int eps) : epsilon(max(eps, 1)), blockCount(0) {}
+
+/**
+ * @brief Trains the model using a greedy shrinking-cone segmentation.
+ *
+ * Starting at the first uncovered point (x0, y0), each following point
+ * (x, y) narrows the range of slopes for which the line through (x0, y0)
+ * stays within epsilon of every point seen so far. When the range becomes
+ * empty a new segment is started. The chosen slope is the middle of the
+ * final range, so every training point is predicted within epsilon.
+ *
+ * @param keys Keys in ascending order
+ */
+void LearnedIndex::buildIndex(const std::vector<uint32_t>& keys)
+{
+    segments.clear();
+    blockCount = static_cast<int>(keys.size());
+
+    size_t start = 0;
+    while (start < keys.size()) {
+        double lo = 0.0;
+        double hi = numeric_limits<double>::infinity();
+        size_t end = start + 1;
+
+        for (; end < keys.size(); ++end) {
+            double dx = static_cast<double>(keys[end]) - keys[start];
+            if (dx <= 0) break;  // keys must be strictly increasing within a segment
+            double dy = static_cast<double>(end - start);
+            double loHere = (dy - epsilon) / dx;
+            double hiHere = (dy + epsilon) / dx;
+            if (loHere > hi || hiHere < lo) break;
+            lo = max(lo, loHere);
+            hi = min(hi, hiHere);
+        }
+
+        Segment seg;
+        seg.firstKey = keys[start];
+        seg.intercept = static_cast<double>(start);
+        seg.slope = (end == start + 1) ? 0.0 : (lo + hi) / 2.0;
+        segments.push_back(seg);
+
+        start = end;
+    }
+}
+
+/**
+ * @brief Evaluates the segment responsible for @p key.
+ *
+ * The prediction is clamped to the block range covered by the segment, which
+ * keeps keys that fall in the gap between two segments inside the window.
+ *
+ * @param key ZIP code to locate
+ * @return Predicted position
+ */
+int LearnedIndex::predict(uint32_t key) const
+{
+    if (segments.empty()) return 0;
+
+    auto it = upper_bound(segments.begin(), segments.end(), key,
+                          [](uint32_t k, const Segment& s) { return k < s.firstKey; });
+    if (it != segments.begin()) --it;
+
+    double pos = it->intercept + it->slope * (static_cast<double>(key) - it->firstKey);
+
+    double upper = (it + 1 != segments.end()) ? (it + 1)->intercept : blockCount - 1;
+    pos = min(max(pos, it->intercept), upper);
+    return static_cast<int>(pos + 0.5);
+}
+
+/**
+ * @brief Writes the model in the text format described in LearnedIndex.h.
+ *
+ * @param indexFilename Output path
+ * @return true if the file was written
+ */
+bool LearnedIndex::writeToFile(const std::string& indexFilename) const
+{
+    ofstream out(indexFilename, ios::trunc);
+    if (!out.is_open()) {
+        cerr << "Error: cannot create index file " << indexFilename << '\n';
+        return false;
+    }
+    out << epsilon << "," << blockCount << "," << segments.size() << '\n';
+    out << setprecision(17);
+    for (const Segment& s : segments) {
+        out << s.firstKey << "," << s.slope << "," << s.intercept << '\n';
+    }
+    out.close();
+    return true;
+}
+
+/**
+ * @brief Loads a model previously written by writeToFile().
+ *
+ * @param indexFilename Input path
+ * @return true if the header and all segments were read
+ */
+bool LearnedIndex::readFromFile(const std::string& indexFilename)
+{
+    ifstream in(indexFilename);
+    if (!in.is_open()) {
+        cerr << "Error: cannot open index file " << indexFilename << '\n';
+        return false;
+    }
+
+    segments.clear();
+    char comma;
+    size_t count = 0;
+    if (!(in >> epsilon >> comma >> blockCount >> comma >> count)) return false;
+
+    string line;
+    getline(in, line);  // finish header line
+    while (segments.size() < count && getline(in, line)) {
+        if (line.empty()) continue;
+        stringstream ss(line);
+        Segment s;
+        if (!(ss >> s.firstKey >> comma >> s.slope >> comma >> s.intercept)) return false;
+        segments.push_back(s);
+    }
+    in.close();
+    return segments.size() == count;
+}
+
+/**
+ * @brief Compares the block count, then the prediction for every key.
+ *
+ * @param keys Keys in ascending order
+ * @return true if every prediction is within epsilon
+ */
+bool LearnedIndex::fits(const std::vector<uint32_t>& keys) const
+{
+    if (blockCount != static_cast<int>(keys.size()) || (segments.empty() && !keys.empty())) return false;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (abs(predict(keys[i]) - static_cast<int>(i)) > epsilon) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Locates @p key with a model-bounded binary search.
+ *
+ * @param key ZIP code to locate
+ * @param keys Keys in ascending order
+ * @return Position of the first key >= @p key, or -1 if there is none
+ */
+int LearnedIndex::findPosition(uint32_t key, const std::vector<uint32_t>& keys) const
+{
+    int n = static_cast<int>(keys.size());
+    if (n == 0) return -1;
+
+    int pos = min(predict(key), n - 1);
+    int left = max(pos - epsilon - 1, 0);
+    int right = min(pos + epsilon + 1, n - 1);
+
+    // The window is valid if it brackets the first key >= key
+    bool bracketed = (left == 0 || keys[left - 1] < key) &&
+                     (right == n - 1 || keys[right] >= key);
+    if (!bracketed) {
+        left = 0;
+        right = n - 1;
+    }
+
+    while (left < right) {
+        int mid = left + (right - left) / 2;
+        if (keys[mid] < key) left = mid + 1;
+        else right = mid;
+    }
+
+    if (keys[left] < key) return -1;
+    return left;
+}
+
+/**
+ * @brief Prints epsilon, block count and every segment.
+ */
+void LearnedIndex::dump() const
+{
+    cout << "Learned Index Dump (epsilon=" << epsilon << ", blocks=" << blockCount
+         << ", segments=" << segments.size() << ")" << endl;
+    for (const Segment& s : segments) {
+        cout << s.firstKey << ", " << s.slope << ", " << s.intercept << endl;
+    }
+}
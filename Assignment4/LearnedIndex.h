@@ -0,0 +1,150 @@
+/**
+ * @file LearnedIndex.h
+ * @brief Declares the LearnedIndex class, a piecewise linear model that maps
+ *        ZIP keys to the block that holds them.
+ *
+ * ZIP codes are dense, nearly monotone integers, so the position of a leaf in
+ * the key-ordered leaf chain is almost a linear function of its highest key.
+ * LearnedIndex approximates that function with a small number of line segments
+ * (PGM-style), each guaranteed to predict a position within @c epsilon of
+ * the true one. A lookup is:
+ *   1. a binary search over the (few) segment start keys,
+ *   2. one multiply-add to predict a position,
+ *   3. a bounded binary search over at most 2 * epsilon + 3 keys.
+ *
+ * BPlusTree::SetLearnedIndex() trains one over the separators of the tree's
+ * bottom index level and uses it in FindLeaf() in place of the descent
+ * through the index pages; it is saved as "<filename>.pgm".
+ *
+ * Index file format (text):
+ * @code
+ * epsilon,blockCount,segmentCount
+ * firstKey,slope,intercept
+ * firstKey,slope,intercept
+ * ...
+ * @endcode
+ *
+ * The model is an optional alternative to simpleIndex (Assignment 3) and
+ * PrimaryKeyIndex: it only stores the segments, so a 41k-record file with
+ * 512-byte blocks persists in a few KB.
+ */
+
+#ifndef LEARNEDINDEX_H
+#define LEARNEDINDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class LearnedIndex
+ * @brief Piecewise linear approximation of the key -> position mapping.
+ *
+ * The model is built over a sorted array of keys, one per leaf in chain order
+ * (the leaf's highest key or its separator). The array itself is the "data
+ * array" searched in the final bounded step, so the caller keeps it and
+ * passes it to findPosition().
+ *
+ * Example usage:
+ * @code
+ * std::vector<uint32_t> highest = { 501, 1420, 2871, 3905 };  // one per leaf
+ * LearnedIndex li(8);
+ * li.buildIndex(highest);
+ * li.writeToFile("zip.learned");
+ * int pos = li.findPosition(1500, highest);  // 2: the third leaf
+ * @endcode
+ */
+class LearnedIndex {
+private:
+    /**
+     * @struct Segment
+     * @brief One linear piece of the model: pos = intercept + slope * (key - firstKey).
+     */
+    struct Segment {
+        uint32_t firstKey;  ///< Smallest block key covered by this segment
+        double slope;       ///< Blocks per key unit
+        double intercept;   ///< Block position predicted for firstKey
+    };
+
+    int epsilon;                    ///< Maximum prediction error, in positions
+    int blockCount;                 ///< Number of keys (leaves) the model was trained on
+    std::vector<Segment> segments;  ///< Segments sorted by firstKey
+
+public:
+    /**
+     * @brief Constructs an empty model.
+     *
+     * @param eps Maximum error (in blocks) allowed for each segment. Smaller
+     *            values give a tighter search window but more segments.
+     */
+    LearnedIndex(int eps = 8);
+
+    /**
+     * @brief Trains the model on a sorted key array.
+     *
+     * @param keys One key per leaf, in ascending order
+     */
+    void buildIndex(const std::vector<uint32_t>& keys);
+
+    /**
+     * @brief Predicts the position of the first key that is >= @p key.
+     *
+     * For a key the model was trained on, the prediction is within
+     * @c epsilon of its position.
+     *
+     * @param key ZIP code to locate
+     * @return Predicted position, clamped to [0, blockCount - 1]
+     */
+    int predict(uint32_t key) const;
+
+    /**
+     * @brief Writes the segments to a text index file.
+     *
+     * @param indexFilename Path of the file to create
+     * @return true on success; false if the file cannot be opened
+     */
+    bool writeToFile(const std::string& indexFilename) const;
+
+    /**
+     * @brief Loads segments previously written by writeToFile().
+     *
+     * @param indexFilename Path of the index file to read
+     * @return true on success; false on I/O error or malformed header
+     */
+    bool readFromFile(const std::string& indexFilename);
+
+    /**
+     * @brief Checks that a loaded model still describes @p keys.
+     *
+     * @param keys The key array the model is to be used with
+     * @return true if the model was trained on as many keys and predicts
+     *         every one within @c epsilon of its position
+     */
+    bool fits(const std::vector<uint32_t>& keys) const;
+
+    /**
+     * @brief Finds the position of the first key that is >= @p key.
+     *
+     * Uses the model to narrow the search to a window of at most
+     * 2 * epsilon + 3 keys and binary-searches that window. Falls back to a
+     * full binary search if the window does not bracket the key (only possible
+     * when the keys changed since the model was built).
+     *
+     * @param key ZIP code to locate
+     * @param keys The key array the model was trained on
+     * @return Position in @p keys, or -1 if @p key is larger than every key
+     */
+    int findPosition(uint32_t key, const std::vector<uint32_t>& keys) const;
+
+    /**
+     * @brief Returns the number of segments in the model.
+     */
+    int GetSegmentCount() const { return static_cast<int>(segments.size()); }
+
+    /**
+     * @brief Prints the model parameters to the console.
+     */
+    void dump() const;
+};
+
+#endif // LEARNEDINDEX_H
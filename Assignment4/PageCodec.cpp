@@ -0,0 +1,134 @@
+/**
+ * @file PageCodec.cpp
+ * @brief Implementation of the PageCodec LZ77 page compressor.
+ */
+
+#include "PageCodec.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 65535;
+static const int HASH_BITS = 12;
+
+/// Hash of the 4 bytes at @p p into HASH_BITS bits.
+static uint32_t hash4(const char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/// Appends a length that overflowed its 4-bit token field.
+static void putLength(string& out, size_t extra)
+{
+    while (extra >= 255) {
+        out.push_back(static_cast<char>(255));
+        extra -= 255;
+    }
+    out.push_back(static_cast<char>(extra));
+}
+
+/// Reads the continuation bytes of a length field; false on truncated input.
+static bool getLength(const unsigned char*& p, const unsigned char* end, size_t& length)
+{
+    unsigned char b;
+    do {
+        if (p == end) return false;
+        b = *p++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+
+/// Appends one sequence: literals [lit, lit + litLen) then an optional match.
+static void putSequence(string& out, const char* lit, size_t litLen, size_t offset, size_t matchLen)
+{
+    size_t matchCode = matchLen ? matchLen - MIN_MATCH : 0;
+    unsigned char token = static_cast<unsigned char>((litLen < 15 ? litLen : 15) << 4 |
+                                                     (matchCode < 15 ? matchCode : 15));
+    out.push_back(static_cast<char>(token));
+    if (litLen >= 15) putLength(out, litLen - 15);
+    out.append(lit, litLen);
+    if (matchLen == 0) return;
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode >= 15) putLength(out, matchCode - 15);
+}
+
+/**
+ * @brief Greedy LZ77 parse with a single-entry hash table of 4-byte prefixes.
+ */
+void PageCodec::Compress(const std::string& in, std::string& out)
+{
+    out.clear();
+    out.reserve(in.size() / 2 + 16);
+
+    const char* base = in.data();
+    size_t n = in.size();
+    vector<int32_t> table(size_t(1) << HASH_BITS, -1);
+
+    size_t anchor = 0;  // first byte not yet emitted
+    size_t pos = 0;
+    while (pos + MIN_MATCH <= n) {
+        uint32_t h = hash4(base + pos);
+        int32_t candidate = table[h];
+        table[h] = static_cast<int32_t>(pos);
+
+        if (candidate < 0 || pos - candidate > MAX_OFFSET ||
+            memcmp(base + candidate, base + pos, MIN_MATCH) != 0) {
+            ++pos;
+            continue;
+        }
+
+        size_t length = MIN_MATCH;
+        while (pos + length < n && base[candidate + length] == base[pos + length]) ++length;
+
+        putSequence(out, base + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+    putSequence(out, base + anchor, n - anchor, 0, 0);
+}
+
+/**
+ * @brief Replays literals and back-references, checking every bound.
+ */
+bool PageCodec::Decompress(const char* in, size_t length, std::string& out, size_t maxOutput)
+{
+    out.clear();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    const unsigned char* end = p + length;
+
+    while (p < end) {
+        unsigned char token = *p++;
+
+        size_t litLen = token >> 4;
+        if (litLen == 15 && !getLength(p, end, litLen)) return false;
+        if (static_cast<size_t>(end - p) < litLen || out.size() + litLen > maxOutput) return false;
+        out.append(reinterpret_cast<const char*>(p), litLen);
+        p += litLen;
+        if (p == end) return true;  // last sequence: literals only
+
+        if (end - p < 2) return false;
+        size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t matchLen = token & 0x0F;
+        if (matchLen == 15 && !getLength(p, end, matchLen)) return false;
+        matchLen += MIN_MATCH;
+        if (offset == 0 || offset > out.size() || out.size() + matchLen > maxOutput) return false;
+
+        // Byte by byte: the match may overlap the bytes it produces
+        size_t from = out.size() - offset;
+        for (size_t i = 0; i < matchLen; ++i) out.push_back(out[from + i]);
+    }
+    return length == 0;
+}
+
+const char* PageCodec::Name(PageCodecType codec)
+{
+    return codec == CODEC_LZ ? "lz" : "none";
+}
@@ -0,0 +1,75 @@
+/**
+ * @file PageCodec.h
+ * @brief Declares the PageCodec class, a small built-in LZ77 codec used to
+ *        compress the record area of leaf pages.
+ *
+ * Leaf pages are mostly repeated ASCII (state codes, county names, fixed
+ * precision coordinates). When a file is created with CODEC_LZ, a page whose
+ * records no longer fit in @c blockSize bytes as text is stored compressed
+ * instead, so each fixed-size page holds more records and the file has fewer
+ * pages to read. The codec is recorded in the file's HeaderRecord.
+ *
+ * Stream format (LZ4 block style): a sequence of
+ * @code
+ * token | [literal length bytes] | literals | offset (2 bytes, LE) | [match length bytes]
+ * @endcode
+ * where the token's high nibble is the literal count and its low nibble the
+ * match length minus 4 (15 = more length bytes follow, each added until one
+ * is below 255). The last sequence carries literals only.
+ */
+
+#ifndef PAGECODEC_H
+#define PAGECODEC_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @enum PageCodecType
+ * @brief Compression applied to the pages of a file.
+ */
+enum PageCodecType
+{
+    CODEC_NONE = 0,  ///< Pages are stored as plain text
+    CODEC_LZ = 1     ///< Overfull leaf pages are stored LZ-compressed
+};
+
+/**
+ * @class PageCodec
+ * @brief Stateless LZ77 compressor and decompressor for page bodies.
+ *
+ * Example usage:
+ * @code
+ * std::string packed, text;
+ * PageCodec::Compress(body, packed);
+ * PageCodec::Decompress(packed.data(), packed.size(), text, body.size());
+ * @endcode
+ */
+class PageCodec {
+public:
+    /**
+     * @brief Compresses @p in into @p out (replacing its contents).
+     *
+     * @param in Bytes to compress
+     * @param out Receives the compressed stream
+     */
+    static void Compress(const std::string& in, std::string& out);
+
+    /**
+     * @brief Expands a stream produced by Compress().
+     *
+     * @param in Start of the compressed stream
+     * @param length Length of the compressed stream in bytes
+     * @param out Receives the original bytes (replacing its contents)
+     * @param maxOutput Upper bound on the expanded size
+     * @return true on success; false if the stream is malformed or too large
+     */
+    static bool Decompress(const char* in, size_t length, std::string& out, size_t maxOutput);
+
+    /**
+     * @brief Returns the display name of a codec ("none" or "lz").
+     */
+    static const char* Name(PageCodecType codec);
+};
+
+#endif // PAGECODEC_H
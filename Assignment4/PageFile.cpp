@@ -0,0 +1,245 @@
+/**
+ * @file PageFile.cpp
+ * @brief Implementation of the PageFile batched in-place page writer.
+ */
+
+#include "PageFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char JOURNAL_MAGIC[4] = {'D', 'W', 'B', '1'};
+static const char JOURNAL_END[4] = {'D', 'W', 'B', 'E'};
+
+#ifdef _WIN32
+static int openFile(const string& path, bool create)
+{
+    return _open(path.c_str(), _O_RDWR | _O_BINARY | (create ? _O_CREAT | _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+}
+static bool writeAt(int fd, const char* data, size_t size, long long offset)
+{
+    if (_lseeki64(fd, offset, SEEK_SET) != offset) return false;
+    while (size > 0) {
+        int n = _write(fd, data, static_cast<unsigned>(size));
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+static bool syncFd(int fd) { return _commit(fd) == 0; }
+static bool resizeFd(int fd, long long size) { return _chsize_s(fd, size) == 0; }
+static void closeFd(int fd) { _close(fd); }
+static void syncDir(const string&) {}  // _commit() on the file also commits its directory entry
+#else
+static int openFile(const string& path, bool create)
+{
+    return open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+}
+static bool writeAt(int fd, const char* data, size_t size, long long offset)
+{
+    while (size > 0) {
+        ssize_t n = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+static bool syncFd(int fd)
+{
+#ifdef __linux__
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+static bool resizeFd(int fd, long long size) { return ftruncate(fd, static_cast<off_t>(size)) == 0; }
+static void closeFd(int fd) { close(fd); }
+static void syncDir(const string& file)
+{
+    size_t slash = file.find_last_of('/');
+    string dir = (slash == string::npos) ? "." : file.substr(0, slash + 1);
+    int dfd = open(dir.c_str(), O_RDONLY);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+}
+#endif
+
+/// 64-bit FNV-1a hash of a byte range.
+static uint64_t fnv1a(const char* data, size_t size)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+/// Appends the raw bytes of a trivially copyable value.
+template <typename T>
+static void putRaw(string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/// Reads a trivially copyable value at @p pos; false if it runs past @p end.
+template <typename T>
+static bool getRaw(const string& in, size_t& pos, size_t end, T& value)
+{
+    if (end - pos < sizeof(value)) return false;
+    memcpy(&value, in.data() + pos, sizeof(value));
+    pos += sizeof(value);
+    return true;
+}
+
+PageFile::PageFile() : fd(-1) {}
+
+PageFile::~PageFile()
+{
+    Close();
+}
+
+bool PageFile::Open(const std::string& fname)
+{
+    Close();
+    path = fname;
+    if (!Recover(fname)) return false;
+    fd = openFile(fname, false);
+    return fd >= 0;
+}
+
+void PageFile::Close()
+{
+    staged.clear();
+    if (fd < 0) return;
+    closeFd(fd);
+    fd = -1;
+}
+
+void PageFile::Stage(long long offset, std::string page)
+{
+    staged.emplace_back(offset, std::move(page));
+}
+
+bool PageFile::WriteStaged()
+{
+    for (const auto& page : staged) {
+        if (!writeAt(fd, page.second.data(), page.second.size(), page.first)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Journal (if syncing), in-place writes, resize, sync, drop journal.
+ */
+bool PageFile::Commit(bool sync, long long fileSize)
+{
+    if (fd < 0) return false;
+    string journalPath = path + ".dwb";
+
+    if (sync && !staged.empty()) {
+        string journal(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        putRaw(journal, static_cast<int64_t>(fileSize));
+        putRaw(journal, static_cast<uint32_t>(staged.size()));
+        for (const auto& page : staged) {
+            putRaw(journal, static_cast<int64_t>(page.first));
+            putRaw(journal, static_cast<uint32_t>(page.second.size()));
+            journal += page.second;
+        }
+        putRaw(journal, fnv1a(journal.data(), journal.size()));
+        journal.append(JOURNAL_END, sizeof(JOURNAL_END));
+
+        int jfd = openFile(journalPath, true);
+        bool journaled = jfd >= 0 && writeAt(jfd, journal.data(), journal.size(), 0) && syncFd(jfd);
+        if (jfd >= 0) closeFd(jfd);
+        if (!journaled) {
+            cerr << "Error: cannot write journal " << journalPath << '\n';
+            remove(journalPath.c_str());
+            return false;
+        }
+        // The journal was just created: its directory entry must be durable too
+        syncDir(journalPath);
+    }
+
+    bool written = WriteStaged() && (fileSize < 0 || resizeFd(fd, fileSize)) && (!sync || syncFd(fd));
+    staged.clear();
+    if (!written) {
+        // Leave the journal so that Recover() completes the batch
+        cerr << "Error: cannot write pages of " << path << '\n';
+        return false;
+    }
+    if (sync) remove(journalPath.c_str());
+    return true;
+}
+
+/**
+ * @brief Validates the journal (magic, lengths, hash, end marker) and replays it.
+ */
+bool PageFile::Recover(const std::string& fname)
+{
+    string journalPath = fname + ".dwb";
+    string journal;
+    {
+        ifstream in(journalPath, ios::binary);
+        if (!in.is_open()) return true;  // no interrupted commit
+        journal.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    size_t trailer = sizeof(uint64_t) + sizeof(JOURNAL_END);
+    bool complete = journal.size() >= sizeof(JOURNAL_MAGIC) + sizeof(int64_t) + sizeof(uint32_t) + trailer &&
+                    memcmp(journal.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 &&
+                    memcmp(journal.data() + journal.size() - sizeof(JOURNAL_END), JOURNAL_END,
+                           sizeof(JOURNAL_END)) == 0;
+    size_t bodyEnd = complete ? journal.size() - trailer : 0;
+    uint64_t hash = 0;
+    size_t hashPos = bodyEnd;
+    complete = complete && getRaw(journal, hashPos, journal.size(), hash) &&
+               hash == fnv1a(journal.data(), bodyEnd);
+
+    if (complete) {
+        PageFile file;
+        file.path = fname;
+        file.fd = openFile(fname, false);
+        if (file.fd < 0) return false;
+
+        size_t pos = sizeof(JOURNAL_MAGIC);
+        int64_t fileSize = -1;
+        uint32_t count = 0;
+        bool parsed = getRaw(journal, pos, bodyEnd, fileSize) && getRaw(journal, pos, bodyEnd, count);
+        for (uint32_t i = 0; parsed && i < count; ++i) {
+            int64_t offset = 0;
+            uint32_t length = 0;
+            parsed = getRaw(journal, pos, bodyEnd, offset) && getRaw(journal, pos, bodyEnd, length) &&
+                     bodyEnd - pos >= length;
+            if (parsed) {
+                file.Stage(offset, journal.substr(pos, length));
+                pos += length;
+            }
+        }
+        if (!parsed || !file.WriteStaged() || (fileSize >= 0 && !resizeFd(file.fd, fileSize)) ||
+            !syncFd(file.fd)) {
+            cerr << "Error: cannot apply journal " << journalPath << '\n';
+            return false;
+        }
+    }
+    remove(journalPath.c_str());
+    return true;
+}
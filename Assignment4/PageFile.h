@@ -0,0 +1,121 @@
+/**
+ * @file PageFile.h
+ * @brief Declares the PageFile class, which rewrites individual fixed-size
+ *        pages of a block file in place.
+ *
+ * Pages changed since the last write are staged and then committed as one
+ * batch with positioned writes (pwrite), so a change to a few blocks costs a
+ * few page writes instead of a rewrite of the whole file.
+ *
+ * A durable commit first writes the whole batch to a journal file
+ * ("<file>.dwb", a doublewrite buffer) and syncs it, then writes the pages in
+ * place and syncs the file, then deletes the journal. A crash during the
+ * in-place writes leaves a complete journal, which Recover() copies over the
+ * file before it is next read, so a batch is applied entirely or not at all
+ * and no page is left torn.
+ *
+ * Journal format (binary):
+ * @code
+ * "DWB1" | int64 fileSize | uint32 pageCount | pageCount * (int64 offset | uint32 length | bytes)
+ *        | uint64 FNV-1a hash of everything before it | "DWBE"
+ * @endcode
+ */
+
+#ifndef PAGEFILE_H
+#define PAGEFILE_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PageFile
+ * @brief Batched in-place page writer with a doublewrite journal.
+ *
+ * Example usage:
+ * @code
+ * PageFile file;
+ * file.Open("zip.dat");
+ * file.Stage(0, headerPage);
+ * file.Stage((rbn + 1) * blockSize, page);
+ * file.Commit(true, (blockCount + 1) * blockSize);
+ * @endcode
+ */
+class PageFile {
+private:
+    std::string path;   ///< Path of the block file
+    int fd;             ///< Read/write descriptor (-1 = closed)
+    std::vector<std::pair<long long, std::string>> staged;  ///< (offset, page bytes) to write
+
+    /**
+     * @brief Writes every staged page at its offset.
+     */
+    bool WriteStaged();
+
+public:
+    /**
+     * @brief Constructs a closed page file.
+     */
+    PageFile();
+
+    /**
+     * @brief Closes the file; staged pages that were not committed are dropped.
+     */
+    ~PageFile();
+
+    PageFile(const PageFile&) = delete;
+    PageFile& operator=(const PageFile&) = delete;
+
+    /**
+     * @brief Opens an existing block file for in-place updates.
+     *
+     * A journal left by an interrupted commit is applied first.
+     *
+     * @param fname Path of the block file
+     * @return true if the file was opened; false if it is missing or unwritable
+     */
+    bool Open(const std::string& fname);
+
+    /**
+     * @brief Closes the file.
+     */
+    void Close();
+
+    /**
+     * @brief Adds a page to the next batch.
+     *
+     * @param offset Byte offset of the page in the file
+     * @param page Page bytes (normally exactly one block)
+     */
+    void Stage(long long offset, std::string page);
+
+    /**
+     * @brief Returns the number of pages staged for the next Commit().
+     */
+    size_t GetStagedCount() const { return staged.size(); }
+
+    /**
+     * @brief Writes the staged pages and sets the file size.
+     *
+     * @param sync If true, the batch goes through the journal and is made
+     *             durable with fdatasync (the journal's directory is synced
+     *             after the journal is created); if false, pages are only written
+     * @param fileSize New length of the file in bytes (-1 keeps the length)
+     * @return true if every page was written (and synced)
+     */
+    bool Commit(bool sync, long long fileSize = -1);
+
+    /**
+     * @brief Applies a complete journal left by an interrupted Commit().
+     *
+     * An incomplete journal means the in-place writes never started, so it
+     * is simply removed.
+     *
+     * @param fname Path of the block file
+     * @return true if the file is consistent; false if a journal could not be applied
+     */
+    static bool Recover(const std::string& fname);
+};
+
+#endif // PAGEFILE_H
@@ -0,0 +1,143 @@
+/**
+ * @file PageScrubber.cpp
+ * @brief Implementation of the PageScrubber background checksum verifier.
+ */
+
+#include "PageScrubber.h"
+#include "Block.h"
+#include "HeaderRecord.h"
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+/// Wait before rereading a page that failed, long enough for a commit to finish its write
+static const chrono::milliseconds RECHECK_DELAY(50);
+
+PageScrubber::PageScrubber(const std::string& file)
+    : filename(file), stopping(false), pagesChecked(0), passes(0) {}
+
+PageScrubber::~PageScrubber()
+{
+    Stop();
+}
+
+bool PageScrubber::SleepUntil(chrono::steady_clock::time_point deadline)
+{
+    unique_lock<mutex> guard(lock);
+    return !wake.wait_until(guard, deadline, [this] { return stopping; });
+}
+
+void PageScrubber::Report(int rbn, const char* what)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        if (!corrupt.insert(rbn).second) return;  // reported already
+    }
+    if (rbn < 0) cerr << "[PageScrubber] " << what << " in header page of file: " << filename << "\n";
+    else cerr << "[PageScrubber] " << what << " in block " << rbn << " of file: " << filename << "\n";
+}
+
+bool PageScrubber::Recheck(int rbn, int blockSize)
+{
+    if (!SleepUntil(chrono::steady_clock::now() + RECHECK_DELAY)) return true;  // stopping: do not report
+    ifstream in(filename, ios::binary);
+    string page(static_cast<size_t>(blockSize), '\0');
+    in.seekg((rbn + 1LL) * blockSize);
+    if (!in.read(&page[0], blockSize)) return true;  // file shrank meanwhile: page gone, not damaged
+    return Block::VerifyPage(page);
+}
+
+/**
+ * @brief Reads page after page with one descriptor; reads are spaced
+ *        1/pagesPerSecond apart from the start of the pass.
+ */
+bool PageScrubber::Pass(int pagesPerSecond)
+{
+    ifstream in(filename, ios::binary | ios::ate);
+    if (!in.is_open()) {
+        cerr << "[PageScrubber] Cannot open file: " << filename << "\n";
+        return false;
+    }
+    long long fileSize = static_cast<long long>(in.tellg());
+    in.seekg(0);
+
+    HeaderRecord header;
+    if (!header.Read(in)) {
+        // Reread once: the header page is rewritten by every checkpoint
+        if (SleepUntil(chrono::steady_clock::now() + RECHECK_DELAY)) {
+            ifstream again(filename, ios::binary);
+            HeaderRecord retry;
+            if (!retry.Read(again)) {
+                Report(-1, "Bad header");
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!header.HasPageChecksums()) return true;  // nothing to verify against
+
+    const int blockSize = header.GetBlockSize();
+    const long long pages = fileSize / blockSize - 1;
+    const auto start = chrono::steady_clock::now();
+    bool clean = true;
+    string page(static_cast<size_t>(blockSize), '\0');
+    for (long long rbn = 0; rbn < pages; ++rbn) {
+        if (pagesPerSecond > 0) {
+            auto due = start + chrono::microseconds(rbn * 1000000 / pagesPerSecond);
+            if (!SleepUntil(due)) return clean;
+        } else {
+            lock_guard<mutex> guard(lock);
+            if (stopping) return clean;
+        }
+
+        in.seekg((rbn + 1) * blockSize);
+        if (!in.read(&page[0], blockSize)) break;  // file shrank during the pass
+        ++pagesChecked;
+        if (!Block::VerifyPage(page) && !Recheck(static_cast<int>(rbn), blockSize)) {
+            Report(static_cast<int>(rbn), "Checksum mismatch");
+            clean = false;
+        }
+    }
+    ++passes;
+    return clean;
+}
+
+bool PageScrubber::ScrubOnce(int pagesPerSecond)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        if (!worker.joinable()) stopping = false;  // not stopped by an earlier Stop()
+    }
+    return Pass(pagesPerSecond);
+}
+
+void PageScrubber::Start(int pagesPerSecond, std::chrono::seconds restBetweenPasses)
+{
+    Stop();
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = false;
+    }
+    worker = thread([this, pagesPerSecond, restBetweenPasses] {
+        do {
+            Pass(pagesPerSecond);
+        } while (SleepUntil(chrono::steady_clock::now() + restBetweenPasses));
+    });
+}
+
+void PageScrubber::Stop()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+std::vector<int> PageScrubber::GetCorruptPages() const
+{
+    lock_guard<mutex> guard(lock);
+    return vector<int>(corrupt.begin(), corrupt.end());
+}
@@ -0,0 +1,128 @@
+/**
+ * @file PageScrubber.h
+ * @brief Declares the PageScrubber class, which rereads a block file in the
+ *        background and reports pages whose checksum no longer matches.
+ *
+ * Pages are verified whenever they are read (see Block::VerifyPage()), but a
+ * page that is rarely read can rot on disk for months before anyone notices,
+ * by which time older copies may be gone too. The scrubber walks every page
+ * of the file on its own thread, at a limited number of pages per second so
+ * that it does not compete with queries for the disk, and reports damage as
+ * soon as it finds it.
+ *
+ * The scrubber only reads the file. A page that fails is read again a moment
+ * later from a fresh descriptor before it is reported, so a page caught in
+ * the middle of an in-place commit (see PageFile) is not reported.
+ */
+
+#ifndef PAGESCRUBBER_H
+#define PAGESCRUBBER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class PageScrubber
+ * @brief Rate-limited background checksum verification of a block file.
+ *
+ * Example usage:
+ * @code
+ * PageScrubber scrubber("zip_bptree.dat");
+ * scrubber.Start(200);              // 200 pages per second, a pass every minute
+ * ...
+ * for (int rbn : scrubber.GetCorruptPages()) Alert(rbn);
+ * scrubber.Stop();
+ * @endcode
+ */
+class PageScrubber {
+private:
+    std::string filename;                ///< File being scrubbed
+    std::thread worker;                  ///< Background thread (Start() to Stop())
+    mutable std::mutex lock;             ///< Guards corrupt, stopping
+    std::condition_variable wake;        ///< Signalled by Stop()
+    bool stopping;                       ///< Set by Stop() (under lock)
+    std::set<int> corrupt;               ///< Pages found damaged (-1 = header page)
+    std::atomic<size_t> pagesChecked;    ///< Pages verified since construction
+    std::atomic<int> passes;             ///< Passes completed since construction
+
+    /**
+     * @brief Verifies every page once, pacing the reads.
+     *
+     * @return true if no damaged page was found
+     */
+    bool Pass(int pagesPerSecond);
+
+    /**
+     * @brief Reads page @p rbn again from a fresh descriptor and verifies it.
+     */
+    bool Recheck(int rbn, int blockSize);
+
+    /**
+     * @brief Records and reports a damaged page.
+     */
+    void Report(int rbn, const char* what);
+
+    /**
+     * @brief Sleeps until @p deadline or Stop(); returns false if stopped.
+     */
+    bool SleepUntil(std::chrono::steady_clock::time_point deadline);
+
+public:
+    /**
+     * @brief Constructs a scrubber for @p file; nothing is read until Start() or ScrubOnce().
+     */
+    explicit PageScrubber(const std::string& file);
+
+    /**
+     * @brief Stops the background thread.
+     */
+    ~PageScrubber();
+
+    PageScrubber(const PageScrubber&) = delete;
+    PageScrubber& operator=(const PageScrubber&) = delete;
+
+    /**
+     * @brief Verifies every page once on the calling thread.
+     *
+     * @param pagesPerSecond Read rate limit (0 = as fast as the disk allows)
+     * @return true if every page's checksum matched (or the file has no checksums)
+     */
+    bool ScrubOnce(int pagesPerSecond = 0);
+
+    /**
+     * @brief Starts scrubbing the file in passes on a background thread.
+     *
+     * @param pagesPerSecond Read rate limit (0 = unlimited)
+     * @param restBetweenPasses Pause after each complete pass
+     */
+    void Start(int pagesPerSecond, std::chrono::seconds restBetweenPasses = std::chrono::seconds(60));
+
+    /**
+     * @brief Stops the background thread, mid-pass if need be.
+     */
+    void Stop();
+
+    /**
+     * @brief Returns the pages found damaged so far, in RBN order (-1 = header page).
+     */
+    std::vector<int> GetCorruptPages() const;
+
+    /**
+     * @brief Returns the number of pages verified so far.
+     */
+    size_t GetPagesChecked() const { return pagesChecked.load(); }
+
+    /**
+     * @brief Returns the number of complete passes so far.
+     */
+    int GetPasses() const { return passes.load(); }
+};
+
+#endif // PAGESCRUBBER_H
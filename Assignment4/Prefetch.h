@@ -0,0 +1,34 @@
+/**
+ * @file Prefetch.h
+ * @brief Declares PrefetchLine(), a portable software prefetch hint.
+ *
+ * A lookup that knows which memory it will touch next (the child page it
+ * just found, the next leaf in the chain) can ask the CPU to start loading
+ * it while it works on something else; see BPlusTree::SearchBatch(). The
+ * hint never faults and has no effect on the program's results.
+ */
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief Starts loading the cache line that holds @p address (for reading).
+ *
+ * Compiles to nothing where the compiler has no prefetch intrinsic.
+ */
+inline void PrefetchLine(const void* address)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(address, 0, 3);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+    (void)address;
+#endif
+}
+
+#endif // PREFETCH_H
@@ -1,11 +1,14 @@
 #include "PrimaryKeyIndex.h"
 #include "buffer.h" // for unpackRecord
+#include "BloomFilter.h"
 #include <sstream>
 #include <cstdlib>
 
 /// Build index by scanning the length-indicated file, recording offsets for each record.
 /// This assumes the file uses one record per newline and the first line is the header.
-bool PrimaryKeyIndex::buildIndex(const std::string& dataFilename, const std::string& indexFilename) {
+/// If filterFilename is given, a BloomFilter over the indexed keys is written alongside.
+bool PrimaryKeyIndex::buildIndex(const std::string& dataFilename, const std::string& indexFilename,
+                                 const std::string& filterFilename) {
     std::ifstream in(dataFilename, std::ios::binary);
     if (!in.is_open()) {
         std::cerr << "Error: cannot open data file " << dataFilename << '\n';
@@ -25,6 +28,8 @@ bool PrimaryKeyIndex::buildIndex(const std::string& dataFilename, const std::str
         return false;
     }
 
+    std::vector<uint32_t> keys;
+
     // Process each subsequent line; note offset is location where getline will read the record
     while (true) {
         std::streampos offset = in.tellg();
@@ -38,16 +43,24 @@ bool PrimaryKeyIndex::buildIndex(const std::string& dataFilename, const std::str
         }
 
         out << rec.zip << "," << toLongLong(offset) << '\n';
+        if (!filterFilename.empty()) keys.push_back(rec.zip);
     }
 
     in.close();
     out.close();
+
+    if (!filterFilename.empty()) {
+        BloomFilter filter(keys.size());
+        for (uint32_t zip : keys) filter.add(zip);
+        if (!filter.writeToFile(filterFilename)) return false;
+    }
     return true;
 }
 
-/// Load index file into unordered_map
+/// Load index file into unordered_map, and the filter file if one is given
 bool PrimaryKeyIndex::loadIndex(const std::string& indexFilename,
-                                std::unordered_map<uint32_t, std::streampos>& outIndex) {
+                                std::unordered_map<uint32_t, std::streampos>& outIndex,
+                                const std::string& filterFilename, BloomFilter* outFilter) {
     std::ifstream in(indexFilename);
     if (!in.is_open()) {
         std::cerr << "Error: cannot open index file " << indexFilename << '\n';
@@ -67,6 +80,19 @@ bool PrimaryKeyIndex::loadIndex(const std::string& indexFilename,
         outIndex[zip] = static_cast<std::streampos>(offsetLL);
     }
     in.close();
+
+    // readFromFile() leaves the filter empty on failure, and an empty filter rejects nothing
+    if (outFilter != nullptr && !filterFilename.empty()) outFilter->readFromFile(filterFilename);
+    return true;
+}
+
+/// Reject absent keys with the filter before probing the map
+bool PrimaryKeyIndex::lookup(const std::unordered_map<uint32_t, std::streampos>& index,
+                             const BloomFilter& filter, uint32_t zip, std::streampos& outOffset) {
+    if (!filter.mayContain(zip)) return false;
+    auto it = index.find(zip);
+    if (it == index.end()) return false;
+    outOffset = it->second;
     return true;
 }
 
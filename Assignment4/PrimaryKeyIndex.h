@@ -22,6 +22,7 @@
 #ifndef PRIMARYKEYINDEX_H
 #define PRIMARYKEYINDEX_H
 
+#include "BloomFilter.h"
 #include <cstdint>
 #include <string>
 #include <unordered_map>
@@ -48,11 +49,15 @@ public:
      *
      * @param dataFilename Path to input data file (header + records)
      * @param indexFilename Path to output index file to create (text format)
+     * @param filterFilename Optional path of a BloomFilter file to build over the
+     *        same keys, so lookups for absent ZIPs can be rejected before the
+     *        index is probed (empty = no filter)
      * @return true if index was built successfully; false on I/O error
      *
      * @note The data file must have a valid header and use length-indicated format.
      */
-    static bool buildIndex(const std::string& dataFilename, const std::string& indexFilename);
+    static bool buildIndex(const std::string& dataFilename, const std::string& indexFilename,
+                           const std::string& filterFilename = "");
 
     /**
      * @brief Loads an existing index file into memory as a hash map.
@@ -60,23 +65,45 @@ public:
      * Reads a text index file and populates an unordered_map for fast O(1) lookups.
      * The map key is the ZIP code, and the value is the byte offset in the data file.
      *
+     * If a filter file written by buildIndex() is given, it is loaded into
+     * @p outFilter for lookup(). A missing or damaged filter leaves
+     * @p outFilter empty (it then rejects nothing) and does not fail the load.
+     *
      * @param indexFilename Path to index file to read
      * @param outIndex Reference to unordered_map to populate (maps ZIP -> offset)
+     * @param filterFilename Optional path of the BloomFilter file (empty = none)
+     * @param outFilter Filter to load; may be null when no filter file is given
      * @return true if load succeeds; false on I/O error
      *
      * Example:
      * @code
      * std::unordered_map<uint32_t, std::streampos> index;
-     * if (PrimaryKeyIndex::loadIndex("index.txt", index)) {
-     *     auto it = index.find(12345);
-     *     if (it != index.end()) {
-     *         std::cout << "ZIP 12345 is at offset " << it->second << std::endl;
-     *     }
+     * BloomFilter filter;
+     * std::streampos offset;
+     * if (PrimaryKeyIndex::loadIndex("index.txt", index, "index.bloom", &filter) &&
+     *     PrimaryKeyIndex::lookup(index, filter, 12345, offset)) {
+     *     std::cout << "ZIP 12345 is at offset " << offset << std::endl;
      * }
      * @endcode
      */
     static bool loadIndex(const std::string& indexFilename,
-                          std::unordered_map<uint32_t, std::streampos>& outIndex);
+                          std::unordered_map<uint32_t, std::streampos>& outIndex,
+                          const std::string& filterFilename = "",
+                          BloomFilter* outFilter = nullptr);
+
+    /**
+     * @brief Finds the offset of a ZIP code, asking the filter first.
+     *
+     * A ZIP the filter rejects is reported absent without probing the map.
+     *
+     * @param index Map loaded by loadIndex()
+     * @param filter Filter loaded by loadIndex() (an empty filter rejects nothing)
+     * @param zip ZIP code to find
+     * @param outOffset Set to the record's byte offset when found
+     * @return true if the ZIP is in the index
+     */
+    static bool lookup(const std::unordered_map<uint32_t, std::streampos>& index,
+                       const BloomFilter& filter, uint32_t zip, std::streampos& outOffset);
 
     /**
      * @brief Saves an in-memory index map to disk in text format.
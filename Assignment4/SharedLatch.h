@@ -0,0 +1,95 @@
+/**
+ * @file SharedLatch.h
+ * @brief Declares the SharedLatch class, a reader/writer latch that lets a
+ *        waiting writer in ahead of newly arriving readers.
+ *
+ * std::shared_mutex does not promise any fairness, and the common pthread
+ * implementation prefers readers: with lookups arriving back to back, a
+ * thread waiting for exclusive access may wait for as long as they keep
+ * coming. SharedLatch counts exclusive waiters, and a reader that sees one
+ * yields before taking its shared hold, so the readers already inside drain
+ * and the writer gets in.
+ *
+ * The methods are inline because every lookup takes a latch.
+ */
+
+#ifndef SHAREDLATCH_H
+#define SHAREDLATCH_H
+
+#include <atomic>
+#include <shared_mutex>
+#include <thread>
+
+/**
+ * @class SharedLatch
+ * @brief Writer-preferring shared mutex (meets the SharedMutex requirements).
+ *
+ * Example usage:
+ * @code
+ * SharedLatch latch;
+ * {
+ *     std::shared_lock<SharedLatch> read(latch);   // many at a time
+ * }
+ * {
+ *     std::unique_lock<SharedLatch> write(latch);  // alone
+ * }
+ * @endcode
+ */
+class SharedLatch {
+private:
+    std::shared_mutex mutex;           ///< Underlying latch
+    std::atomic<int> exclusiveWaiting; ///< Threads waiting in lock()
+
+public:
+    /**
+     * @brief Constructs an unlocked latch.
+     */
+    SharedLatch() : exclusiveWaiting(0) {}
+
+    SharedLatch(const SharedLatch&) = delete;
+    SharedLatch& operator=(const SharedLatch&) = delete;
+
+    /**
+     * @brief Takes the latch exclusively; readers arriving meanwhile wait.
+     */
+    void lock()
+    {
+        exclusiveWaiting.fetch_add(1, std::memory_order_relaxed);
+        mutex.lock();
+        exclusiveWaiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Takes the latch exclusively if it is free.
+     */
+    bool try_lock() { return mutex.try_lock(); }
+
+    /**
+     * @brief Releases an exclusive hold.
+     */
+    void unlock() { mutex.unlock(); }
+
+    /**
+     * @brief Takes the latch shared once no writer is waiting.
+     */
+    void lock_shared()
+    {
+        while (exclusiveWaiting.load(std::memory_order_relaxed) > 0) std::this_thread::yield();
+        mutex.lock_shared();
+    }
+
+    /**
+     * @brief Takes the latch shared if that needs no wait.
+     */
+    bool try_lock_shared()
+    {
+        return exclusiveWaiting.load(std::memory_order_relaxed) == 0 && mutex.try_lock_shared();
+    }
+
+    /**
+     * @brief Releases a shared hold.
+     */
+    void unlock_shared() { mutex.unlock_shared(); }
+};
+
+#endif // SHAREDLATCH_H
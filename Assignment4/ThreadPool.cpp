@@ -0,0 +1,112 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief Implementation of the ThreadPool work-stealing scheduler.
+ */
+
+#include "ThreadPool.h"
+
+using namespace std;
+
+namespace {
+/// Pool the calling thread works for (nullptr outside any pool)
+thread_local const ThreadPool* currentPool = nullptr;
+/// Queue index of the calling worker in currentPool
+thread_local size_t currentQueue = 0;
+}
+
+/**
+ * @brief Creates one deque per worker plus the injection deque, then starts
+ *        the workers.
+ */
+ThreadPool::ThreadPool(unsigned threadCount) : queued(0), stopping(false)
+{
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    for (unsigned i = 0; i <= threadCount; ++i) queues.push_back(make_unique<TaskQueue>());
+    threads.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : threads) worker.join();
+}
+
+/**
+ * @brief Created on first use, so programs that never run anything in
+ *        parallel start no threads.
+ */
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+size_t ThreadPool::HomeQueue() const
+{
+    return currentPool == this ? currentQueue : threads.size();
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    TaskQueue& queue = *queues[HomeQueue()];
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.push_back(move(task));
+    }
+    queued.fetch_add(1);
+    // Taking sleepLock orders the count update before a sleeper's check
+    { lock_guard<mutex> guard(sleepLock); }
+    wake.notify_one();
+}
+
+/**
+ * @brief Pops from the back of the home queue, else steals from the front of
+ *        the others, starting with the one after home so thieves spread out.
+ */
+bool ThreadPool::RunOne(size_t home, bool steal)
+{
+    function<void()> task;
+    {
+        TaskQueue& own = *queues[home];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+    for (size_t step = 1; steal && !task && step < queues.size(); ++step) {
+        TaskQueue& victim = *queues[(home + step) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task) return false;
+    queued.fetch_sub(1);
+    task();
+    return true;
+}
+
+/**
+ * @brief Exits only once stopping is set and no task is left, so tasks
+ *        queued before destruction still run.
+ */
+void ThreadPool::WorkerLoop(size_t index)
+{
+    currentPool = this;
+    currentQueue = index;
+    for (;;) {
+        if (RunOne(index)) continue;
+        unique_lock<mutex> guard(sleepLock);
+        wake.wait(guard, [this] { return stopping || queued.load() > 0; });
+        if (stopping && queued.load() == 0) return;
+    }
+}
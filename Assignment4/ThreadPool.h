@@ -0,0 +1,240 @@
+/**
+ * @file ThreadPool.h
+ * @brief Declares the ThreadPool class, a work-stealing task scheduler shared
+ *        by every parallel step (file parsing, state table, page encoding,
+ *        scans).
+ *
+ * Each worker thread owns a deque of tasks. A worker pushes the tasks it
+ * spawns onto its own deque and pops them from the back (newest first, while
+ * their data is still in cache); an idle worker steals from the front of
+ * another worker's deque (oldest first, which are the largest pieces of
+ * work). Tasks submitted from outside the pool go to a separate injection
+ * deque that every worker steals from. Idle workers sleep on a condition
+ * variable, so an idle pool costs no CPU.
+ *
+ * All parallel code uses ThreadPool::Shared(), one pool with a thread per
+ * core, instead of starting its own threads: nested parallel loops then
+ * share the same workers instead of oversubscribing the machine.
+ *
+ * A worker that waits for a task (Wait(), ParallelFor()) runs the tasks it
+ * queued itself meanwhile, so tasks may wait for their own subtasks without
+ * deadlocking the pool. It never runs tasks queued by other threads: the
+ * waiter may hold latches that such a task needs.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of worker threads with per-thread deques and work stealing.
+ *
+ * Example usage:
+ * @code
+ * ThreadPool& pool = ThreadPool::Shared();
+ * std::future<int> answer = pool.Submit([] { return 6 * 7; });
+ * pool.ParallelFor(0, records.size(), 1024, [&](size_t lo, size_t hi) {
+ *     for (size_t i = lo; i < hi; ++i) Process(records[i]);
+ * });
+ * int value = pool.Wait(answer);
+ * @endcode
+ */
+class ThreadPool {
+private:
+    /**
+     * @brief One task deque and its lock.
+     */
+    struct TaskQueue {
+        std::mutex lock;                          ///< Guards @c tasks
+        std::deque<std::function<void()>> tasks;  ///< Owner uses the back, thieves the front
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;  ///< One per worker, then the injection queue
+    std::vector<std::thread> threads;   ///< Worker threads
+    std::mutex sleepLock;               ///< Guards sleeping and waking of idle workers
+    std::condition_variable wake;       ///< Signalled when a task is queued or on shutdown
+    std::atomic<size_t> queued;         ///< Tasks pushed but not yet taken
+    bool stopping;                      ///< Set by the destructor (under sleepLock)
+
+    /**
+     * @brief Queues a task: on the caller's own deque if it is a worker of
+     *        this pool, else on the injection deque.
+     */
+    void Push(std::function<void()> task);
+
+    /**
+     * @brief Runs one queued task, preferring queue @p home.
+     *
+     * Pops the newest task of @p home, else (if @p steal) steals the oldest
+     * task of another queue.
+     *
+     * @param home Queue index of the calling worker (the injection queue
+     *             for outside threads)
+     * @param steal Whether to take tasks from the other queues
+     * @return true if a task was run; false if the queues searched were empty
+     */
+    bool RunOne(size_t home, bool steal = true);
+
+    /**
+     * @brief Returns the queue index of the calling thread in this pool.
+     */
+    size_t HomeQueue() const;
+
+    /**
+     * @brief Main loop of worker @p index: run tasks, sleep when there are none.
+     */
+    void WorkerLoop(size_t index);
+
+public:
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param threadCount Number of workers (0 = one per hardware thread)
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    /**
+     * @brief Runs the tasks still queued, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Returns the process-wide pool (one worker per hardware thread).
+     */
+    static ThreadPool& Shared();
+
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    unsigned GetThreadCount() const { return static_cast<unsigned>(threads.size()); }
+
+    /**
+     * @brief Queues a task and returns a future for its result.
+     *
+     * An exception thrown by the task is rethrown by the future's get().
+     *
+     * @param task Callable taking no arguments
+     * @return Future for the task's return value
+     */
+    template <typename F>
+    auto Submit(F&& task) -> std::future<std::invoke_result_t<F>>
+    {
+        using Result = std::invoke_result_t<F>;
+        auto job = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = job->get_future();
+        Push([job] { (*job)(); });
+        return result;
+    }
+
+    /**
+     * @brief Waits for a future.
+     *
+     * A worker first runs the tasks on its own deque, where a task it
+     * submitted stays until it is run or stolen; once that deque is empty
+     * the task is running elsewhere, and the worker blocks on the future.
+     * Other threads block right away.
+     *
+     * @param result Future returned by Submit()
+     * @return The task's result (rethrows its exception)
+     */
+    template <typename T>
+    T Wait(std::future<T>& result)
+    {
+        size_t home = HomeQueue();
+        if (home < threads.size()) {
+            while (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready &&
+                   RunOne(home, false)) {
+            }
+        }
+        result.wait();
+        return result.get();
+    }
+
+    /**
+     * @brief Calls @p body(lo, hi) over [begin, end) in chunks of at least
+     *        @p grain, on the calling thread and the workers.
+     *
+     * Returns when every chunk is done. Chunks are handed out dynamically,
+     * so uneven chunks balance out. Ranges of one chunk run inline.
+     *
+     * If @p body throws, no further chunks are started; the chunks already
+     * running finish, then the first exception is rethrown.
+     *
+     * @param begin First index
+     * @param end One past the last index
+     * @param grain Minimum chunk size (values below 1 are raised to 1)
+     * @param body Callable taking (size_t lo, size_t hi)
+     */
+    template <typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, F&& body)
+    {
+        if (end <= begin) return;
+        grain = std::max<size_t>(grain, 1);
+        size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1 || threads.empty()) {
+            body(begin, end);
+            return;
+        }
+
+        // A few chunks per thread so that early finishers can take more
+        size_t target = static_cast<size_t>(threads.size() + 1) * 4;
+        if (chunks > target) {
+            chunks = target;
+            grain = (end - begin + chunks - 1) / chunks;
+            chunks = (end - begin + grain - 1) / grain;
+        }
+
+        std::atomic<size_t> next(0);
+        auto drain = [&] {
+            try {
+                for (size_t c = next++; c < chunks; c = next++) {
+                    size_t lo = begin + c * grain;
+                    body(lo, std::min(end, lo + grain));
+                }
+            } catch (...) {
+                next = chunks;  // the other threads stop after their current chunk
+                throw;
+            }
+        };
+        size_t helpers = std::min<size_t>(chunks - 1, threads.size());
+        std::vector<std::future<void>> pending;
+        pending.reserve(helpers);
+        for (size_t i = 0; i < helpers; ++i) pending.push_back(Submit(drain));
+
+        // The helpers use next, drain and body: wait for every one before leaving
+        std::exception_ptr failure;
+        try {
+            drain();
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        for (auto& helper : pending) {
+            try {
+                Wait(helper);
+            } catch (...) {
+                if (!failure) failure = std::current_exception();
+            }
+        }
+        if (failure) std::rethrow_exception(failure);
+    }
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,179 @@
+/**
+ * @file TreeFileReader.cpp
+ * @brief Implementation of the TreeFileReader on-demand tree file access.
+ */
+
+#include "TreeFileReader.h"
+#include "BlockedSequenceSet.h"
+#include "HeaderRecord.h"
+#include "PageFile.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+
+using namespace std;
+
+TreeFileReader::TreeFileReader(unsigned queueDepth)
+    : blockSize(0), codec(CODEC_NONE), pageChecksums(false), pageCount(0), rootRBN(-1), reader(queueDepth) {}
+
+/**
+ * @brief The superblock names the root; a legacy file's root is the last
+ *        page when that page is an index page.
+ */
+bool TreeFileReader::Open(const std::string& file)
+{
+    reader.Close();
+    filename = file;
+    rootRBN = -1;
+    pageCount = 0;
+
+    // Finish an in-place flush that was interrupted by a crash
+    if (!PageFile::Recover(filename)) return false;
+
+    ifstream in(filename, ios::binary | ios::ate);
+    if (!in.is_open()) {
+        cerr << "Cannot open file: " << filename << "\n";
+        return false;
+    }
+    long long fileSize = static_cast<long long>(in.tellg());
+    in.seekg(0);
+    HeaderRecord header;
+    if (!header.Read(in) || header.GetBlockSize() <= Block::PAGE_OVERHEAD) {
+        cerr << "Bad header in file: " << filename << "\n";
+        return false;
+    }
+    blockSize = header.GetBlockSize();
+    codec = header.GetCodec();
+    pageChecksums = header.HasPageChecksums();
+    pageCount = static_cast<int>(max(0LL, (fileSize - 1) / blockSize));
+    if (!reader.Open(filename)) return false;
+
+    if (header.GetVersion() > 0) {
+        // A tree of height 1 is a single leaf: no index pages to descend
+        if (header.GetTreeHeight() > 1 && header.GetRootRBN() < pageCount) rootRBN = header.GetRootRBN();
+    } else if (pageCount > 0) {
+        vector<Block> last;
+        if (!ReadPages({pageCount - 1}, last)) return false;
+        if (last[0].GetType() == INDEX_BLOCK) rootRBN = pageCount - 1;
+    }
+    return true;
+}
+
+bool TreeFileReader::ParsePage(const std::string& bytes, Block& page) const
+{
+    if (pageChecksums && !Block::VerifyPage(bytes)) {
+        cerr << "Checksum mismatch in file: " << filename << "\n";
+        return false;
+    }
+    istringstream text(bytes);
+    return page.Read(text, blockSize, codec);
+}
+
+int TreeFileReader::ChildFor(const Block& node, uint32_t key)
+{
+    const auto& keys = node.GetKeys();
+    auto it = lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end()) return -1;
+    const string& entry = node.getRecords()[it - keys.begin()];
+    size_t comma = entry.find(',');
+    return comma == string::npos ? -1 : atoi(entry.c_str() + comma + 1);
+}
+
+/**
+ * @brief Keeps the reader's queue full until every page has arrived.
+ *
+ * On a failure the reads still in flight are waited for and dropped: their
+ * tags index this batch, not the next one.
+ */
+bool TreeFileReader::ReadPages(const std::vector<int>& rbns, std::vector<Block>& pages)
+{
+    pages.assign(rbns.size(), Block());
+    size_t submitted = 0, received = 0;
+    while (received < rbns.size()) {
+        while (submitted < rbns.size() &&
+               reader.Submit(submitted, (rbns[submitted] + 1LL) * blockSize, static_cast<size_t>(blockSize))) {
+            ++submitted;
+        }
+        CompletedRead done;
+        bool failed = !reader.WaitNext(done) || !done.ok;
+        if (failed) {
+            cerr << "Cannot read file: " << filename << "\n";
+        } else {
+            Block& page = pages[done.tag];
+            failed = !ParsePage(done.bytes, page) || page.GetRBN() != rbns[done.tag];
+            if (failed) cerr << "Bad block " << rbns[done.tag] << " in file: " << filename << "\n";
+        }
+        if (failed) {
+            while (reader.InFlight() > 0 && reader.WaitNext(done)) {}
+            return false;
+        }
+        ++received;
+    }
+    return true;
+}
+
+/**
+ * @brief Moves every key of the batch down one level per round of reads;
+ *        keys that share a page share its read.
+ */
+bool TreeFileReader::SearchBatch(const std::vector<uint32_t>& keys, std::vector<std::string>& outRecords,
+                                 std::vector<char>& found)
+{
+    outRecords.assign(keys.size(), string());
+    found.assign(keys.size(), 0);
+    if (pageCount == 0) return true;
+
+    if (!HasIndex()) {
+        unordered_map<uint32_t, vector<size_t>> wanted;
+        for (size_t i = 0; i < keys.size(); ++i) wanted[keys[i]].push_back(i);
+        return BlockedSequenceSet::ScanFile(filename, reader.GetQueueDepth(), [&](const Block& leaf) {
+            const auto& leafKeys = leaf.GetKeys();
+            for (size_t slot = 0; slot < leafKeys.size(); ++slot) {
+                auto match = wanted.find(leafKeys[slot]);
+                if (match == wanted.end()) continue;
+                for (size_t i : match->second) {
+                    outRecords[i] = leaf.getRecords()[slot];
+                    found[i] = 1;
+                }
+            }
+            return true;
+        });
+    }
+
+    vector<int> at(keys.size(), rootRBN);
+    for (;;) {
+        map<int, size_t> level;  // page -> position in the read batch
+        vector<int> rbns;
+        for (int rbn : at) {
+            if (rbn != -1 && level.emplace(rbn, rbns.size()).second) rbns.push_back(rbn);
+        }
+        if (rbns.empty()) return true;
+
+        vector<Block> pages;
+        if (!ReadPages(rbns, pages)) return false;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            if (at[i] == -1) continue;
+            const Block& page = pages[level[at[i]]];
+            if (page.GetType() == INDEX_BLOCK) {
+                at[i] = ChildFor(page, keys[i]);
+            } else {
+                found[i] = page.FindRecord(keys[i], outRecords[i]);
+                at[i] = -1;
+            }
+        }
+    }
+}
+
+bool TreeFileReader::Scan(const ScanPredicate& predicate, std::vector<std::string>& outRecords)
+{
+    return BlockedSequenceSet::ScanFile(filename, reader.GetQueueDepth(), [&](const Block& leaf) {
+        for (const auto& record : leaf.getRecords()) {
+            if (predicate.Matches(record)) outRecords.push_back(record);
+        }
+        return true;
+    });
+}
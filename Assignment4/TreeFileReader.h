@@ -0,0 +1,150 @@
+/**
+ * @file TreeFileReader.h
+ * @brief Declares the TreeFileReader class, which answers lookups and scans
+ *        straight from a tree file on disk, without loading it.
+ *
+ * BPlusTree::Open() reads every leaf into memory before the first lookup.
+ * A TreeFileReader instead reads only the pages a request needs, through an
+ * AsyncPageReader. A batch of lookups descends the tree one level at a time
+ * and submits the reads of all the batch's pages on a level together, so a
+ * batch of n keys costs (tree height) round trips to the device instead of
+ * n times that. A scan keeps a window of leaf reads in flight.
+ *
+ * The reader sees the file as of its last checkpoint: changes still only
+ * in the write-ahead log are not visible. The root comes from the file's
+ * superblock, so opening costs one header read; in a file from before the
+ * superblock it is the last page (BPlusTree writes the index bottom-up after
+ * the leaves). A file without index pages is searched by scanning its leaves.
+ */
+
+#ifndef TREEFILEREADER_H
+#define TREEFILEREADER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AsyncPageReader.h"
+#include "Block.h"
+#include "LeafScan.h"
+
+/**
+ * @class TreeFileReader
+ * @brief Read-only, on-demand access to a BPlusTree file.
+ *
+ * Example usage:
+ * @code
+ * TreeFileReader file;
+ * file.Open("zip_bptree.dat");
+ * std::vector<std::string> rows;
+ * std::vector<char> found;
+ * file.SearchBatch({90210, 10001, 55401}, rows, found);
+ * @endcode
+ */
+class TreeFileReader {
+private:
+    std::string filename;    ///< Tree file
+    int blockSize;           ///< Page size from the header
+    PageCodecType codec;     ///< Page codec from the header
+    bool pageChecksums;      ///< Pages end in checksum lines (from the header)
+    int pageCount;           ///< Pages after the header page
+    int rootRBN;             ///< Root index page, or -1 if the file has no index
+    AsyncPageReader reader;  ///< Page reads
+
+    /**
+     * @brief Reads the pages @p rbns (all submitted before waiting).
+     *
+     * @param rbns Pages to read (no duplicates)
+     * @param pages Receives the parsed pages, parallel to @p rbns
+     * @return false if a read failed or a page is malformed; the batch's
+     *         other reads have then finished, so none reaches a later call
+     */
+    bool ReadPages(const std::vector<int>& rbns, std::vector<Block>& pages);
+
+public:
+    /**
+     * @brief Constructs a closed reader.
+     *
+     * @param queueDepth Most page reads in flight at once
+     */
+    explicit TreeFileReader(unsigned queueDepth = 32);
+
+    /**
+     * @brief Opens a tree file: reads its header page, which names the root.
+     *
+     * @param file Path of a file written by BPlusTree (or BlockedSequenceSet)
+     * @return true if the file was opened and its header is valid
+     */
+    bool Open(const std::string& file);
+
+    /**
+     * @brief Returns true if the file has index pages (lookups descend them).
+     */
+    bool HasIndex() const { return rootRBN != -1; }
+
+    /**
+     * @brief Returns the page size of the open file.
+     */
+    int GetBlockSize() const { return blockSize; }
+
+    /**
+     * @brief Returns the page codec of the open file.
+     */
+    PageCodecType GetCodec() const { return codec; }
+
+    /**
+     * @brief Returns the root page's RBN, or -1 if the file has no index.
+     */
+    int GetRootRBN() const { return rootRBN; }
+
+    /**
+     * @brief Returns the number of pages after the header page.
+     */
+    int GetPageCount() const { return pageCount; }
+
+    /**
+     * @brief Returns the file's page reader (for callers that drive their own reads).
+     */
+    AsyncPageReader& GetReader() { return reader; }
+
+    /**
+     * @brief Parses one page read from the file.
+     *
+     * @param bytes Page bytes
+     * @param page Receives the page
+     * @return true if the bytes hold a well-formed page (whose checksum
+     *         matches, when the file has page checksums)
+     */
+    bool ParsePage(const std::string& bytes, Block& page) const;
+
+    /**
+     * @brief Returns the child of index page @p node that covers @p key.
+     *
+     * @return Child RBN, or -1 if @p key is beyond the node's last separator
+     */
+    static int ChildFor(const Block& node, uint32_t key);
+
+    /**
+     * @brief Looks up a batch of ZIP codes.
+     *
+     * @param keys ZIP codes to look up
+     * @param outRecords Receives one entry per key (empty if not found)
+     * @param found Receives 1 for each key found, 0 otherwise
+     * @return false if a page could not be read
+     */
+    bool SearchBatch(const std::vector<uint32_t>& keys, std::vector<std::string>& outRecords,
+                     std::vector<char>& found);
+
+    /**
+     * @brief Collects the records that satisfy a predicate, in key order.
+     *
+     * Streams the leaves with the reader's queue depth of reads in flight
+     * (see BlockedSequenceSet::ScanFile()).
+     *
+     * @param predicate Records to keep
+     * @param outRecords Matching records are appended here
+     * @return false if a page could not be read
+     */
+    bool Scan(const ScanPredicate& predicate, std::vector<std::string>& outRecords);
+};
+
+#endif // TREEFILEREADER_H
@@ -0,0 +1,54 @@
+/**
+ * @file TreeSnapshot.cpp
+ * @brief Implementation of the TreeSnapshot read-only tree version.
+ */
+
+#include "TreeSnapshot.h"
+#include "LeafScan.h"
+#include <algorithm>
+
+using namespace std;
+
+TreeSnapshot::TreeSnapshot() : keyOrdered(true) {}
+
+/**
+ * @brief Records each leaf's highest key and whether the chain is in key order.
+ */
+TreeSnapshot::TreeSnapshot(std::vector<std::shared_ptr<const Block>> pages)
+    : leaves(std::move(pages)), keyOrdered(true)
+{
+    for (const auto& leaf : leaves) {
+        const auto& keys = leaf->GetKeys();
+        if (keys.empty()) continue;
+        if (!highKeys.empty() && keys.front() < highKeys.back()) keyOrdered = false;
+        highKeys.push_back(keys.back());
+        keyedLeaves.push_back(leaf.get());
+    }
+}
+
+/**
+ * @brief Finds the first leaf whose highest key is >= @p key and probes it.
+ */
+bool TreeSnapshot::Search(uint32_t key, std::string& outRecord) const
+{
+    if (!keyOrdered) {
+        for (const auto& leaf : leaves) {
+            if (leaf->FindRecord(key, outRecord)) return true;
+        }
+        return false;
+    }
+    size_t i = lower_bound(highKeys.begin(), highKeys.end(), key) - highKeys.begin();
+    return i < keyedLeaves.size() && keyedLeaves[i]->FindRecord(key, outRecord);
+}
+
+void TreeSnapshot::SearchByState(const std::string& state, std::vector<std::string>& outRecords) const
+{
+    LeafScan(*this, ScanPredicate::State(state), SCAN_KEY_ORDER).Run(outRecords);
+}
+
+int TreeSnapshot::GetRecordCount() const
+{
+    int total = 0;
+    for (const auto& leaf : leaves) total += leaf->GetRecordCount();
+    return total;
+}
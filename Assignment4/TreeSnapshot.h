@@ -0,0 +1,93 @@
+/**
+ * @file TreeSnapshot.h
+ * @brief Declares the TreeSnapshot class, a frozen, read-only version of the
+ *        leaf level of a BPlusTree.
+ *
+ * A snapshot shares the tree's leaf pages instead of copying them. The tree
+ * copies a page before its first change after the snapshot was taken, so
+ * every page the snapshot holds stays exactly as it was (snapshot
+ * isolation). A long report can therefore scan a snapshot without latches
+ * while inserts and deletes continue, and it never sees half of a change.
+ * Page versions that only snapshots still hold are freed together with the
+ * last snapshot holding them.
+ */
+
+#ifndef TREESNAPSHOT_H
+#define TREESNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Block.h"
+
+/**
+ * @class TreeSnapshot
+ * @brief Consistent view of every record at one point in time.
+ *
+ * Example usage:
+ * @code
+ * TreeSnapshot view = tree.Snapshot();   // cheap: shares the pages
+ * std::vector<std::string> rows;
+ * view.SearchByState("MN", rows);        // unaffected by concurrent changes
+ * @endcode
+ */
+class TreeSnapshot {
+private:
+    std::vector<std::shared_ptr<const Block>> leaves;  ///< Leaf pages in key (chain) order
+    std::vector<uint32_t> highKeys;  ///< Highest key of each non-empty leaf
+    std::vector<const Block*> keyedLeaves;  ///< Non-empty leaves, parallel to highKeys
+    bool keyOrdered;                 ///< True if the leaves' key ranges ascend along the chain
+
+public:
+    /**
+     * @brief Constructs an empty snapshot.
+     */
+    TreeSnapshot();
+
+    /**
+     * @brief Wraps leaf pages that will not change any more.
+     *
+     * @param pages Leaves in chain order (see BlockedSequenceSet::Snapshot())
+     */
+    explicit TreeSnapshot(std::vector<std::shared_ptr<const Block>> pages);
+
+    /**
+     * @brief Looks up a record by ZIP code as of the snapshot.
+     *
+     * Binary search over the leaves' highest keys when the chain is in key
+     * order (after BuildStaticIndex()), otherwise a probe of every leaf.
+     *
+     * @param key ZIP code to look for
+     * @param outRecord Receives the record when found
+     * @return true if found; false otherwise
+     */
+    bool Search(uint32_t key, std::string& outRecord) const;
+
+    /**
+     * @brief Collects every record of a state, in key order.
+     *
+     * Runs a LeafScan, so the leaves are scanned in parallel.
+     *
+     * @param state Two-letter state code (third field of a record)
+     * @param outRecords Matching records are appended here
+     */
+    void SearchByState(const std::string& state, std::vector<std::string>& outRecords) const;
+
+    /**
+     * @brief Returns the number of records in the snapshot.
+     */
+    int GetRecordCount() const;
+
+    /**
+     * @brief Returns true if the leaves' key ranges ascend along the chain.
+     */
+    bool IsKeyOrdered() const { return keyOrdered; }
+
+    /**
+     * @brief Returns the leaf pages in key (chain) order.
+     */
+    const std::vector<std::shared_ptr<const Block>>& GetLeaves() const { return leaves; }
+};
+
+#endif // TREESNAPSHOT_H
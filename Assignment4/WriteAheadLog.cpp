@@ -0,0 +1,215 @@
+/**
+ * @file WriteAheadLog.cpp
+ * @brief Implementation of the WriteAheadLog redo log.
+ */
+
+#include "WriteAheadLog.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+static int openAppend(const string& path, bool truncate)
+{
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0),
+                 _S_IREAD | _S_IWRITE);
+}
+static long writeFd(int fd, const char* data, size_t size) { return _write(fd, data, static_cast<unsigned>(size)); }
+static bool syncFd(int fd) { return _commit(fd) == 0; }
+static bool truncateFd(int fd, long long size) { return _chsize_s(fd, size) == 0; }
+static void closeFd(int fd) { _close(fd); }
+#else
+static int openAppend(const string& path, bool truncate)
+{
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0), 0644);
+}
+static long writeFd(int fd, const char* data, size_t size) { return static_cast<long>(write(fd, data, size)); }
+static bool syncFd(int fd)
+{
+#ifdef __linux__
+    return fdatasync(fd) == 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+static bool truncateFd(int fd, long long size) { return ftruncate(fd, static_cast<off_t>(size)) == 0; }
+static void closeFd(int fd) { close(fd); }
+#endif
+
+WriteAheadLog::WriteAheadLog(int group)
+    : fd(-1), nextLSN(1), groupSize(max(group, 1)), pendingCount(0), failed(false) {}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    Close();
+}
+
+/**
+ * @brief Parses complete records, redoes the new ones and cuts a torn tail.
+ */
+bool WriteAheadLog::Open(const std::string& fname, uint64_t checkpointLSN,
+                         const std::function<void(char, const std::string&)>& redo)
+{
+    Close();
+    logFilename = fname;
+    nextLSN = checkpointLSN + 1;
+    failed = false;
+
+    string text;
+    {
+        ifstream in(fname, ios::binary);
+        if (in.is_open()) text.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+
+    size_t pos = 0;      // start of the next unparsed record
+    while (pos < text.size()) {
+        const char* start = text.c_str() + pos;
+        char* end = nullptr;
+        unsigned long long lsn = strtoull(start, &end, 10);
+        if (end == start || *end != ' ' || end[1] == '\0' || end[2] != ' ') break;
+        char op = end[1];
+        const char* lenStart = end + 3;
+        unsigned long length = strtoul(lenStart, &end, 10);
+        if (end == lenStart || *end != ' ' || length > text.size()) break;
+
+        size_t payloadAt = static_cast<size_t>(end + 1 - text.c_str());
+        if (payloadAt + length >= text.size() || text[payloadAt + length] != '\n') break;  // torn record
+
+        if (lsn > checkpointLSN) {
+            redo(op, text.substr(payloadAt, length));
+            nextLSN = max<uint64_t>(nextLSN, lsn + 1);
+        }
+        pos = payloadAt + length + 1;
+    }
+
+    fd = openAppend(fname, false);
+    if (fd < 0) {
+        cerr << "Error: cannot open log file " << fname << '\n';
+        return false;
+    }
+    if (pos < text.size() && (!truncateFd(fd, static_cast<long long>(pos)) || !syncFd(fd))) {
+        cerr << "Error: cannot cut torn tail of log file " << fname << '\n';
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool WriteAheadLog::Create(const std::string& fname, uint64_t checkpointLSN)
+{
+    Close();
+    logFilename = fname;
+    nextLSN = checkpointLSN + 1;
+    failed = false;
+    fd = openAppend(fname, true);
+    if (fd < 0 || !syncFd(fd)) {
+        cerr << "Error: cannot create log file " << fname << '\n';
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void WriteAheadLog::Close()
+{
+    if (fd < 0) return;
+    Commit();
+    closeFd(fd);
+    fd = -1;
+}
+
+uint64_t WriteAheadLog::Append(char op, const std::string& payload)
+{
+    if (fd < 0 || failed) return 0;
+    uint64_t lsn = nextLSN++;
+    pending += to_string(lsn);
+    pending += ' ';
+    pending += op;
+    pending += ' ';
+    pending += to_string(payload.size());
+    pending += ' ';
+    pending += payload;
+    pending += '\n';
+    if (++pendingCount >= groupSize && !Commit()) return 0;
+    return lsn;
+}
+
+/**
+ * @brief Writes the group (retrying short writes) and syncs the data.
+ */
+bool WriteAheadLog::Commit()
+{
+    if (fd < 0 || failed) return false;
+    if (pending.empty()) return true;
+
+    size_t done = 0;
+    while (done < pending.size()) {
+        long n = writeFd(fd, pending.data() + done, pending.size() - done);
+        if (n <= 0) {
+            cerr << "Error: cannot write log file " << logFilename << '\n';
+            failed = true;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    if (!syncFd(fd)) {
+        cerr << "Error: cannot sync log file " << logFilename << '\n';
+        failed = true;
+        return false;
+    }
+    pending.clear();
+    pendingCount = 0;
+    return true;
+}
+
+bool WriteAheadLog::Truncate()
+{
+    if (fd < 0) return false;
+    pending.clear();
+    pendingCount = 0;
+    failed = !(truncateFd(fd, 0) && syncFd(fd));
+    return !failed;
+}
+
+/**
+ * @brief fsync + rename + directory fsync (MoveFileEx write-through on Windows).
+ */
+bool WriteAheadLog::ReplaceFile(const std::string& tempFile, const std::string& target)
+{
+#ifdef _WIN32
+    int tfd = _open(tempFile.c_str(), _O_RDWR | _O_BINARY);
+    bool synced = tfd >= 0 && _commit(tfd) == 0;
+    if (tfd >= 0) _close(tfd);
+    return synced && MoveFileExA(tempFile.c_str(), target.c_str(),
+                                 MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    int tfd = open(tempFile.c_str(), O_RDONLY);
+    bool synced = tfd >= 0 && fsync(tfd) == 0;
+    if (tfd >= 0) close(tfd);
+    if (!synced || rename(tempFile.c_str(), target.c_str()) != 0) return false;
+
+    size_t slash = target.find_last_of('/');
+    string dir = (slash == string::npos) ? "." : target.substr(0, slash + 1);
+    int dfd = open(dir.c_str(), O_RDONLY);
+    if (dfd >= 0) {
+        fsync(dfd);
+        close(dfd);
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,159 @@
+/**
+ * @file WriteAheadLog.h
+ * @brief Declares the WriteAheadLog class, a redo log of logical record
+ *        mutations that makes B+ tree changes durable without rewriting
+ *        the block file.
+ *
+ * Every Insert and Delete is appended to the log, and blocks only reach the
+ * file at a checkpoint, after the log records they contain are committed.
+ * Log records are buffered and written together (group commit): one
+ * sequential write and one fdatasync per group instead of one per change.
+ * A checkpoint writes the block file with the last logged LSN in its header
+ * and then empties the log. On open, every record with an LSN above the
+ * file's checkpoint LSN is replayed (redo recovery), so each change is
+ * applied exactly once.
+ *
+ * Log file format (text, one record per line):
+ * @code
+ * <lsn> <op> <length> <payload>
+ * 17 I 45 56301,Waite Park,MN,Stearns,45.543,-94.226
+ * 18 D 5 56301
+ * @endcode
+ * where op is I (insert, payload = record) or D (delete, payload = key).
+ * A torn last record (short payload or missing newline) ends the log.
+ */
+
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @class WriteAheadLog
+ * @brief Append-only redo log with group commit.
+ *
+ * Example usage:
+ * @code
+ * WriteAheadLog log;
+ * log.Open("zip.dat.wal", checkpointLSN,
+ *          [&](char op, const std::string& payload) { ... redo ... });
+ * log.Append('I', "56301,Waite Park,MN,Stearns,45.543,-94.226");
+ * log.Commit();   // durable from here on
+ * @endcode
+ */
+class WriteAheadLog {
+private:
+    std::string logFilename;  ///< Path of the log file
+    int fd;                   ///< Open descriptor of the log (-1 = closed)
+    uint64_t nextLSN;         ///< LSN given to the next appended record
+    int groupSize;            ///< Records buffered before an automatic Commit()
+    int pendingCount;         ///< Records in @c pending
+    std::string pending;      ///< Encoded records not yet written to the file
+    bool failed;              ///< A write or sync failed; nothing more is durable until Truncate()
+
+public:
+    /**
+     * @brief Constructs a closed log.
+     *
+     * @param group Records per group commit (values below 1 are raised to 1)
+     */
+    explicit WriteAheadLog(int group = 32);
+
+    /**
+     * @brief Commits pending records and closes the log.
+     */
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /**
+     * @brief Opens (or creates) a log, replaying records newer than a checkpoint.
+     *
+     * @p redo is called in LSN order for each record with LSN > @p checkpointLSN.
+     * A torn tail is cut off so new records follow the last complete one.
+     *
+     * @param fname Log file path
+     * @param checkpointLSN LSN already reflected in the block file
+     * @param redo Callback receiving (op, payload) of each record to reapply
+     * @return true if the log was opened; false on I/O error
+     */
+    bool Open(const std::string& fname, uint64_t checkpointLSN,
+              const std::function<void(char, const std::string&)>& redo);
+
+    /**
+     * @brief Creates an empty log, discarding any previous file content.
+     *
+     * @param fname Log file path
+     * @param checkpointLSN LSN of the block file; numbering continues after it
+     * @return true if the log was created; false on I/O error
+     */
+    bool Create(const std::string& fname, uint64_t checkpointLSN);
+
+    /**
+     * @brief Commits pending records and closes the file.
+     */
+    void Close();
+
+    /**
+     * @brief Returns true if the log is open for appending.
+     */
+    bool IsOpen() const { return fd >= 0; }
+
+    /**
+     * @brief Appends one record to the current group.
+     *
+     * The group is committed once it holds @c groupSize records.
+     *
+     * @param op 'I' for insert or 'D' for delete
+     * @param payload Record (insert) or key (delete)
+     * @return LSN of the record, or 0 if the log is closed or has failed
+     */
+    uint64_t Append(char op, const std::string& payload);
+
+    /**
+     * @brief Writes all pending records with one write and one fdatasync.
+     *
+     * After an I/O error the log may end in a partial group, so every later
+     * Commit() fails too until Truncate() empties the log.
+     *
+     * @return true if the records are durable; false on I/O error
+     */
+    bool Commit();
+
+    /**
+     * @brief Empties the log after a checkpoint. LSNs keep increasing.
+     *
+     * @return true on success; false on I/O error
+     */
+    bool Truncate();
+
+    /**
+     * @brief Sets the number of records per group commit.
+     *
+     * @param group Records per group (values below 1 are raised to 1)
+     */
+    void SetGroupSize(int group) { groupSize = group < 1 ? 1 : group; }
+
+    /**
+     * @brief Returns the LSN of the last appended record.
+     */
+    uint64_t GetLastLSN() const { return nextLSN - 1; }
+
+    /**
+     * @brief Durably replaces @p target with @p tempFile.
+     *
+     * Syncs the temporary file, renames it over the target and syncs the
+     * directory, so after a crash the target is either the old or the new
+     * file, never a partial one.
+     *
+     * @param tempFile Fully written replacement file
+     * @param target File to replace
+     * @return true on success; false on I/O error
+     */
+    static bool ReplaceFile(const std::string& tempFile, const std::string& target);
+};
+
+#endif // WRITEAHEADLOG_H
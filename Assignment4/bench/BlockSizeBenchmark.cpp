@@ -0,0 +1,113 @@
+/**
+ * @file BlockSizeBenchmark.cpp
+ * @brief Sweeps the B+ tree block size from 512 B to 64 KB and reports the
+ *        fanout / height / I/O-size trade-off for the ZIP code data set.
+ *
+ * For each block size the program builds a BPlusTree from the records in a
+ * length-indicated file (txtFileRandom.txt, produced by the main program),
+ * then measures:
+ *   - build time (insert + sort + index build + file write)
+ *   - file size, leaf and index block counts, tree height, root fanout
+ *   - average hit and miss lookup time
+ *   - bytes read per lookup (height * block size), the I/O cost of a cold lookup
+ *   - time to reload the leaf level from disk
+ *
+ * Passing "lz" as the second argument builds every file with CODEC_LZ pages.
+ *
+ * Build and run from the Assignment4 directory (a separate program, not linked
+ * into the assignment):
+ * @code
+ * make bench
+ * bench/blocksize_bench [txtFileRandom.txt] [none|lz]
+ * @endcode
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "buffer.h"
+#include "BPlusTree.h"
+
+using namespace std;
+
+/// Milliseconds elapsed since @p start.
+static double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    string dataFile = (argc > 1) ? argv[1] : "txtFileRandom.txt";
+    PageCodecType codec = (argc > 2 && string(argv[2]) == "lz") ? CODEC_LZ : CODEC_NONE;
+    vector<buffer> unpackedRecords;
+    readLengthIndicatedFile(dataFile, unpackedRecords);
+    if (unpackedRecords.empty()) {
+        cerr << "Error: no records in " << dataFile << " (run the main program first)\n";
+        return 1;
+    }
+
+    vector<string> records;
+    vector<string> keys;
+    records.resize(unpackedRecords.size());
+    for (size_t i = 0; i < unpackedRecords.size(); ++i) {
+        formatRecord(unpackedRecords[i], records[i]);
+        keys.push_back(to_string(unpackedRecords[i].zip));
+    }
+
+    printf("%-8s %-9s %-10s %-7s %-7s %-6s %-7s %-9s %-9s %-10s %-9s\n",
+           "Block", "Build ms", "File KB", "Leaves", "Index", "Height", "Fanout",
+           "Hit ns", "Miss ns", "B/lookup", "Load ms");
+
+    for (int blockSize = 512; blockSize <= 65536; blockSize *= 2) {
+        string fname = "bench_" + to_string(blockSize) + ".dat";
+
+        auto start = chrono::steady_clock::now();
+        BPlusTree tree(fname, blockSize, codec);
+        for (const string& rec : records) tree.Insert(rec);
+        streambuf* saved = cout.rdbuf(nullptr);  // silence BuildStaticIndex
+        tree.BuildStaticIndex();
+        cout.rdbuf(saved);
+        double buildMs = elapsedMs(start);
+
+        string out;
+        int found = 0;
+        start = chrono::steady_clock::now();
+        for (const string& key : keys) found += tree.Search(key, out) ? 1 : 0;
+        double hitNs = elapsedMs(start) * 1e6 / keys.size();
+
+        start = chrono::steady_clock::now();
+        for (size_t i = 0; i < keys.size(); ++i) found += tree.Search(to_string(100000 + i), out) ? 1 : 0;
+        double missNs = elapsedMs(start) * 1e6 / keys.size();
+
+        start = chrono::steady_clock::now();
+        BlockedSequenceSet reloaded(fname);
+        reloaded.ReadFromFile();
+        double loadMs = elapsedMs(start);
+
+        ifstream sizeCheck(fname, ios::binary | ios::ate);
+        long long fileBytes = static_cast<long long>(sizeCheck.tellg());
+        sizeCheck.close();
+
+        int leaves = tree.GetSequenceSet().GetTotalBlocks();
+        double fanout = tree.GetIndexBlockCount() > 0
+                        ? static_cast<double>(leaves + tree.GetIndexBlockCount() - 1) / tree.GetIndexBlockCount()
+                        : 0.0;
+
+        printf("%-8d %-9.1f %-10lld %-7d %-7d %-6d %-7.1f %-9.0f %-9.0f %-10d %-9.1f\n",
+               blockSize, buildMs, fileBytes / 1024, leaves, tree.GetIndexBlockCount(),
+               tree.GetTreeHeight(), fanout, hitNs, missNs,
+               tree.GetTreeHeight() * blockSize, loadMs);
+
+        if (found != static_cast<int>(keys.size())) {
+            cerr << "Warning: " << found << " of " << keys.size() << " lookups matched\n";
+        }
+        remove(fname.c_str());
+        remove((fname + ".bloom").c_str());
+    }
+    return 0;
+}
@@ -6,17 +6,164 @@
  * Contains all major functionality for the ZIP Code Processing system.
  */
 #include "buffer.h"
+#include "AsyncPageReader.h"
+#include "ThreadPool.h"
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
+#include <memory_resource>
+#include <string_view>
 
 using namespace std;
 
+/**
+ * @brief Reads a whole text file and indexes its lines.
+ *
+ * The text and the line index come from one arena, so loading a file costs
+ * a few allocations instead of one per line, and all of it is released
+ * together when the caller's arena goes away.
+ *
+ * @param filename File to read.
+ * @param skip Lines to drop from the top of the file.
+ * @param text Receives the file text (allocated from its arena).
+ * @param lines Receives a view of each line, without the newline.
+ * @return false if the file cannot be opened.
+ */
+static bool readLines(const string& filename, size_t skip, pmr::string& text, pmr::vector<string_view>& lines)
+{
+    ifstream inputFile(filename);
+    if (!inputFile.is_open()) return false;
+
+    inputFile.seekg(0, ios::end);
+    streamoff size = inputFile.tellg();
+    inputFile.seekg(0, ios::beg);
+    text.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    inputFile.read(&text[0], static_cast<streamsize>(text.size()));
+    text.resize(static_cast<size_t>(inputFile.gcount()));  // text mode may drop '\r's
+    inputFile.close();
+
+    // Same lines getline() would return: a final line needs no newline
+    lines.reserve(static_cast<size_t>(count(text.begin(), text.end(), '\n')) + 1);
+    string_view rest(text);
+    for (size_t line = 0; !rest.empty(); ++line)
+    {
+        size_t end = rest.find('\n');
+        if (line >= skip) lines.push_back(rest.substr(0, end));
+        rest.remove_prefix(end == string_view::npos ? rest.size() : end + 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the text up to the next @p delimiter and moves @p rest past
+ *        it, like getline() on a stringstream (empty once @p rest is used up).
+ */
+static string_view nextField(string_view& rest, char delimiter = ',')
+{
+    size_t end = rest.find(delimiter);
+    string_view field = rest.substr(0, end);
+    rest.remove_prefix(end == string_view::npos ? rest.size() : end + 1);
+    return field;
+}
+
+/**
+ * @brief Converts a field with atoi()/strtod() (the field need not be NUL-terminated).
+ */
+static int fieldToInt(string_view field)
+{
+    char text[32];
+    size_t length = min(field.size(), sizeof(text) - 1);
+    memcpy(text, field.data(), length);
+    text[length] = '\0';
+    return atoi(text);
+}
+
+static double fieldToDouble(string_view field)
+{
+    char text[64];
+    size_t length = min(field.size(), sizeof(text) - 1);
+    memcpy(text, field.data(), length);
+    text[length] = '\0';
+    return strtod(text, nullptr);
+}
+
+/**
+ * @brief Parses one CSV row (zip,place_name,state,county,latitude,longitude).
+ *
+ * @param line Raw CSV row.
+ * @param record Output buffer holding the parsed values.
+ */
+static void parseCsvLine(string_view line, buffer& record)
+{
+    record.length = line.length();
+    record.zip = fieldToInt(nextField(line));
+    record.place_name.assign(nextField(line));
+    record.state.assign(nextField(line));
+    record.county.assign(nextField(line));
+    record.latitude = fieldToDouble(nextField(line));
+    record.longitude = fieldToDouble(nextField(line));
+}
+
+/**
+ * @brief unpackRecord() on a view of the line.
+ */
+static bool unpackLine(string_view line, buffer& record)
+{
+    if (line.empty()) return false;
+
+    // Skip the length field; the rest is the CSV data
+    size_t comma = line.find(',');
+    if (comma == string_view::npos) return false;
+    string_view data = line.substr(comma + 1);
+    record.length = data.length();
+
+    record.zip = fieldToInt(nextField(data));
+    record.place_name.assign(nextField(data));
+    record.state.assign(nextField(data));
+    record.county.assign(nextField(data));
+    record.latitude = fieldToDouble(nextField(data));
+    record.longitude = fieldToDouble(nextField(data, '\n'));
+    return true;
+}
+
+/**
+ * @brief Appends a double as std::to_string() formats it ("%f").
+ */
+static void appendFixed(string& out, double value)
+{
+    char text[64];
+    int length = snprintf(text, sizeof(text), "%f", value);
+    if (length >= 0 && length < static_cast<int>(sizeof(text)))
+        out.append(text, static_cast<size_t>(length));
+    else
+        out += to_string(value);
+}
+
+void formatRecord(const buffer& record, std::string& out)
+{
+    char zip[16];
+    int length = snprintf(zip, sizeof(zip), "%u", record.zip);
+    out.clear();
+    out.append(zip, static_cast<size_t>(length));
+    out += ',';
+    out += record.place_name;
+    out += ',';
+    out += record.state;
+    out += ',';
+    out += record.county;
+    out += ',';
+    appendFixed(out, record.latitude);
+    out += ',';
+    appendFixed(out, record.longitude);
+}
+
 /**
  * @brief Parses a CSV file into buffer records, sorts them, and writes output.
  *
  * This function:
  *   - Reads a CSV file line-by-line
- *   - Parses each column into a buffer record
+ *   - Parses each column into a buffer record (in parallel)
  *   - Stores all records into a vector
  *   - Sorts them first by ZIP, then by latitude
  *   - Writes sorted results to an output text file
@@ -36,38 +183,22 @@ void parsing(int argc, char** argv, buffer* pointer, string file, ofstream& txtF
     // Storage for all parsed records
     vector<buffer> records;
 
-    ifstream inputFile(file);
-    string line;
-
-    // Skip first three header lines in the input CSV
-    getline(inputFile, line); // skip headers
-    getline(inputFile, line);
-    getline(inputFile, line);
+    // Read the file (skipping its three header lines), then split the lines
+    // into fields on the thread pool; the text is freed with the arena
+    pmr::monotonic_buffer_resource arena;
+    pmr::string text(&arena);
+    pmr::vector<string_view> lines(&arena);
+    readLines(file, 3, text, lines);
 
-    // CSV Parsing Loop
-    while(getline(inputFile, line))
+    records.resize(lines.size());
+    ThreadPool::Shared().ParallelFor(0, lines.size(), 1024, [&](size_t lo, size_t hi)
     {
-        stringstream inputString(line);
-
-        pointer->length = line.length();
-        getline(inputString, pointer->tempString, ',');
-        pointer->zip = atoi(pointer->tempString.c_str());
-
-        getline(inputString, pointer->place_name, ',');
-        getline(inputString, pointer->state, ',');
-        getline(inputString, pointer->county, ',');
-
-        getline(inputString, pointer->tempString, ',');
-        pointer->latitude = strtod(pointer->tempString.c_str(), nullptr);
-
-        getline(inputString, pointer->tempString, ',');
-        pointer->longitude = strtod(pointer->tempString.c_str(), nullptr);
-
-        records.push_back(*pointer);
-        line = "";
-    }
-
-    inputFile.close();
+        for (size_t i = lo; i < hi; ++i)
+        {
+            parseCsvLine(lines[i], records[i]);
+        }
+    });
+    if (!records.empty()) *pointer = records.back();
 
     // Sorting
     sortingZip(records);
@@ -108,28 +239,38 @@ void sortingLocation(vector<buffer>& records)
 /**
  * @brief Reads all length-indicated records from a file into memory.
  *
- * Skips the first line (header) and unpacks each record.
+ * Skips the first line (header) and unpacks each record. Lines are
+ * unpacked in parallel; the records keep the file's order.
  *
  * @param filename Input file name.
  * @param records Output vector filled with unpacked records.
  */
 void readLengthIndicatedFile(string filename, vector<buffer>& records)
 {
-    ifstream inputFile(filename);
-    if (!inputFile.is_open()) return;
+    pmr::monotonic_buffer_resource arena;
+    pmr::string text(&arena);
+    pmr::vector<string_view> lines(&arena);
+    if (!readLines(filename, 1, text, lines)) return;  // skips the header
 
     records.clear();
-    string line;
-    getline(inputFile, line); // skip header
 
-    while(getline(inputFile, line))
+    // Unpack on the thread pool, then keep the good records in file order
+    vector<buffer> unpacked(lines.size());
+    vector<char> unpackedOk(lines.size(), 0);
+    ThreadPool::Shared().ParallelFor(0, lines.size(), 1024, [&](size_t lo, size_t hi)
     {
-        buffer record;
-        if (unpackRecord(line, record))
-            records.push_back(record);
-    }
+        for (size_t i = lo; i < hi; ++i)
+        {
+            unpackedOk[i] = unpackLine(lines[i], unpacked[i]);
+        }
+    });
 
-    inputFile.close();
+    records.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        if (unpackedOk[i])
+            records.push_back(move(unpacked[i]));
+    }
 }
 
 /**
@@ -144,35 +285,7 @@ void readLengthIndicatedFile(string filename, vector<buffer>& records)
  */
 bool unpackRecord(string line, buffer& record)
 {
-    if (line.empty()) return false;
-
-    stringstream ss(line);
-    string lengthStr, zipStr, latStr, lonStr;
-
-    // length field
-    getline(ss, lengthStr, ',');
-    //int expectedLength = atoi(lengthStr.c_str());
-
-    // Extract substring containing actual CSV data
-    string dataStr = line.substr(lengthStr.length() + 1);
-    stringstream dataStream(dataStr);
-    
-    getline(dataStream, zipStr, ',');
-    record.zip = atoi(zipStr.c_str());
-
-    getline(dataStream, record.place_name, ',');
-    getline(dataStream, record.state, ',');
-    getline(dataStream, record.county, ',');
-
-    getline(dataStream, latStr, ',');
-    record.latitude = strtod(latStr.c_str(), nullptr);
-
-    getline(dataStream, lonStr);
-    record.longitude = strtod(lonStr.c_str(), nullptr);
-
-    record.length = dataStr.length();
-
-    return true;
+    return unpackLine(line, record);
 }
 
 /**
@@ -198,6 +311,32 @@ struct StateExtremotes
 // Global table storing per-state extremes.
 map<string, StateExtremotes> stateData;
 
+/**
+ * @brief Folds one state's extremes into a table.
+ *
+ * Ties keep the entry already in the table, so folding records (or slice
+ * tables) in record order always picks the first record that reaches an
+ * extreme.
+ *
+ * @param table Table to update.
+ * @param next Extremes of later records of the same state.
+ */
+static void mergeExtremes(map<string, StateExtremotes>& table, const StateExtremotes& next)
+{
+    auto found = table.find(next.state);
+    if (found == table.end())
+    {
+        table[next.state] = next;
+        return;
+    }
+
+    StateExtremotes& extremes = found->second;
+    if (next.easternmost.longitude < extremes.easternmost.longitude) extremes.easternmost = next.easternmost;
+    if (next.westernmost.longitude > extremes.westernmost.longitude) extremes.westernmost = next.westernmost;
+    if (next.northernmost.latitude > extremes.northernmost.latitude) extremes.northernmost = next.northernmost;
+    if (next.southernmost.latitude < extremes.southernmost.latitude) extremes.southernmost = next.southernmost;
+}
+
 /**
  * @brief Computes regional extremes for each U.S. state.
  *
@@ -207,33 +346,41 @@ map<string, StateExtremotes> stateData;
  *  - Northernmost
  *  - Southernmost
  *
+ * Slices of the records are reduced in parallel on the thread pool.
+ *
  * @param records List of ZIP code records.
  */
 void generateStateTable(vector<buffer>& records)
 {
-    stateData.clear();
-    for (auto& record : records)
+    // Each slice of the records gets its own table; the slice tables are
+    // then merged in record order
+    size_t slices = min<size_t>(records.size(), (ThreadPool::Shared().GetThreadCount() + 1) * 4);
+    vector<map<string, StateExtremotes>> partial(slices);
+    ThreadPool::Shared().ParallelFor(0, slices, 1, [&](size_t lo, size_t hi)
     {
-        string state = record.state;
-        if (state.empty()) continue;
-
-        // Initialize state
-        if (stateData.find(state) == stateData.end())
-        {
-            StateExtremotes extremes;
-            extremes.state = state;
-            extremes.easternmost = extremes.westernmost = extremes.northernmost = extremes.southernmost = record;
-            extremes.initialized = true;
-            stateData[state] = extremes;
-        }
-        else
+        for (size_t slice = lo; slice < hi; ++slice)
         {
-            StateExtremotes& extremes = stateData[state];
-            if (record.longitude < extremes.easternmost.longitude) extremes.easternmost = record;
-            if (record.longitude > extremes.westernmost.longitude) extremes.westernmost = record;
-            if (record.latitude > extremes.northernmost.latitude) extremes.northernmost = record;
-            if (record.latitude < extremes.southernmost.latitude) extremes.southernmost = record;
+            size_t first = records.size() * slice / slices;
+            size_t last = records.size() * (slice + 1) / slices;
+            for (size_t i = first; i < last; ++i)
+            {
+                const buffer& record = records[i];
+                if (record.state.empty()) continue;
+
+                StateExtremotes extremes;
+                extremes.state = record.state;
+                extremes.easternmost = extremes.westernmost = extremes.northernmost = extremes.southernmost = record;
+                extremes.initialized = true;
+                mergeExtremes(partial[slice], extremes);
+            }
         }
+    });
+
+    stateData.clear();
+    for (auto& table : partial)
+    {
+        for (auto& pair : table)
+            mergeExtremes(stateData, pair.second);
     }
 }
 
@@ -284,6 +431,49 @@ bool readRecordAtOffset(const std::string& filename, std::streampos offset, buff
     return unpackRecord(line, outRecord);
 }
 
+/**
+ * @brief Reads a fixed window at each offset; a record longer than the
+ *        window is read again with readRecordAtOffset().
+ *
+ * @param filename File to read from.
+ * @param offsets Byte positions of the records.
+ * @param outRecords Output records, parallel to offsets.
+ * @param found 1 where a record was read, parallel to offsets.
+ * @return true if the file could be opened.
+ */
+bool readRecordsAtOffsets(const std::string& filename, const std::vector<std::streampos>& offsets,
+                          std::vector<buffer>& outRecords, std::vector<char>& found)
+{
+    const size_t window = 512;
+    outRecords.assign(offsets.size(), buffer());
+    found.assign(offsets.size(), 0);
+
+    AsyncPageReader reader(64);
+    if (!reader.Open(filename)) return false;
+
+    size_t submitted = 0;
+    CompletedRead done;
+    while (submitted < offsets.size() || reader.InFlight() > 0)
+    {
+        while (submitted < offsets.size() &&
+               reader.Submit(submitted, static_cast<long long>(offsets[submitted]), window))
+        {
+            ++submitted;
+        }
+        if (!reader.WaitNext(done)) break;
+
+        size_t i = static_cast<size_t>(done.tag);
+        size_t end = done.bytes.find('\n');
+        if (done.ok && end != string::npos)
+            found[i] = unpackLine(string_view(done.bytes).substr(0, end), outRecords[i]);
+        else if (done.ok && done.bytes.size() < window)
+            found[i] = unpackLine(done.bytes, outRecords[i]);  // last line without a newline
+        else
+            found[i] = readRecordAtOffset(filename, offsets[i], outRecords[i]);
+    }
+    return true;
+}
+
 /**
  * @brief Writes a header text line with a length prefix.
  *
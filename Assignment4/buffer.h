@@ -122,6 +122,18 @@ void readLengthIndicatedFile(string filename, vector<buffer>& records);
  */
 bool unpackRecord(string line, buffer& record);
 
+/**
+ * @brief Formats a record as the CSV line stored in blocks.
+ *
+ * Produces "zip,place_name,state,county,latitude,longitude" with the
+ * coordinates written as std::to_string() writes them. The line is built
+ * in @p out, so a caller formatting many records reuses one string.
+ *
+ * @param record Record to format.
+ * @param out Receives the line (previous contents are replaced).
+ */
+void formatRecord(const buffer& record, std::string& out);
+
 /**
  * @brief Generates a table of state-based geographic extremes.
  *
@@ -152,6 +164,22 @@ void printStateTable();
  */
 bool readRecordAtOffset(const std::string& filename, std::streampos offset, buffer& outRecord);
 
+/**
+ * @brief Reads the records at many byte offsets, with the reads in flight together.
+ *
+ * Every read is submitted before any is waited for (see AsyncPageReader.h),
+ * so a batch of lookups costs about one device round trip instead of one
+ * per record.
+ *
+ * @param filename Input filename.
+ * @param offsets Byte positions where the records begin.
+ * @param outRecords Receives one record per offset.
+ * @param found Receives 1 for each record read, 0 where the read failed.
+ * @return true if the file could be opened.
+ */
+bool readRecordsAtOffsets(const std::string& filename, const std::vector<std::streampos>& offsets,
+                          std::vector<buffer>& outRecords, std::vector<char>& found);
+
 /**
  * @brief Writes a header record line to a file.
  *
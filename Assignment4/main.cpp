@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <limits> // for std::numeric_limits
+#include <numeric>
+#include <algorithm>
 
 #include "buffer.h"
 #include "Block.h"
@@ -48,31 +50,28 @@ int main(int argc, char** argv) {
     std::cout << "\n=== GENERATING BLOCKED SEQUENCE SET FILE ===" << std::endl;
     std::string blockedFileName = "BlockedSequenceSet.dat";
 
-    // Create BSS with only the filename (as constructor expects)
-    BlockedSequenceSet bss(blockedFileName);
+    // Visit the records in ZIP order (stable, so equal ZIPs keep file order)
+    std::vector<size_t> byZip(unpackedRecords.size());
+    std::iota(byZip.begin(), byZip.end(), 0);
+    std::stable_sort(byZip.begin(), byZip.end(), [&unpackedRecords](size_t a, size_t b) {
+        return unpackedRecords[a].zip < unpackedRecords[b].zip;
+    });
 
-    // Add CSV-converted string records to BSS
-    for (auto& rec : unpackedRecords) {
-        std::string recStr = to_string(rec.zip) + "," + rec.place_name + "," + rec.state + "," +
-                        rec.county + "," + to_string(rec.latitude) + "," + to_string(rec.longitude);
-        bss.AddRecord(recStr);
-    }
-
-    bss.WriteToFile();
-    bss.PrintSummary();
-    
-    // === Build B+Tree from the sequence set ===
+    // === Build the B+Tree and its sequence set in one pass ===
+    // Each record is formatted once, straight into the tree's leaves; the
+    // tree then builds its index levels and writes the file
     BPlusTree bptree(blockedFileName, 512);   // use same block size as blocks
-
-    // Insert all records into the B+Tree's internal sequence set
-    for (auto& rec : unpackedRecords) {
-        std::string recStr = to_string(rec.zip) + "," + rec.place_name + "," + rec.state + "," +
-                        rec.county + "," + to_string(rec.latitude) + "," + to_string(rec.longitude);
-        bptree.Insert(recStr);
-    }
-
-    // Build static B+tree index and dump its structure
-    bptree.BuildStaticIndex();
+    size_t nextRecord = 0;
+    std::string recStr;
+    bptree.BulkLoad([&](std::string& record) {
+        if (nextRecord == byZip.size()) return false;
+        formatRecord(unpackedRecords[byZip[nextRecord++]], recStr);
+        record.swap(recStr);
+        return true;
+    });
+    bptree.GetSequenceSet().PrintSummary();
+
+    // Dump the index structure
     bptree.DumpTree(std::cout);
 
     // Print a simple summary of the tree
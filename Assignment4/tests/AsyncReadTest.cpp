@@ -0,0 +1,149 @@
+/**
+ * @file AsyncReadTest.cpp
+ * @brief Checks that the io_uring and thread-pool readers return the same
+ *        bytes, that a reader refuses reads it cannot start, and that
+ *        coroutine lookups through a one-deep queue match Search().
+ */
+
+#include "TestCheck.h"
+#include "AsyncPageReader.h"
+#include "AsyncQuery.h"
+#include "BPlusTree.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* DATA_FILE = "async_read_test.bin";
+static const char* TREE_FILE = "async_read_test.dat";
+
+/// One read: where, how much, and what came back
+struct ReadResult {
+    bool ok;
+    string bytes;
+};
+
+/// Reads @p ranges through @p reader, submitting as many as fit before waiting.
+static map<uint64_t, ReadResult> readRanges(AsyncPageReader& reader, const vector<pair<long long, size_t>>& ranges)
+{
+    map<uint64_t, ReadResult> results;
+    size_t next = 0;
+    CompletedRead done;
+    while (next < ranges.size() || reader.InFlight() > 0) {
+        while (next < ranges.size() && reader.Submit(next, ranges[next].first, ranges[next].second)) ++next;
+        if (!reader.WaitNext(done)) break;
+        CHECK(done.offset == ranges[done.tag].first);
+        results[done.tag] = ReadResult{done.ok, move(done.bytes)};
+    }
+    return results;
+}
+
+int main()
+{
+    mt19937 rng(331);
+    string contents(300000, '\0');
+    for (char& c : contents) c = static_cast<char>(rng());
+    {
+        ofstream out(DATA_FILE, ios::binary);
+        out.write(contents.data(), static_cast<streamsize>(contents.size()));
+    }
+
+    // Pages, odd ranges, a read running past the end and one wholly beyond it
+    vector<pair<long long, size_t>> ranges;
+    for (long long page = 0; page < 64; ++page) ranges.emplace_back(page * 4096, 4096);
+    for (int i = 0; i < 64; ++i) ranges.emplace_back(rng() % contents.size(), 1 + rng() % 9000);
+    ranges.emplace_back(static_cast<long long>(contents.size()) - 100, 4096);
+    ranges.emplace_back(static_cast<long long>(contents.size()) + 4096, 4096);
+
+    AsyncPageReader ring(8, true), pool(8, false);
+    CHECK(ring.Open(DATA_FILE));
+    CHECK(pool.Open(DATA_FILE));
+    CHECK(!pool.UsesIoUring());
+    cout << "Reader compared with thread-pool reads: " << (ring.UsesIoUring() ? "io_uring" : "thread-pool (no io_uring)")
+         << "\n";
+
+    map<uint64_t, ReadResult> fromRing = readRanges(ring, ranges);
+    map<uint64_t, ReadResult> fromPool = readRanges(pool, ranges);
+    CHECK(fromRing.size() == ranges.size());
+    CHECK(fromPool.size() == ranges.size());
+    bool same = true;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        size_t from = min(contents.size(), static_cast<size_t>(ranges[i].first));
+        string expected = contents.substr(from, ranges[i].second);
+        same = same && fromRing[i].ok && fromPool[i].ok && fromRing[i].bytes == expected && fromPool[i].bytes == expected;
+    }
+    CHECK(same);
+
+    // A full queue refuses more reads until one is taken back
+    for (AsyncPageReader* reader : {&ring, &pool}) {
+        for (uint64_t tag = 0; tag < 8; ++tag) CHECK(reader->Submit(tag, tag * 4096, 4096));
+        CHECK(reader->InFlight() == 8);
+        CHECK(!reader->Submit(8, 0, 4096));
+        CompletedRead done;
+        CHECK(reader->WaitNext(done));
+        CHECK(reader->Submit(8, 0, 4096));
+        while (reader->WaitNext(done)) {}
+        CHECK(reader->InFlight() == 0);
+        CHECK(!reader->PollNext(done));
+    }
+
+    // A closed reader refuses every read, with nothing left in flight
+    ring.Close();
+    CompletedRead none;
+    CHECK(!ring.Submit(0, 0, 4096));
+    CHECK(ring.InFlight() == 0);
+    CHECK(!ring.WaitNext(none));
+    AsyncPageReader missing;
+    CHECK(!missing.Open("async_read_test.missing"));
+    CHECK(!missing.Submit(0, 0, 4096));
+
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+    // Coroutine lookups: with one read in flight per file, the rest wait in
+    // the backlog, and every lookup still gets the record Search() finds
+    vector<uint32_t> keys;
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip = 56000; zip < 56600; zip += 3) {
+            tree.Insert(makeRecord(zip));
+            keys.push_back(zip);
+        }
+        tree.BuildStaticIndex();
+    }
+    IoScheduler io(1);
+    AsyncTreeFile tree(io);
+    CHECK(tree.Open(TREE_FILE));
+    int found = 0, missed = 0;
+    for (uint32_t zip = 55990; zip < 56610; ++zip) {
+        io.Spawn([](AsyncTreeFile& file, uint32_t key, int& hits, int& misses) -> Task<void> {
+            optional<string> row = co_await file.Search(key);
+            bool stored = key >= 56000 && key < 56600 && (key - 56000) % 3 == 0;
+            if (row && stored && *row == makeRecord(key)) ++hits;
+            if (!row && !stored) ++misses;
+        }(tree, zip, found, missed));
+    }
+    io.Run();
+    CHECK(found == static_cast<int>(keys.size()));
+    CHECK(missed == 620 - static_cast<int>(keys.size()));
+
+    // A read that cannot succeed ends its task instead of leaving it suspended
+    int file = io.OpenFile(DATA_FILE);
+    CHECK(file >= 0);
+    CompletedRead bad = io.RunUntilComplete([](IoScheduler& s) -> Task<CompletedRead> {
+        co_return co_await s.Read(-1, 0, 4096);
+    }(io));
+    CHECK(!bad.ok);
+    CompletedRead negative = io.RunUntilComplete([](IoScheduler& s, int id) -> Task<CompletedRead> {
+        co_return co_await s.Read(id, -4096, 4096);
+    }(io, file));
+    CHECK(!negative.ok);
+#endif
+
+    remove(DATA_FILE);
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("AsyncReadTest");
+}
@@ -0,0 +1,133 @@
+/**
+ * @file AvailListTest.cpp
+ * @brief Checks the free-space map, reuse of emptied leaves through the avail
+ *        list (in memory and after a reopen), and that a full tail leaf
+ *        shared with a snapshot is not copied.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "FreeSpaceMap.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static const char* TREE_FILE = "avail_list_test.dat";
+
+/// Size of @p file in bytes (-1 if it cannot be opened).
+static long long fileSize(const char* file)
+{
+    ifstream in(file, ios::binary | ios::ate);
+    return in.is_open() ? static_cast<long long>(in.tellg()) : -1;
+}
+
+int main()
+{
+    // The map rounds down, so a page it returns always has the room
+    FreeSpaceMap map(512);
+    CHECK(map.Find(1) == -1);
+    map.Update(0, 40);
+    map.Update(3, 300);
+    map.Update(9, 200);
+    CHECK(map.GetPageCount() == 10);
+    CHECK(map.Find(30) == 0);
+    CHECK(map.Find(100) == 3);
+    CHECK(map.Find(301) == -1);
+    map.Update(3, 0);
+    CHECK(map.Find(100) == 9);
+    CHECK(map.Find(512) == -1);
+
+    // Emptied leaves go on the avail list and are taken by later splits
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip = 20000; zip < 26000; zip += 2) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        BlockedSequenceSet& leaves = tree.GetSequenceSet();
+        int blocks = leaves.GetTotalBlocks();
+
+        for (uint32_t zip = 20000; zip < 21000; zip += 2) CHECK(tree.Delete(to_string(zip)));
+        int freed = leaves.GetFreeBlockCount();
+        CHECK(freed > 0);
+        CHECK(leaves.GetAvailHead() != -1);
+        CHECK(leaves.GetTotalBlocks() == blocks);
+
+        tree.WriteToFile();
+        long long size = fileSize(TREE_FILE);
+
+        // Splits take the freed pages first; the file grows only after that
+        int splits = 0;
+        for (uint32_t zip = 25001; zip < 26000; zip += 2) {
+            int total = leaves.GetTotalBlocks(), free = leaves.GetFreeBlockCount();
+            tree.Insert(makeRecord(zip));
+            if (leaves.GetTotalBlocks() > total) CHECK(free == 0);
+            splits += (leaves.GetTotalBlocks() - total) + (free - leaves.GetFreeBlockCount());
+        }
+        CHECK(splits > freed);
+        CHECK(leaves.GetFreeBlockCount() == 0);
+        CHECK(leaves.GetTotalBlocks() == blocks + splits - freed);
+        tree.WriteToFile();
+        CHECK(fileSize(TREE_FILE) < size + static_cast<long long>(splits) * 512);
+    }
+
+    // The avail list survives a reopen and is still used
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        BlockedSequenceSet& leaves = tree.GetSequenceSet();
+        for (uint32_t zip = 21000; zip < 22000; zip += 2) CHECK(tree.Delete(to_string(zip)));
+        int freed = leaves.GetFreeBlockCount();
+        CHECK(freed > 0);
+        tree.WriteToFile();
+    }
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        BlockedSequenceSet& leaves = tree.GetSequenceSet();
+        int freed = leaves.GetFreeBlockCount();
+        int blocks = leaves.GetTotalBlocks();
+        CHECK(freed > 0);
+        for (uint32_t zip = 21000; zip < 22000; zip += 2) {
+            int total = leaves.GetTotalBlocks(), free = leaves.GetFreeBlockCount();
+            tree.Insert(makeRecord(zip));
+            if (leaves.GetTotalBlocks() > total) CHECK(free == 0);
+        }
+        CHECK(leaves.GetFreeBlockCount() < freed);
+        CHECK(leaves.GetTotalBlocks() == blocks || leaves.GetFreeBlockCount() == 0);
+
+        string record;
+        for (uint32_t zip = 21000; zip < 26000; ++zip) {
+            bool stored = zip % 2 == 0 || zip > 25000;
+            CHECK(tree.Search(to_string(zip), record) == stored);
+        }
+    }
+
+    // Before the build, InsertWhereFits fills room left anywhere
+    {
+        BlockedSequenceSet leaves(TREE_FILE, 512);
+        for (uint32_t zip = 30000; zip < 30400; ++zip) leaves.AddRecord(makeRecord(zip));
+        int blocks = leaves.GetTotalBlocks();
+        for (uint32_t zip = 30000; zip < 30040; ++zip) CHECK(leaves.Delete(to_string(zip)));
+        for (uint32_t zip = 40000; zip < 40030; ++zip) leaves.InsertWhereFits(makeRecord(zip));
+        CHECK(leaves.GetTotalBlocks() == blocks);
+        CHECK(leaves.GetTotalRecords() == 390);
+    }
+
+    // A record that does not fit the tail leaf leaves a snapshot's copy alone
+    {
+        BlockedSequenceSet leaves(TREE_FILE, 512);
+        uint32_t zip = 50000;
+        while (leaves.GetTotalBlocks() < 2) leaves.AddRecord(makeRecord(zip++));
+        int full = leaves.GetHeadRBN();
+        auto shared = leaves.Snapshot();
+        const Block* before = &leaves.GetBlock(full);
+        CHECK(shared.front().get() == before);
+        leaves.AddRecord(makeRecord(zip++));  // goes to the second leaf
+        CHECK(&leaves.GetBlock(full) == before);
+    }
+
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("AvailListTest");
+}
@@ -0,0 +1,60 @@
+/**
+ * @file BlockSplitTest.cpp
+ * @brief Checks leaf splits when records are large enough that two of them
+ *        do not share a block.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+static const char* TREE_FILE = "block_split_test.dat";
+
+/// A record for ZIP @p zip whose place name pads it to about 285 bytes.
+static string makeLargeRecord(uint32_t zip)
+{
+    return to_string(zip) + "," + string(240, 'a' + zip % 26) + ",MN,Stearns,45.500000,-94.100000";
+}
+
+int main()
+{
+    // Each insert after the first needs a page of its own, in either key order
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        tree.Insert(makeLargeRecord(50000));
+        tree.BuildStaticIndex();
+        tree.Insert(makeLargeRecord(40000));
+        tree.Insert(makeLargeRecord(60000));
+        tree.Insert(makeLargeRecord(45000));
+        tree.Insert(makeLargeRecord(55000));
+
+        BlockedSequenceSet& leaves = tree.GetSequenceSet();
+        CHECK(leaves.GetTotalRecords() == 5);
+        CHECK(leaves.GetTotalBlocks() == 5);
+
+        string record;
+        for (uint32_t zip : {40000u, 45000u, 50000u, 55000u, 60000u}) {
+            CHECK(tree.Search(to_string(zip), record));
+            CHECK(record == makeLargeRecord(zip));
+        }
+
+        // The chain stays in key order
+        uint32_t last = 0;
+        int count = 0;
+        for (int rbn = leaves.GetHeadRBN(); rbn != -1; rbn = leaves.GetBlock(rbn).GetNextRBN()) {
+            const Block& block = leaves.GetBlock(rbn);
+            if (block.GetRecordCount() == 0) continue;
+            CHECK(block.GetHighestKeyValue() > last);
+            last = block.GetHighestKeyValue();
+            ++count;
+        }
+        CHECK(count == 5);
+    }
+
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("BlockSplitTest");
+}
@@ -0,0 +1,110 @@
+/**
+ * @file BloomFilterTest.cpp
+ * @brief Checks that the key filter never rejects a stored key, survives a
+ *        round trip through its file, refuses damaged files, and is used by
+ *        PrimaryKeyIndex and BPlusTree::Open.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "BloomFilter.h"
+#include "PrimaryKeyIndex.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static const char* FILTER_FILE = "bloom_test.bloom";
+static const char* TREE_FILE = "bloom_test.dat";
+
+int main()
+{
+    // No false negatives, and few false positives
+    BloomFilter filter(5000);
+    for (uint32_t zip = 10000; zip < 20000; zip += 2) filter.add(zip);
+    int falsePositives = 0;
+    for (uint32_t zip = 10000; zip < 20000; zip += 2) CHECK(filter.mayContain(zip));
+    for (uint32_t zip = 10001; zip < 20000; zip += 2) falsePositives += filter.mayContain(zip) ? 1 : 0;
+    CHECK(falsePositives < 250);  // about 1% of 5000 expected
+
+    // Round trip keeps every bit
+    CHECK(filter.writeToFile(FILTER_FILE));
+    BloomFilter loaded;
+    CHECK(loaded.readFromFile(FILTER_FILE));
+    CHECK(loaded.IsBuilt());
+    for (uint32_t zip = 10000; zip < 20000; ++zip) CHECK(loaded.mayContain(zip) == filter.mayContain(zip));
+
+    // A block count that does not match the file is refused before allocating
+    {
+        fstream f(FILTER_FILE, ios::in | ios::out | ios::binary);
+        uint32_t huge = 0x7FFFFFFF;
+        f.seekp(4);
+        f.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    CHECK(!loaded.readFromFile(FILTER_FILE));
+    CHECK(!loaded.IsBuilt());
+    CHECK(loaded.mayContain(12345));  // an empty filter rejects nothing
+
+    // PrimaryKeyIndex lookups consult the filter first
+    {
+        ofstream idx("bloom_test.idx");
+        idx << "55401,100\n55402,200\n";
+    }
+    BloomFilter keyOnly(2);
+    keyOnly.add(55401);
+    CHECK(keyOnly.writeToFile(FILTER_FILE));
+    unordered_map<uint32_t, streampos> index;
+    BloomFilter indexFilter;
+    streampos offset;
+    CHECK(PrimaryKeyIndex::loadIndex("bloom_test.idx", index, FILTER_FILE, &indexFilter));
+    CHECK(indexFilter.IsBuilt());
+    CHECK(PrimaryKeyIndex::lookup(index, indexFilter, 55401, offset) && offset == streampos(100));
+    CHECK(!PrimaryKeyIndex::lookup(index, indexFilter, 55402, offset));  // the filter says absent
+    CHECK(!PrimaryKeyIndex::lookup(index, BloomFilter(), 99999, offset));
+
+    // BPlusTree::Open finds every key with the stored filter, including keys
+    // inserted after the build and written by a later checkpoint
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip = 30000; zip < 31000; zip += 3) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        for (uint32_t zip = 31000; zip < 31100; ++zip) tree.Insert(makeRecord(zip));
+        tree.WriteToFile();
+    }
+    {
+        BPlusTree reopened(TREE_FILE, 512);
+        CHECK(reopened.Open());
+        string record;
+        for (uint32_t zip = 30000; zip < 31000; zip += 3) CHECK(reopened.Search(to_string(zip), record));
+        for (uint32_t zip = 31000; zip < 31100; ++zip) CHECK(reopened.Search(to_string(zip), record));
+        CHECK(!reopened.Search("30001", record));
+    }
+
+    // A rebuild over records added through the sequence set writes a filter
+    // holding them, in place of the earlier file's filter
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        for (uint32_t zip = 40000; zip < 40100; ++zip) tree.GetSequenceSet().AddRecord(makeRecord(zip));
+        tree.BuildStaticIndex();
+        string record;
+        CHECK(tree.Search("40050", record));
+    }
+    {
+        BloomFilter stored;
+        CHECK(stored.readFromFile(string(TREE_FILE) + ".bloom"));
+        for (uint32_t zip = 40000; zip < 40100; ++zip) CHECK(stored.mayContain(zip));
+        BPlusTree reopened(TREE_FILE, 512);
+        CHECK(reopened.Open());
+        string record;
+        for (uint32_t zip = 40000; zip < 40100; ++zip) CHECK(reopened.Search(to_string(zip), record));
+        CHECK(reopened.Search("30000", record));
+    }
+
+    remove(FILTER_FILE);
+    remove("bloom_test.idx");
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("BloomFilterTest");
+}
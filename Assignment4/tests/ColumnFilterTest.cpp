@@ -0,0 +1,123 @@
+/**
+ * @file ColumnFilterTest.cpp
+ * @brief Checks every ColumnFilter kernel the processor supports against the
+ *        portable one, on random columns of awkward lengths.
+ */
+
+#include "TestCheck.h"
+#include "ColumnFilter.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Column lengths: empty, shorter than a vector, and around word ends
+static const size_t LENGTHS[] = {0, 1, 7, 9, 63, 64, 65, 127, 129, 1001, 4099};
+
+/// The three bitmaps every kernel is run into, for one column and predicate
+struct Selection {
+    vector<uint64_t> equal;    ///< SelectEqual
+    vector<uint64_t> between;  ///< SelectBetween
+    vector<uint64_t> anded;    ///< AndBetween into an alternating bitmap
+};
+
+/// Runs the kernels in use; bitmaps start all ones to catch bits left set.
+static Selection runKernels(const vector<uint16_t>& states, uint16_t target,
+                            const vector<float>& values, float low, float high)
+{
+    size_t words = ColumnFilter::WordsFor(states.size());
+    Selection out;
+    out.equal.assign(words, ~0ULL);
+    out.between.assign(words, ~0ULL);
+    out.anded.assign(words, 0xAAAAAAAAAAAAAAAAULL);
+    ColumnFilter::SelectEqual(states.data(), states.size(), target, out.equal.data());
+    ColumnFilter::SelectBetween(values.data(), values.size(), low, high, out.between.data());
+    ColumnFilter::AndBetween(values.data(), values.size(), low, high, out.anded.data());
+    return out;
+}
+
+/// Returns true if no bit past row @p rows is set.
+static bool tailClear(const vector<uint64_t>& bits, size_t rows)
+{
+    if (rows % 64 == 0) return true;
+    return (bits.back() >> (rows % 64)) == 0;
+}
+
+int main()
+{
+    const float inf = numeric_limits<float>::infinity();
+    const float nan = numeric_limits<float>::quiet_NaN();
+
+    vector<string> sets = {"portable"};
+    if (ColumnFilter::SetInstructionSet("sse2")) sets.push_back("sse2");
+    if (ColumnFilter::SetInstructionSet("avx2")) sets.push_back("avx2");
+
+    // Unknown names are refused
+    CHECK(!ColumnFilter::SetInstructionSet("neon"));
+
+    // Target ids at the signed 16-bit edges, and float ranges with equal
+    // ends, signed zeros, infinities and a NaN bound
+    const uint16_t targets[] = {0, 1, 0x7FFF, 0x8000, 0xFFFF};
+    const float ranges[][2] = {{-1.0f, 1.0f}, {0.5f, 0.5f}, {-0.0f, 0.0f}, {-inf, inf},
+                               {2.0f, -2.0f}, {nan, 1.0f}, {-inf, -1.0f}};
+
+    mt19937 rng(331);
+    for (size_t rows : LENGTHS) {
+        vector<uint16_t> states(rows);
+        vector<float> values(rows);
+        for (size_t i = 0; i < rows; ++i) {
+            // Few distinct ids, so each target matches often
+            states[i] = targets[rng() % 5];
+            switch (rng() % 8) {
+            case 0: values[i] = nan; break;
+            case 1: values[i] = (rng() % 2) ? inf : -inf; break;
+            case 2: values[i] = (rng() % 2) ? 0.0f : -0.0f; break;
+            case 3: values[i] = ranges[rng() % 7][rng() % 2]; break;  // on a bound
+            default: values[i] = uniform_real_distribution<float>(-3.0f, 3.0f)(rng); break;
+            }
+        }
+
+        for (uint16_t target : targets) {
+            for (const auto& range : ranges) {
+                ColumnFilter::SetInstructionSet("portable");
+                Selection expected = runKernels(states, target, values, range[0], range[1]);
+
+                // The portable kernels match the scalar definition
+                size_t equalRows = 0, betweenRows = 0, andRows = 0;
+                for (size_t i = 0; i < rows; ++i) {
+                    equalRows += states[i] == target;
+                    bool inside = values[i] >= range[0] && values[i] <= range[1];
+                    betweenRows += inside;
+                    andRows += inside && i % 2 == 1;
+                }
+                size_t words = expected.equal.size();
+                CHECK(ColumnFilter::CountSelected(expected.equal.data(), words) == equalRows);
+                CHECK(ColumnFilter::CountSelected(expected.between.data(), words) == betweenRows);
+                CHECK(ColumnFilter::CountSelected(expected.anded.data(), words) == andRows);
+                CHECK(tailClear(expected.equal, rows));
+                CHECK(tailClear(expected.between, rows));
+                CHECK(tailClear(expected.anded, rows));
+
+                for (size_t s = 1; s < sets.size(); ++s) {
+                    CHECK(ColumnFilter::SetInstructionSet(sets[s].c_str()));
+                    Selection got = runKernels(states, target, values, range[0], range[1]);
+                    if (got.equal != expected.equal || got.between != expected.between ||
+                        got.anded != expected.anded) {
+                        cerr << sets[s] << " differs from portable: " << rows << " rows, target "
+                             << target << ", range [" << range[0] << ", " << range[1] << "]\n";
+                        ++checkFailures;
+                    }
+                }
+            }
+        }
+    }
+
+    cout << "Kernels compared with portable:";
+    for (size_t s = 1; s < sets.size(); ++s) cout << " " << sets[s];
+    cout << (sets.size() == 1 ? " none\n" : "\n");
+    return CheckResult("ColumnFilterTest");
+}
@@ -0,0 +1,144 @@
+/**
+ * @file DoublewriteTest.cpp
+ * @brief Checks PageFile commits, and recovery from the doublewrite journal
+ *        left by a commit interrupted before or during its in-place writes,
+ *        and that a rebuilt tree file does not inherit a stale journal.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "PageFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static const char* DATA_FILE = "doublewrite_test.dat";
+static const string JOURNAL_FILE = string(DATA_FILE) + ".dwb";
+static const int PAGE = 512;
+
+/// True if @p file exists.
+static bool exists(const string& file)
+{
+    return ifstream(file).is_open();
+}
+
+/// Appends the raw bytes of a value, as PageFile does.
+template <typename T>
+static void putRaw(string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/// A journal as Commit() writes it: pages, file size, FNV-1a hash and end mark.
+static string makeJournal(int64_t fileSize, int64_t offset, const string& page)
+{
+    string journal = "DWB1";
+    putRaw(journal, fileSize);
+    putRaw(journal, static_cast<uint32_t>(1));
+    putRaw(journal, offset);
+    putRaw(journal, static_cast<uint32_t>(page.size()));
+    journal += page;
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (unsigned char c : journal) {
+        h ^= c;
+        h *= 0x100000001B3ULL;
+    }
+    putRaw(journal, h);
+    return journal + "DWBE";
+}
+
+int main()
+{
+    ofstream(DATA_FILE, ios::binary | ios::trunc) << string(4 * PAGE, 'a');
+
+    // A synced commit writes the pages, sets the size and removes its journal
+    {
+        PageFile file;
+        CHECK(file.Open(DATA_FILE));
+        file.Stage(PAGE, string(PAGE, 'b'));
+        CHECK(file.Commit(true, 5 * PAGE));
+    }
+    string data = readAll(DATA_FILE);
+    CHECK(data.size() == 5u * PAGE);
+    CHECK(data.substr(PAGE, PAGE) == string(PAGE, 'b'));
+    CHECK(data.substr(2 * PAGE, PAGE) == string(PAGE, 'a'));
+    CHECK(!exists(JOURNAL_FILE));
+
+    // Crash after the journal was synced: recovery finishes the batch
+    ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << makeJournal(3 * PAGE, 2 * PAGE, string(PAGE, 'c'));
+    CHECK(PageFile::Recover(DATA_FILE));
+    data = readAll(DATA_FILE);
+    CHECK(data.size() == 3u * PAGE);
+    CHECK(data.substr(2 * PAGE, PAGE) == string(PAGE, 'c'));
+    CHECK(!exists(JOURNAL_FILE));
+
+    // Crash while the journal was being written: the file was not touched
+    string torn = makeJournal(PAGE, 0, string(PAGE, 'd'));
+    ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << torn.substr(0, torn.size() - 4);
+    CHECK(PageFile::Recover(DATA_FILE));
+    CHECK(readAll(DATA_FILE) == data);
+    CHECK(!exists(JOURNAL_FILE));
+
+    // A journal whose hash does not match is not applied either
+    string damaged = makeJournal(PAGE, 0, string(PAGE, 'd'));
+    damaged[40] ^= 1;
+    ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << damaged;
+    CHECK(PageFile::Recover(DATA_FILE));
+    CHECK(readAll(DATA_FILE) == data);
+
+    // Opening the file runs recovery first
+    ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << makeJournal(-1, 0, string(PAGE, 'e'));
+    {
+        PageFile file;
+        CHECK(file.Open(DATA_FILE));
+    }
+    CHECK(readAll(DATA_FILE).substr(0, PAGE) == string(PAGE, 'e'));
+    CHECK(!exists(JOURNAL_FILE));
+
+    // A rebuild after a failed in-place commit: the old journal is not replayed over it
+    {
+        BPlusTree tree(DATA_FILE, PAGE);
+        for (uint32_t zip = 10000; zip < 10400; ++zip) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        tree.WriteToFile();
+    }
+    string oldTree = readAll(DATA_FILE);
+    ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << makeJournal(-1, PAGE, oldTree.substr(PAGE, PAGE));
+    {
+        BPlusTree tree(DATA_FILE, PAGE);
+        for (uint32_t zip = 20000; zip < 20400; ++zip) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();  // written through a temporary file and a rename
+    }
+    CHECK(!exists(JOURNAL_FILE));
+    {
+        BPlusTree tree(DATA_FILE, PAGE);
+        CHECK(tree.Open());
+        string record;
+        CHECK(tree.Search("20000", record));
+        CHECK(tree.Search("20399", record));
+        CHECK(!tree.Search("10000", record));
+    }
+
+    // The same for the sequence set on its own
+    {
+        BlockedSequenceSet leaves(DATA_FILE, PAGE);
+        leaves.AddRecord(makeRecord(30000));
+        ofstream(JOURNAL_FILE, ios::binary | ios::trunc) << makeJournal(-1, PAGE, string(PAGE, 'f'));
+        leaves.WriteToFile();
+        CHECK(!exists(JOURNAL_FILE));
+    }
+    {
+        BlockedSequenceSet leaves(DATA_FILE, PAGE);
+        CHECK(leaves.ReadFromFile());
+        string record;
+        CHECK(leaves.Search("30000", record));
+    }
+
+    remove(DATA_FILE);
+    remove(JOURNAL_FILE.c_str());
+    remove((string(DATA_FILE) + ".bloom").c_str());
+    return CheckResult("DoublewriteTest");
+}
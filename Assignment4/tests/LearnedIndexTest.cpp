@@ -0,0 +1,127 @@
+/**
+ * @file LearnedIndexTest.cpp
+ * @brief Checks the learned index's error bound and search, its file round
+ *        trip, and BPlusTree lookups through it (single and batched, after
+ *        leaves are reused, and with the model saved and reloaded).
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "LearnedIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* MODEL_FILE = "learned_index_test.learned";
+static const char* TREE_FILE = "learned_index_test.dat";
+static const string TREE_MODEL_FILE = string(TREE_FILE) + ".pgm";
+
+/// Position of the first key >= @p key, or -1 (what findPosition() must return).
+static int expectedPosition(const vector<uint32_t>& keys, uint32_t key)
+{
+    auto it = lower_bound(keys.begin(), keys.end(), key);
+    return it == keys.end() ? -1 : static_cast<int>(it - keys.begin());
+}
+
+int main()
+{
+    // Uneven gaps, like ZIP codes: runs of close keys with jumps between them
+    vector<uint32_t> keys;
+    uint32_t seed = 12345, key = 500;
+    for (int i = 0; i < 5000; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        key += 1 + (seed >> 16) % ((i / 500) % 2 == 0 ? 8 : 300);
+        keys.push_back(key);
+    }
+
+    for (int eps : {1, 4, 8, 32}) {
+        LearnedIndex model(eps);
+        model.buildIndex(keys);
+        CHECK(model.GetSegmentCount() > 0 && model.GetSegmentCount() < static_cast<int>(keys.size()) / 2);
+
+        int worst = 0;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            worst = max(worst, abs(model.predict(keys[i]) - static_cast<int>(i)));
+        }
+        CHECK(worst <= eps);
+
+        for (uint32_t probe = 0; probe <= keys.back() + 10; probe += 7) {
+            CHECK(model.findPosition(probe, keys) == expectedPosition(keys, probe));
+        }
+    }
+
+    // The model survives a round trip, and stays correct (if slower) on keys
+    // that changed after it was built
+    LearnedIndex model(8);
+    model.buildIndex(keys);
+    CHECK(model.writeToFile(MODEL_FILE));
+    LearnedIndex loaded;
+    CHECK(loaded.readFromFile(MODEL_FILE));
+    CHECK(loaded.GetSegmentCount() == model.GetSegmentCount());
+    for (size_t i = 0; i < keys.size(); i += 13) CHECK(loaded.predict(keys[i]) == model.predict(keys[i]));
+    vector<uint32_t> shifted(keys.begin() + 100, keys.end());
+    for (uint32_t probe = 0; probe <= keys.back() + 10; probe += 11) {
+        CHECK(loaded.findPosition(probe, shifted) == expectedPosition(shifted, probe));
+    }
+    CHECK(LearnedIndex().findPosition(5, vector<uint32_t>()) == -1);
+    CHECK(loaded.fits(keys));
+    CHECK(!loaded.fits(shifted));
+
+    // With the model on and off, Search and SearchBatch agree; freed leaves
+    // are reused by later splits, so chain order differs from RBN order
+    for (bool learned : {false, true}) {
+        remove(TREE_MODEL_FILE.c_str());
+        BPlusTree tree(TREE_FILE, 512);
+        tree.SetLearnedIndex(learned);
+        for (uint32_t zip = 10000; zip < 16000; zip += 2) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        for (uint32_t zip = 10000; zip < 11000; zip += 2) CHECK(tree.Delete(to_string(zip)));
+        for (uint32_t zip = 14001; zip < 16000; zip += 2) tree.Insert(makeRecord(zip));
+        CHECK(tree.GetSequenceSet().GetFreeBlockCount() == 0);
+
+        string record;
+        for (uint32_t zip = 9000; zip < 16500; ++zip) {
+            bool stored = zip >= 11000 && zip < 16000 && (zip % 2 == 0 || zip > 14000);
+            CHECK(tree.Search(to_string(zip), record) == stored);
+        }
+
+        vector<uint32_t> probes;
+        for (uint32_t zip = 9000; zip < 16500; zip += 3) probes.push_back(zip);
+        vector<string> records;
+        vector<char> found;
+        tree.SearchBatch(probes, records, found);
+        for (size_t i = 0; i < probes.size(); ++i) {
+            CHECK(static_cast<bool>(found[i]) == tree.Search(to_string(probes[i]), record));
+        }
+        tree.WriteToFile();
+        CHECK(ifstream(TREE_MODEL_FILE).is_open() == learned);
+    }
+
+    // Open() loads the saved model, and retrains one that no longer fits
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        tree.SetLearnedIndex(true);
+        CHECK(tree.Open());
+        string record;
+        CHECK(tree.Search("12000", record));
+        CHECK(!tree.Search("12001", record));
+    }
+    ofstream(TREE_MODEL_FILE, ios::trunc) << "8,3,1\n0,0,0\n";
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        tree.SetLearnedIndex(true);
+        CHECK(tree.Open());
+        string record;
+        for (uint32_t zip = 11000; zip < 16000; zip += 2) CHECK(tree.Search(to_string(zip), record));
+    }
+
+    remove(MODEL_FILE);
+    remove(TREE_MODEL_FILE.c_str());
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("LearnedIndexTest");
+}
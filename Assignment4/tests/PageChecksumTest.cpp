@@ -0,0 +1,90 @@
+/**
+ * @file PageChecksumTest.cpp
+ * @brief Checks the CRC-32C function against known values, and that damage
+ *        to a page or to the header is caught by readers and the scrubber.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "Crc32c.h"
+#include "PageScrubber.h"
+#include "TreeFileReader.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+using namespace std;
+
+static const char* TREE_FILE = "page_checksum_test.dat";
+static const int PAGE = 512;
+
+/// Overwrites one byte of @p file.
+static void poke(const char* file, long offset, char value)
+{
+    fstream f(file, ios::in | ios::out | ios::binary);
+    f.seekp(offset);
+    f.put(value);
+}
+
+int main()
+{
+    // Check values from RFC 3720 (iSCSI), whichever implementation is in use
+    const char* digits = "123456789";
+    CHECK(Crc32c(digits, strlen(digits)) == 0xE3069283u);
+    string zeros(32, '\0');
+    CHECK(Crc32c(zeros.data(), zeros.size()) == 0x8A9136AAu);
+    CHECK(Crc32c(digits + 4, 5, Crc32c(digits, 4)) == 0xE3069283u);  // chained
+
+    {
+        BPlusTree tree(TREE_FILE, PAGE);
+        for (uint32_t zip = 1000; zip < 3000; ++zip) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+    }
+    {
+        PageScrubber scrubber(TREE_FILE);
+        CHECK(scrubber.ScrubOnce());
+        CHECK(scrubber.GetCorruptPages().empty());
+        CHECK(scrubber.GetPagesChecked() > 0);
+    }
+
+    // One changed byte in block 7 fails the read and is reported by the scrubber
+    poke(TREE_FILE, (7 + 1) * PAGE + 100, '#');
+    {
+        BlockedSequenceSet leaves(TREE_FILE);
+        CHECK(!leaves.ReadFromFile());
+        PageScrubber scrubber(TREE_FILE);
+        CHECK(!scrubber.ScrubOnce());
+        vector<int> corrupt = scrubber.GetCorruptPages();
+        CHECK(corrupt.size() == 1 && corrupt[0] == 7);
+
+        // A batch that reads block 7 fails without leaving reads for the next batch
+        TreeFileReader reader(8);
+        CHECK(reader.Open(TREE_FILE));
+        vector<uint32_t> keys;
+        for (uint32_t zip = 1000; zip < 3000; zip += 5) keys.push_back(zip);
+        vector<string> records;
+        vector<char> found;
+        CHECK(!reader.SearchBatch(keys, records, found));
+        CHECK(reader.GetReader().InFlight() == 0);
+        CHECK(reader.SearchBatch({2500, 2995}, records, found));
+        CHECK(found[0] && found[1] && records[0] == makeRecord(2500));
+    }
+
+    // Damage to the superblock is reported as page -1 and stops every reader
+    poke(TREE_FILE, 13, 9);
+    {
+        BlockedSequenceSet leaves(TREE_FILE);
+        CHECK(!leaves.ReadFromFile());
+        TreeFileReader reader;
+        CHECK(!reader.Open(TREE_FILE));
+        PageScrubber scrubber(TREE_FILE);
+        CHECK(!scrubber.ScrubOnce());
+        vector<int> corrupt = scrubber.GetCorruptPages();
+        CHECK(!corrupt.empty() && corrupt[0] == -1);
+    }
+
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("PageChecksumTest");
+}
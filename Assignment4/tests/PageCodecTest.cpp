@@ -0,0 +1,103 @@
+/**
+ * @file PageCodecTest.cpp
+ * @brief Checks the PageCodec round trip, and that truncated or corrupt
+ *        streams are rejected instead of read past their bounds.
+ */
+
+#include "TestCheck.h"
+#include "PageCodec.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Returns true if @p text compresses and expands back to itself.
+static bool roundTrips(const string& text)
+{
+    string packed, back;
+    PageCodec::Compress(text, packed);
+    return PageCodec::Decompress(packed.data(), packed.size(), back, text.size()) && back == text;
+}
+
+/// Expands a hand-written stream with room for @p maxOutput bytes.
+static bool expands(const vector<unsigned char>& stream, size_t maxOutput = 1024)
+{
+    string out;
+    return PageCodec::Decompress(reinterpret_cast<const char*>(stream.data()), stream.size(), out, maxOutput);
+}
+
+int main()
+{
+    // A leaf body of real-looking records compresses and round trips
+    string page;
+    for (uint32_t zip = 56301; zip < 56341; ++zip) page += makeRecord(zip) + "\n";
+    string packed;
+    PageCodec::Compress(page, packed);
+    CHECK(packed.size() < page.size());
+    CHECK(roundTrips(page));
+
+    // Short inputs, inputs without matches, and long runs whose matches
+    // overlap their own output and need extra length bytes
+    mt19937 rng(331);
+    string noise(3000, '\0');
+    for (char& c : noise) c = static_cast<char>(rng());
+    CHECK(roundTrips(""));
+    CHECK(roundTrips("a"));
+    CHECK(roundTrips("abc"));
+    CHECK(roundTrips("abcd"));
+    CHECK(roundTrips(noise));
+    CHECK(roundTrips(string(5000, 'x')));
+    CHECK(roundTrips(string(20, 'y') + noise.substr(0, 300) + string(600, 'y')));
+
+    // The expanded size is bounded by maxOutput
+    string back;
+    PageCodec::Compress(page, packed);
+    CHECK(!PageCodec::Decompress(packed.data(), packed.size(), back, page.size() - 1));
+    PageCodec::Compress(noise, packed);
+    CHECK(!PageCodec::Decompress(packed.data(), packed.size(), back, noise.size() - 1));
+
+    // Hand-written streams: "AAAA", a 4-byte match at offset 1, then an
+    // empty literals-only sequence is valid; without that last one it is not
+    CHECK(expands({0x40, 'A', 'A', 'A', 'A', 0x01, 0x00, 0x00}));
+    CHECK(!expands({0x40, 'A', 'A', 'A', 'A', 0x01, 0x00}));
+    // Match offset 0
+    CHECK(!expands({0x40, 'A', 'A', 'A', 'A', 0x00, 0x00, 0x00}));
+    // Match offset past the output produced so far
+    CHECK(!expands({0x40, 'A', 'A', 'A', 'A', 0x05, 0x00, 0x00}));
+    CHECK(!expands({0x00, 0x01, 0x00, 0x00}));
+    // Offset cut short after the literals
+    CHECK(!expands({0x40, 'A', 'A', 'A', 'A', 0x01}));
+    // Literal length field that never ends, or claims more bytes than follow
+    CHECK(!expands({0xF0, 255, 255, 255}));
+    CHECK(!expands({0xF0, 255, 255, 0, 'A', 'B'}));
+    // Match length bytes that run off the end, or past maxOutput
+    CHECK(!expands({0x4F, 'A', 'A', 'A', 'A', 0x01, 0x00, 255}));
+    CHECK(!expands({0x4F, 'A', 'A', 'A', 'A', 0x01, 0x00, 255, 255, 255, 255, 10, 0x00}, 1024));
+    CHECK(expands({0x4F, 'A', 'A', 'A', 'A', 0x01, 0x00, 255, 255, 255, 255, 10, 0x00}, 1053));
+
+    // Every truncation of a real stream either fails or yields a strict prefix
+    PageCodec::Compress(page, packed);
+    bool prefixesOk = true;
+    for (size_t cut = 1; cut < packed.size(); ++cut) {
+        string part;
+        if (PageCodec::Decompress(packed.data(), cut, part, page.size())) {
+            prefixesOk = prefixesOk && part.size() < page.size() && page.compare(0, part.size(), part) == 0;
+        }
+    }
+    CHECK(prefixesOk);
+
+    // Corrupted bytes never expand beyond maxOutput
+    bool bounded = true;
+    for (int trial = 0; trial < 2000; ++trial) {
+        string bad = packed;
+        bad[rng() % bad.size()] = static_cast<char>(rng());
+        bad[rng() % bad.size()] = static_cast<char>(rng());
+        string out;
+        if (PageCodec::Decompress(bad.data(), bad.size(), out, page.size())) bounded = bounded && out.size() <= page.size();
+    }
+    CHECK(bounded);
+
+    return CheckResult("PageCodecTest");
+}
@@ -0,0 +1,111 @@
+/**
+ * @file PageEncodingTest.cpp
+ * @brief Checks the delta and front-coded record encoding: single records,
+ *        whole pages written and read back, and a tree of 10-digit keys.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* TREE_FILE = "page_encoding_test.dat";
+
+/// Returns true if every record encodes against the one before it and
+/// decodes back to itself.
+static bool roundTrips(const vector<string>& records)
+{
+    const string* prev = nullptr;
+    for (const string& rec : records) {
+        if (Block::DecodeRecord(Block::EncodeRecord(rec, prev), prev) != rec) {
+            cerr << "Record does not round trip: " << rec << "\n";
+            return false;
+        }
+        prev = &rec;
+    }
+    return true;
+}
+
+/// Fills a page with @p records, writes it and reads it back; @p packed
+/// says whether the page should come out LZ-compressed.
+static bool pageRoundTrips(const vector<string>& records, int pageSize, PageCodecType codec, bool packed)
+{
+    Block page(3, pageSize, codec);
+    for (const string& rec : records) {
+        if (!page.AddRecord(rec)) return false;
+    }
+    if (!page.FitsPage()) return false;
+
+    string bytes = page.Serialize();
+    if ((bytes.find(" ZLEN=") != string::npos) != packed) return false;
+    istringstream in(bytes);
+    Block back;
+    if (!back.Read(in, pageSize, codec)) return false;
+    return back.GetRBN() == 3 && back.getRecords() == page.getRecords() && back.GetKeys() == page.GetKeys();
+}
+
+int main()
+{
+    // Key deltas, repeated fields and shared prefixes all come back
+    CHECK(roundTrips({makeRecord(56301), makeRecord(56302), makeRecord(56399), makeRecord(57000)}));
+    string first = makeRecord(56301);
+    string encoded = Block::EncodeRecord(makeRecord(56302), &first);
+    CHECK(encoded.size() < makeRecord(56302).size());
+    CHECK(encoded.compare(0, 2, "1,") == 0);
+
+    // 10-digit keys, up to UINT32_MAX, and the jump from 5 to 10 digits
+    CHECK(roundTrips({makeRecord(99999), makeRecord(1000000000), makeRecord(1000000001),
+                      makeRecord(4294967294u), makeRecord(4294967295u)}));
+    string low = makeRecord(1000000000);
+    CHECK(Block::EncodeRecord(makeRecord(4294967295u), &low).compare(0, 11, "3294967295,") == 0);
+
+    // Keys stored verbatim: leading zeros and keys below the previous one
+    CHECK(roundTrips({"00501,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                      "00544,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                      "501,Holtsville,NY,Suffolk,40.8154,-73.0451",
+                      "400,Holtsville,NY,Suffolk,40.8154,-73.0451"}));
+
+    // Fields that look like the encoding's own markers, empty fields, and
+    // records with more or fewer fields than the one before
+    CHECK(roundTrips({"10,=,+4|x,,Stearns", "11,=,+4|x,,Stearns", "12,+,==,+0|,Stearns,extra,field",
+                      "13,+,==", "14,Saint Cloud,MN", "15,Saint Cloudy,MN,,", "16,Saint,MN,,,"}));
+
+    // Whole pages: plain 4 KB pages, and 512-byte pages only LZ can hold
+    vector<string> zips, wide;
+    for (uint32_t zip = 56301; zip < 56341; ++zip) zips.push_back(makeRecord(zip));
+    for (uint32_t zip = 4294967200u; zip < 4294967240u; ++zip) wide.push_back(makeRecord(zip));
+    CHECK(pageRoundTrips(zips, 4096, CODEC_NONE, false));
+    CHECK(pageRoundTrips(wide, 4096, CODEC_NONE, false));
+    CHECK(pageRoundTrips(zips, 512, CODEC_LZ, true));
+    CHECK(pageRoundTrips(wide, 512, CODEC_LZ, true));
+
+    // A tree over 10-digit keys: the separators between its leaves are
+    // shortened, and lookups still land on the right leaf after a reopen
+    vector<uint32_t> keys;
+    for (uint32_t i = 0; i < 400; ++i) keys.push_back(1000000000u + i * 7919u);
+    keys.push_back(4294967295u);
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip : keys) CHECK(tree.Insert(makeRecord(zip)));
+        tree.BuildStaticIndex();
+    }
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        string record;
+        bool found = true;
+        for (uint32_t zip : keys) found = found && tree.Search(to_string(zip), record) && record == makeRecord(zip);
+        CHECK(found);
+        CHECK(!tree.Search("1000000001", record));
+        CHECK(!tree.Search("4294967294", record));
+    }
+
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    remove((string(TREE_FILE) + ".wal").c_str());
+    return CheckResult("PageEncodingTest");
+}
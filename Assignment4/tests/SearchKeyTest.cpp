@@ -0,0 +1,95 @@
+/**
+ * @file SearchKeyTest.cpp
+ * @brief Checks that BPlusTree::Search, Delete, Insert and BulkLoad accept
+ *        only plain 32-bit ZIP strings.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* TREE_FILE = "search_key_test.dat";
+
+int main()
+{
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        tree.Insert("90210,Beverly Hills,CA,Los Angeles,34.090000,-118.410000");
+        tree.Insert("5,Test,MN,Stearns,45.500000,-94.100000");
+        tree.BuildStaticIndex();
+
+        string record;
+        CHECK(tree.Search("90210", record) && record.compare(0, 6, "90210,") == 0);
+        CHECK(tree.Search("5", record));
+        CHECK(tree.Search("00005", record));
+        CHECK(!tree.Search("4295057506", record));   // 2^32 + 90210 must not wrap to 90210
+        CHECK(!tree.Search("-5", record));
+        CHECK(!tree.Search("+5", record));
+        CHECK(!tree.Search(" 5", record));
+        CHECK(!tree.Search("5 ", record));
+        CHECK(!tree.Search("", record));
+        CHECK(!tree.Search("99999999999999999999999", record));
+
+        // Delete rejects the same keys instead of removing some other ZIP
+        tree.Insert("0,Zero,MN,Stearns,45.500000,-94.100000");
+        CHECK(!tree.Delete("4295057506"));
+        CHECK(!tree.Delete("abc"));
+        CHECK(!tree.Delete("-5"));
+        CHECK(!tree.Delete("5 "));
+        CHECK(!tree.Delete(""));
+        CHECK(tree.Search("90210", record));
+        CHECK(tree.Search("5", record));
+        CHECK(tree.Search("0", record));
+        CHECK(tree.Delete("00005"));
+        CHECK(!tree.Search("5", record));
+    }
+
+    // Insert and BulkLoad refuse records whose ZIP would be read as another one
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        tree.Insert("90210,Beverly Hills,CA,Los Angeles,34.090000,-118.410000");
+        tree.BuildStaticIndex();
+        CHECK(!tree.Insert("4295057506,Wrapped,CA,Los Angeles,34.090000,-118.410000"));
+        CHECK(!tree.Insert("abc,Letters,MN,Stearns,45.500000,-94.100000"));
+        CHECK(!tree.Insert(",Empty,MN,Stearns,45.500000,-94.100000"));
+        CHECK(!tree.Insert("-5,Negative,MN,Stearns,45.500000,-94.100000"));
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 1);
+        string record;
+        CHECK(tree.Search("90210", record) && record.find("Beverly Hills") != string::npos);
+        CHECK(!tree.Search("0", record));
+
+        vector<string> source = {"501,Holtsville,NY,Suffolk,40.810000,-73.040000",
+                                 "4295057506,Wrapped,CA,Los Angeles,34.090000,-118.410000",
+                                 "x1,Bad,MN,Stearns,45.500000,-94.100000",
+                                 "90210,Beverly Hills,CA,Los Angeles,34.090000,-118.410000"};
+        size_t next = 0;
+        CHECK(!tree.BulkLoad([&](string& rec) {
+            if (next == source.size()) return false;
+            rec = source[next++];
+            return true;
+        }));
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 2);
+        CHECK(tree.Search("90210", record) && record.find("Beverly Hills") != string::npos);
+        CHECK(tree.Search("501", record));
+    }
+
+    // The sequence set on its own validates the key too
+    {
+        BlockedSequenceSet leaves(TREE_FILE, 512);
+        leaves.AddRecord("0,Zero,MN,Stearns,45.500000,-94.100000");
+        leaves.AddRecord("90210,Beverly Hills,CA,Los Angeles,34.090000,-118.410000");
+        CHECK(!leaves.Delete("4295057506"));
+        CHECK(!leaves.Delete("abc"));
+        CHECK(!leaves.Delete(""));
+        CHECK(leaves.GetTotalRecords() == 2);
+        CHECK(leaves.Delete("90210"));
+        CHECK(leaves.GetTotalRecords() == 1);
+    }
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("SearchKeyTest");
+}
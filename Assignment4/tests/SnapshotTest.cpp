@@ -0,0 +1,78 @@
+/**
+ * @file SnapshotTest.cpp
+ * @brief Checks that a TreeSnapshot stays exactly as taken while the tree
+ *        inserts, splits leaves, deletes and frees blocks.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const char* TREE_FILE = "snapshot_test.dat";
+
+/// Every page of @p view, as it would be written.
+static vector<string> pageImages(const TreeSnapshot& view)
+{
+    vector<string> pages;
+    for (const auto& leaf : view.GetLeaves()) pages.push_back(leaf->Serialize());
+    return pages;
+}
+
+int main()
+{
+    BPlusTree tree(TREE_FILE, 512);
+    for (uint32_t zip = 56000; zip < 56400; zip += 2) tree.Insert(makeRecord(zip));
+    tree.BuildStaticIndex();
+
+    TreeSnapshot view = tree.Snapshot();
+    const vector<string> before = pageImages(view);
+    const int count = view.GetRecordCount();
+    vector<string> inState;
+    view.SearchByState("MN", inState);
+    CHECK(count == 200);
+    CHECK(inState.size() == 200);
+    CHECK(view.IsKeyOrdered());
+
+    // Odd keys land in every leaf and split them
+    BlockedSequenceSet& leaves = tree.GetSequenceSet();
+    int blocksBefore = leaves.GetTotalBlocks();
+    for (uint32_t zip = 56001; zip < 56400; zip += 2) CHECK(tree.Insert(makeRecord(zip)));
+    CHECK(leaves.GetTotalBlocks() > blocksBefore);
+
+    // Emptying the first leaves frees them onto the avail list, and the next
+    // inserts take the freed blocks back
+    for (uint32_t zip = 56000; zip < 56100; ++zip) CHECK(tree.Delete(to_string(zip)));
+    CHECK(leaves.GetFreeBlockCount() > 0);
+    for (uint32_t zip = 57000; zip < 57100; ++zip) CHECK(tree.Insert(makeRecord(zip)));
+
+    // The snapshot still holds the very same pages, records and lookups
+    CHECK(pageImages(view) == before);
+    CHECK(view.GetRecordCount() == count);
+    vector<string> again;
+    view.SearchByState("MN", again);
+    CHECK(again == inState);
+    string record;
+    bool allThere = true;
+    for (uint32_t zip = 56000; zip < 56400; zip += 2) {
+        allThere = allThere && view.Search(zip, record) && record == makeRecord(zip);
+    }
+    CHECK(allThere);
+    CHECK(!view.Search(56001, record));
+    CHECK(!view.Search(57000, record));
+
+    // A new snapshot sees the changes; the old one is unaffected by it
+    TreeSnapshot now = tree.Snapshot();
+    CHECK(now.GetRecordCount() == 400 - 100 + 100);
+    CHECK(now.Search(56001 + 100, record));
+    CHECK(!now.Search(56000, record));
+    CHECK(now.Search(57000, record));
+    CHECK(pageImages(view) == before);
+
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("SnapshotTest");
+}
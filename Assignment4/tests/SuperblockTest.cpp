@@ -0,0 +1,123 @@
+/**
+ * @file SuperblockTest.cpp
+ * @brief Checks the superblock round trip, and that a reopened tree takes its
+ *        root, height and leaf chain ends from it.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include "HeaderRecord.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static const char* HEADER_FILE = "superblock_test.hdr";
+static const char* TREE_FILE = "superblock_test.dat";
+
+/// Reads the superblock of @p file (record count -1 if it is rejected).
+static HeaderRecord readHeader(const char* file)
+{
+    ifstream in(file, ios::binary);
+    HeaderRecord header;
+    if (!header.Read(in)) header.SetRecordCount(-1);
+    return header;
+}
+
+/// Overwrites the superblock at the start of @p file.
+static void writeHeader(const char* file, const HeaderRecord& header)
+{
+    ostringstream bytes;
+    header.Write(bytes);
+    fstream f(file, ios::in | ios::out | ios::binary);
+    f.write(bytes.str().data(), static_cast<streamsize>(bytes.str().size()));
+}
+
+int main()
+{
+    // Every field survives a write and read
+    HeaderRecord written(1024);
+    written.SetRecordCount(4321);
+    written.SetCodec(CODEC_LZ);
+    written.SetCheckpointLSN(0x123456789ULL);
+    written.SetPageChecksums(true);
+    written.SetRoot(77, 3);
+    written.SetLeafChain(5, 70);
+    written.SetAvailHead(12);
+    {
+        ofstream out(HEADER_FILE, ios::binary | ios::trunc);
+        CHECK(written.Write(out));
+    }
+    HeaderRecord read = readHeader(HEADER_FILE);
+    CHECK(read.GetVersion() == HeaderRecord::SUPERBLOCK_VERSION);
+    CHECK(read.GetBlockSize() == 1024);
+    CHECK(read.GetRecordCount() == 4321);
+    CHECK(read.GetCodec() == CODEC_LZ);
+    CHECK(read.GetCheckpointLSN() == 0x123456789ULL);
+    CHECK(read.HasPageChecksums());
+    CHECK(read.GetRootRBN() == 77 && read.GetTreeHeight() == 3);
+    CHECK(read.GetHeadRBN() == 5 && read.GetTailRBN() == 70);
+    CHECK(read.GetAvailHead() == 12);
+
+    // A flipped bit fails the superblock's CRC
+    {
+        fstream f(HEADER_FILE, ios::in | ios::out | ios::binary);
+        f.seekp(13);
+        f.put('\x7f');
+    }
+    CHECK(readHeader(HEADER_FILE).GetRecordCount() == -1);
+
+    // Emptying the first leaf frees it, so the head is no longer RBN 0
+    vector<uint32_t> removed;
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip = 1000; zip < 4000; ++zip) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        removed = tree.GetSequenceSet().GetBlock(tree.GetSequenceSet().GetHeadRBN()).GetKeys();
+        for (uint32_t zip : removed) CHECK(tree.Delete(to_string(zip)));
+        tree.WriteToFile();
+    }
+    HeaderRecord header = readHeader(TREE_FILE);
+    CHECK(header.GetHeadRBN() > 0);
+    CHECK(header.GetAvailHead() == 0);
+    CHECK(header.GetTreeHeight() > 1);
+    {
+        BlockedSequenceSet leaves(TREE_FILE);
+        vector<Block> indexPages;
+        CHECK(leaves.ReadFromFile(&indexPages));
+        CHECK(leaves.GetHeadRBN() == header.GetHeadRBN());
+        CHECK(leaves.GetTailRBN() == header.GetTailRBN());
+        CHECK(!indexPages.empty() && indexPages.front().GetRBN() == leaves.GetTotalBlocks());
+    }
+
+    // The reopened tree has the stored height and finds what it should
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        CHECK(tree.GetTreeHeight() == header.GetTreeHeight());
+        string record;
+        for (uint32_t zip = removed.back() + 1; zip < 4000; ++zip) CHECK(tree.Search(to_string(zip), record));
+        for (uint32_t zip : removed) CHECK(!tree.Search(to_string(zip), record));
+    }
+
+    // A root that does not lead to the leaves is ignored: the index is rebuilt
+    HeaderRecord broken = header;
+    broken.SetRoot(header.GetHeadRBN(), header.GetTreeHeight());
+    broken.SetLeafChain(header.GetTailRBN(), header.GetHeadRBN());
+    writeHeader(TREE_FILE, broken);
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        CHECK(tree.GetTreeHeight() == header.GetTreeHeight());
+        CHECK(tree.GetSequenceSet().GetHeadRBN() == header.GetHeadRBN());
+        string record;
+        for (uint32_t zip = removed.back() + 1; zip < 4000; ++zip) CHECK(tree.Search(to_string(zip), record));
+    }
+
+    remove(HEADER_FILE);
+    remove(TREE_FILE);
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("SuperblockTest");
+}
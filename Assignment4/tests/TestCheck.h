@@ -0,0 +1,55 @@
+/**
+ * @file TestCheck.h
+ * @brief The CHECK macro, result line and record/file helpers shared by the
+ *        test drivers in tests/.
+ *
+ * Each driver is a small program run by "make check". It prints one line per
+ * failed check and exits non-zero if any check failed.
+ */
+
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+static int checkFailures = 0;  ///< Failed checks so far in this driver
+
+/// Records a failed condition with its source line and carries on.
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n";  \
+            ++checkFailures;                                                            \
+        }                                                                               \
+    } while (0)
+
+/**
+ * @brief Prints the driver's result and returns its exit status.
+ *
+ * @param name Name of the driver
+ * @return 0 if every check passed, 1 otherwise
+ */
+static int CheckResult(const char* name)
+{
+    std::cout << name << ": " << (checkFailures == 0 ? "passed" : "FAILED") << "\n";
+    return checkFailures == 0 ? 0 : 1;
+}
+
+/// A record in the assignment's CSV layout for ZIP @p zip.
+inline std::string makeRecord(uint32_t zip)
+{
+    return std::to_string(zip) + ",Town" + std::to_string(zip) + ",MN,Stearns,45.500000,-94.100000";
+}
+
+/// Contents of @p file (empty if it cannot be opened).
+inline std::string readAll(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+#endif // TESTCHECK_H
@@ -0,0 +1,71 @@
+/**
+ * @file ThreadPoolTest.cpp
+ * @brief Checks that nested waits finish, and that a throwing ParallelFor
+ *        body stops the loop on every thread and rethrows.
+ */
+
+#include "TestCheck.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main()
+{
+    ThreadPool pool(4);
+
+    // Tasks that wait for their own subtasks do not deadlock the pool
+    vector<future<size_t>> outer;
+    for (size_t i = 0; i < 16; ++i) {
+        outer.push_back(pool.Submit([&pool, i] {
+            vector<future<size_t>> inner;
+            for (size_t j = 0; j < 8; ++j) inner.push_back(pool.Submit([i, j] { return i * j; }));
+            size_t sum = 0;
+            for (auto& part : inner) sum += pool.Wait(part);
+            return sum;
+        }));
+    }
+    for (size_t i = 0; i < outer.size(); ++i) CHECK(pool.Wait(outer[i]) == i * 28);
+
+    // Nested ParallelFor covers every index once
+    vector<atomic<int>> seen(4096);
+    pool.ParallelFor(0, 64, 1, [&](size_t lo, size_t hi) {
+        for (size_t row = lo; row < hi; ++row) {
+            pool.ParallelFor(row * 64, row * 64 + 64, 8, [&](size_t a, size_t b) {
+                for (size_t k = a; k < b; ++k) seen[k].fetch_add(1);
+            });
+        }
+    });
+    bool once = true;
+    for (auto& count : seen) once = once && count.load() == 1;
+    CHECK(once);
+
+    // A throw in any chunk, on a helper or the caller, stops the others
+    // taking chunks, then rethrows
+    for (size_t failing = 0; failing < 5; ++failing) {
+        atomic<size_t> started(0);
+        bool thrown = false;
+        try {
+            pool.ParallelFor(0, 20, 1, [&](size_t lo, size_t) {
+                started.fetch_add(1);
+                if (lo == failing) throw runtime_error("failing chunk");
+                this_thread::sleep_for(chrono::milliseconds(20));
+            });
+        } catch (const runtime_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(started.load() < 20);
+    }
+
+    // The pool is still usable afterwards
+    future<int> answer = pool.Submit([] { return 6 * 7; });
+    CHECK(pool.Wait(answer) == 42);
+
+    return CheckResult("ThreadPoolTest");
+}
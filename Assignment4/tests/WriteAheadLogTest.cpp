@@ -0,0 +1,139 @@
+/**
+ * @file WriteAheadLogTest.cpp
+ * @brief Checks redo recovery: logged changes that never reached the block
+ *        file are replayed, a torn last record is dropped, and records at or
+ *        below the file's checkpoint LSN are not applied twice. A log that
+ *        cannot be written is reported until a checkpoint restarts it.
+ */
+
+#include "TestCheck.h"
+#include "BPlusTree.h"
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+static const char* TREE_FILE = "wal_test.dat";
+static const string LOG_FILE = string(TREE_FILE) + ".wal";
+
+int main()
+{
+    remove(LOG_FILE.c_str());
+
+    // Changes logged after the build are lost from memory, then recovered
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        for (uint32_t zip = 1000; zip < 3000; zip += 2) tree.Insert(makeRecord(zip));
+        tree.BuildStaticIndex();
+        CHECK(tree.EnableLog(8, 1000000));
+        for (uint32_t zip = 1001; zip < 3000; zip += 2) tree.Insert(makeRecord(zip));
+        for (uint32_t zip = 1000; zip < 1200; ++zip) CHECK(tree.Delete(to_string(zip)));
+        CHECK(tree.Sync());
+    }  // no checkpoint: the block file still holds the built tree
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 1800);
+        string record;
+        CHECK(!tree.Search("1100", record));
+        CHECK(tree.Search("1201", record) && record == makeRecord(1201));
+        CHECK(tree.Search("2999", record));
+    }
+
+    // A torn last record is dropped, and the log is cut back to the last whole one
+    string whole = readAll(LOG_FILE);
+    {
+        ofstream log(LOG_FILE, ios::binary | ios::app);
+        log << "999999 I 80 5000,Torn";
+    }
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        string record;
+        CHECK(!tree.Search("5000", record));
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 1800);
+    }
+    CHECK(readAll(LOG_FILE) == whole);
+
+    // After a checkpoint the file's LSN covers the old log: replaying it again
+    // must not insert its records a second time
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        tree.WriteToFile();
+        CHECK(readAll(LOG_FILE).empty());
+    }
+    ofstream(LOG_FILE, ios::binary | ios::trunc) << whole;
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 1800);
+
+        // Logging continues in the recovered log
+        tree.Insert(makeRecord(7000));
+        CHECK(tree.Sync());
+    }
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        string record;
+        CHECK(tree.Search("7000", record));
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == 1801);
+    }
+
+#ifndef _WIN32
+    // A log write that fails (here: past the file size limit) is reported by
+    // Insert, Delete and Sync, and a checkpoint makes the changes durable again
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open(1));
+        signal(SIGXFSZ, SIG_IGN);
+        rlimit saved;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        rlimit small = saved;
+        small.rlim_cur = 200;
+        setrlimit(RLIMIT_FSIZE, &small);
+        // A change that is not logged is not applied either
+        int records = tree.GetSequenceSet().GetTotalRecords();
+        vector<uint32_t> rejected;
+        string record;
+        for (uint32_t zip = 8000; zip < 8010; ++zip) {
+            bool stored = tree.Insert(makeRecord(zip));
+            if (!stored) rejected.push_back(zip);
+            CHECK(tree.Search(to_string(zip), record) == stored);
+        }
+        CHECK(!rejected.empty());
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == records + 10 - static_cast<int>(rejected.size()));
+        CHECK(!tree.Delete("1201"));
+        CHECK(tree.Search("1201", record));
+        CHECK(!tree.Sync());
+        setrlimit(RLIMIT_FSIZE, &saved);
+        CHECK(!tree.Sync());
+        tree.WriteToFile();
+        CHECK(tree.Sync());
+
+        // Retrying stores each record once
+        for (uint32_t zip : rejected) CHECK(tree.Insert(makeRecord(zip)));
+        CHECK(tree.GetSequenceSet().GetTotalRecords() == records + 10);
+        CHECK(tree.Sync());
+    }
+    {
+        BPlusTree tree(TREE_FILE, 512);
+        CHECK(tree.Open());
+        string record;
+        for (uint32_t zip = 8000; zip < 8010; ++zip) CHECK(tree.Search(to_string(zip), record));
+        CHECK(tree.Search("1201", record));
+    }
+#endif
+
+    remove(TREE_FILE);
+    remove(LOG_FILE.c_str());
+    remove((string(TREE_FILE) + ".bloom").c_str());
+    return CheckResult("WriteAheadLogTest");
+}